@@ -0,0 +1,32 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#include "eapp_utils.h"
+#include "edge_idl_eapp.h"
+
+#define BLOCK_SIZE 4096
+
+static unsigned char block[BLOCK_SIZE];
+
+int main(){
+  unsigned long i, len, ret, sum = 0;
+
+  ocall_print_string("Hello from generated stubs", &ret);
+
+  for (i = 0; i < 4; i++) {
+    if (ocall_read_block(i, block, BLOCK_SIZE, &len) || len != BLOCK_SIZE) {
+      ocall_print_string("read_block failed", &ret);
+      EAPP_RETURN(1);
+    }
+    sum += block[0];
+    if (ocall_log_value(sum)) {
+      EAPP_RETURN(1);
+    }
+  }
+
+  if (edge_idl_flush()) {
+    EAPP_RETURN(1);
+  }
+  EAPP_RETURN(0);
+}
@@ -0,0 +1,50 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#include <edge_call.h>
+#include <keystone.h>
+#include "edge_idl_host.h"
+
+/* Handlers for the calls in edge-idl.edge. The wrappers that decode the
+ * shared buffer and check the lengths are generated. */
+unsigned long
+print_string(const char* str) {
+  return printf("Enclave said: \"%s\"\n", str);
+}
+
+unsigned long
+read_block(unsigned long index, void* buf, size_t len) {
+  /* buf is in the shared buffer, the enclave copies it out from there */
+  memset(buf, (int)index + 1, len);
+  return len;
+}
+
+void
+log_value(unsigned long value) {
+  printf("Enclave logged: %lu\n", value);
+}
+
+int
+main(int argc, char** argv) {
+  Keystone::Enclave enclave;
+  Keystone::Params params;
+
+  params.setFreeMemSize(1024 * 1024);
+  params.setUntrustedSize(1024 * 1024);
+
+  enclave.init(argv[1], argv[2], argv[3], params);
+
+  enclave.registerOcallDispatch(incoming_call_dispatch);
+  if (edge_idl_register_ocalls()) {
+    printf("failed to register ocalls\n");
+    return 1;
+  }
+
+  edge_call_init_internals(
+      (uintptr_t)enclave.getSharedBuffer(), enclave.getSharedBufferSize());
+
+  enclave.run();
+
+  return 0;
+}
@@ -0,0 +1,143 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <vector>
+
+#include "host/keystone.h"
+
+using namespace Keystone;
+
+/* Drains the SM trace rings of all harts and prints a merged timeline,
+ * followed by the time each enclave spent stopped in the host. */
+
+#define DRAIN_BATCH 256
+
+struct trace_entry {
+  unsigned int hart;
+  struct sm_trace_event ev;
+};
+
+static const char*
+event_name(uint32_t type) {
+  switch (type) {
+    case SM_TRACE_CREATE:
+      return "create";
+    case SM_TRACE_DESTROY:
+      return "destroy";
+    case SM_TRACE_RUN:
+      return "run";
+    case SM_TRACE_RESUME:
+      return "resume";
+    case SM_TRACE_STOP:
+      return "stop";
+    case SM_TRACE_EXIT:
+      return "exit";
+    case SM_TRACE_PMP_SET:
+      return "pmp_set";
+    case SM_TRACE_PMP_UNSET:
+      return "pmp_unset";
+    case SM_TRACE_IPI:
+      return "ipi";
+    case SM_TRACE_ATTEST:
+      return "attest";
+    case SM_TRACE_CONNECT:
+      return "connect";
+    case SM_TRACE_CLONE:
+      return "clone";
+    default:
+      return "unknown";
+  }
+}
+
+static const char*
+stop_reason(uint64_t request) {
+  switch (request) {
+    case STOP_TIMER_INTERRUPT:
+      return "interrupt";
+    case STOP_EDGE_CALL_HOST:
+      return "edge_call";
+    case STOP_EXIT_ENCLAVE:
+      return "exit";
+    default:
+      return "unknown";
+  }
+}
+
+int
+main(int argc, char** argv) {
+  unsigned int nharts = (argc > 1) ? atoi(argv[1]) : 4;
+  KeystoneDevice device;
+  Params params;
+  std::vector<trace_entry> entries;
+  struct sm_trace_event events[DRAIN_BATCH];
+
+  if (!device.initDevice(params)) {
+    return -1;
+  }
+
+  for (unsigned int hart = 0; hart < nharts; hart++) {
+    size_t count;
+    do {
+      if (device.drainTrace(hart, events, DRAIN_BATCH, &count) !=
+          Error::Success) {
+        fprintf(stderr, "failed to drain hart %u\n", hart);
+        return -1;
+      }
+      for (size_t i = 0; i < count; i++) {
+        entries.push_back({hart, events[i]});
+      }
+    } while (count == DRAIN_BATCH);
+  }
+
+  std::stable_sort(
+      entries.begin(), entries.end(),
+      [](const trace_entry& a, const trace_entry& b) {
+        return a.ev.time < b.ev.time;
+      });
+
+  /* eid -> time of the last stop, and accumulated time stopped */
+  std::map<uint32_t, uint64_t> stopped_at;
+  std::map<uint32_t, uint64_t> stopped_total;
+  std::map<uint32_t, uint64_t> stops;
+
+  uint64_t prev = entries.empty() ? 0 : entries[0].ev.time;
+  printf("%16s %10s %4s %-10s %5s %s\n", "time", "delta", "hart", "event", "eid",
+      "arg");
+  for (auto& e : entries) {
+    printf(
+        "%16lu %+10ld %4u %-10s ", (unsigned long)e.ev.time,
+        (long)(e.ev.time - prev), e.hart, event_name(e.ev.type));
+    if (e.ev.eid == SM_TRACE_NO_EID) {
+      printf("%5s ", "-");
+    } else {
+      printf("%5u ", e.ev.eid);
+    }
+    if (e.ev.type == SM_TRACE_STOP) {
+      printf("%s\n", stop_reason(e.ev.arg));
+    } else {
+      printf("0x%lx\n", (unsigned long)e.ev.arg);
+    }
+    prev = e.ev.time;
+
+    if (e.ev.type == SM_TRACE_STOP) {
+      stopped_at[e.ev.eid] = e.ev.time;
+      stops[e.ev.eid]++;
+    } else if (e.ev.type == SM_TRACE_RESUME && stopped_at.count(e.ev.eid)) {
+      stopped_total[e.ev.eid] += e.ev.time - stopped_at[e.ev.eid];
+      stopped_at.erase(e.ev.eid);
+    }
+  }
+
+  printf("\n%5s %8s %16s\n", "eid", "stops", "time in host");
+  for (auto& s : stops) {
+    printf("%5u %8lu %16lu\n", s.first, (unsigned long)s.second,
+        (unsigned long)stopped_total[s.first]);
+  }
+
+  return 0;
+}
@@ -0,0 +1,111 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#include "edge/edge_call.h"
+#include "host/keystone.h"
+
+/* Runs the workload and the peripheral enclave from one process with an
+ * EnclaveGroup. The peripheral is held back until the workload has
+ * connected to it, as with the flag files of the two-process version, but
+ * the handshake happens in memory. */
+
+#define OCALL_PRINT_STRING 1
+#define OCALL_PRINT_VALUE 2
+#define OCALL_CUSTOM 3
+#define OCALL_WAIT 4
+
+using namespace Keystone;
+
+static EnclaveGroup group;
+static int workload;
+static int peripheral;
+
+void writeToUntrusted(Enclave* enc, unsigned int value) {
+  unsigned int* shared_mem =
+      (unsigned int*)((char*)enc->getSharedBuffer() + 0x2000);  // offset by 8KB
+  *shared_mem = value;
+  printf("Host: Wrote %u to untrusted memory at %p\n", value, shared_mem);
+}
+
+unsigned long print_string(char* str) {
+  return printf("Enclave said: \"%s\"\n", str);
+}
+
+unsigned long print_value(unsigned int value) {
+  return printf("Enclave said: %u\n", value);
+}
+
+void custom(unsigned int command) {
+  Enclave* enc = group.get(workload);
+  if (command == 1) {
+    printf("Host: custom command 1, writing eid of main to untrusted memory\n");
+    writeToUntrusted(enc, (unsigned int)enc->getEid());
+  } else if (command == 2) {
+    printf("Host: custom command 2, writing peripheral eid\n");
+    writeToUntrusted(enc, group.get(peripheral)->getSMeid());
+  } else if (command == 3) {
+    printf("Host: custom command 3, starting peripheral\n");
+    group.start(peripheral);
+  } else {
+    printf("Host: custom received unknown command %u\n", command);
+  }
+}
+
+void wait_seconds(unsigned int value) {
+  printf("Host: wait_seconds called, simulating wait for %u seconds\n", value);
+  sleep(value);
+}
+
+static void initEnclave(
+    Enclave* enclave, const char* eappPath, const char* runtimePath,
+    const char* loaderPath, size_t connectSize) {
+  Params params;
+
+  params.setFreeMemSize(256 * 1024);
+  params.setUntrustedSize(256 * 1024);
+  if (connectSize) {
+    params.setConnectSize(connectSize);
+  }
+
+  enclave->init(eappPath, runtimePath, loaderPath, params);
+  /* served on the enclave's own group thread, which the group binds to
+   * its shared buffer */
+  enclave->registerOcallDispatch(incoming_call_dispatch);
+}
+
+int
+main(int argc, char** argv) {
+  if (argc < 5) {
+    printf("usage: %s <workload-eapp> <peripheral-eapp> <runtime> <loader>\n",
+           argv[0]);
+    return 1;
+  }
+
+  Enclave workloadEnclave;
+  Enclave peripheralEnclave;
+  initEnclave(&workloadEnclave, argv[1], argv[3], argv[4], 8 * 1024);
+  initEnclave(&peripheralEnclave, argv[2], argv[3], argv[4], 0);
+
+  /* handlers are process-wide, registering them once covers both */
+  workloadEnclave.registerOcall<OCALL_PRINT_STRING>(print_string);
+  workloadEnclave.registerOcall<OCALL_PRINT_VALUE>(print_value);
+  workloadEnclave.registerOcall<OCALL_CUSTOM>(custom);
+  workloadEnclave.registerOcall<OCALL_WAIT>(wait_seconds);
+
+  workload   = group.add(&workloadEnclave, 0);
+  peripheral = group.add(&peripheralEnclave, 1);
+
+  writeToUntrusted(&workloadEnclave, 8769420U);
+  group.start(workload);
+
+  Error err = group.wait(workload);
+  /* the workload may have failed before starting the peripheral */
+  group.stop();
+  if (group.waitAll() != Error::Success || err != Error::Success) {
+    printf("Host: enclave group failed\n");
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,111 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#include "keystone.h"
+#include "sm_err.h"
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+
+/* debugfs statistics
+ *
+ *   keystone/alloc          allocation failures and CMA fallbacks
+ *   keystone/enclaves/<id>  one file per live enclave, <id> is the host eid
+ *
+ * Everything here is best effort: if debugfs is missing or a file cannot be
+ * created, the driver works the same, just without the statistics. */
+struct keystone_alloc_stats keystone_alloc_stats;
+
+static struct dentry* keystone_debugfs_root;
+static struct dentry* keystone_debugfs_enclaves;
+
+static int keystone_alloc_show(struct seq_file* m, void* v)
+{
+  struct keystone_alloc_stats* s = &keystone_alloc_stats;
+
+  seq_printf(m, "epm_failures: %d\n", atomic_read(&s->epm_failures));
+  seq_printf(m, "utm_failures: %d\n", atomic_read(&s->utm_failures));
+  seq_printf(m, "sem_failures: %d\n", atomic_read(&s->sem_failures));
+  seq_printf(m, "epm_cma: %d\n", atomic_read(&s->epm_cma));
+  seq_printf(m, "utm_cma: %d\n", atomic_read(&s->utm_cma));
+  return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(keystone_alloc);
+
+static int keystone_enclave_show(struct seq_file* m, void* v)
+{
+  struct enclave* enclave = m->private;
+  struct keystone_enclave_stats* s = &enclave->stats;
+
+  /* not created in the SM yet (before finalize) */
+  if (enclave->eid == KEYSTONE_INVALID_EID)
+    seq_puts(m, "sm_eid: none\n");
+  else
+    seq_printf(m, "sm_eid: %lu\n", enclave->eid);
+  seq_printf(m, "epm_size: %zu\n", enclave->epm ? enclave->epm->size : 0);
+  seq_printf(m, "utm_size: %zu\n", enclave->utm ? enclave->utm->size : 0);
+  seq_printf(m, "sem_size: %zu\n", enclave->sem ? enclave->sem->size : 0);
+  seq_printf(m, "runs: %lld\n", atomic64_read(&s->runs));
+  seq_printf(m, "resumes: %lld\n", atomic64_read(&s->resumes));
+  seq_printf(m, "exits_interrupt: %lld\n", atomic64_read(&s->exits_interrupt));
+  seq_printf(m, "exits_edge_call: %lld\n", atomic64_read(&s->exits_edge_call));
+  seq_printf(m, "exits_done: %lld\n", atomic64_read(&s->exits_done));
+  seq_printf(m, "exits_error: %lld\n", atomic64_read(&s->exits_error));
+  seq_printf(m, "run_ns: %lld\n", atomic64_read(&s->run_ns));
+  return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(keystone_enclave);
+
+void keystone_debugfs_init(void)
+{
+  keystone_debugfs_root = debugfs_create_dir("keystone", NULL);
+  debugfs_create_file("alloc", 0444, keystone_debugfs_root, NULL,
+      &keystone_alloc_fops);
+  keystone_debugfs_enclaves = debugfs_create_dir("enclaves", keystone_debugfs_root);
+}
+
+void keystone_debugfs_exit(void)
+{
+  debugfs_remove_recursive(keystone_debugfs_root);
+}
+
+void keystone_debugfs_add_enclave(struct enclave* enclave, unsigned int ueid)
+{
+  char name[16];
+
+  snprintf(name, sizeof(name), "%u", ueid);
+  enclave->debugfs = debugfs_create_file(name, 0444, keystone_debugfs_enclaves,
+      enclave, &keystone_enclave_fops);
+}
+
+/* Waits for readers of the file to finish, so the enclave can go afterwards */
+void keystone_debugfs_remove_enclave(struct enclave* enclave)
+{
+  debugfs_remove(enclave->debugfs);
+  enclave->debugfs = NULL;
+}
+
+/* Account one sbi_sm_run_enclave()/sbi_sm_resume_enclave() round trip */
+void keystone_stats_account(struct enclave* enclave, bool resume,
+    struct sbiret ret, u64 ns)
+{
+  struct keystone_enclave_stats* s = &enclave->stats;
+
+  atomic64_inc(resume ? &s->resumes : &s->runs);
+  atomic64_add(ns, &s->run_ns);
+
+  switch (ret.error) {
+    case SBI_ERR_SM_ENCLAVE_INTERRUPTED:
+      atomic64_inc(&s->exits_interrupt);
+      break;
+    case SBI_ERR_SM_ENCLAVE_EDGE_CALL_HOST:
+      atomic64_inc(&s->exits_edge_call);
+      break;
+    case SBI_ERR_SM_ENCLAVE_SUCCESS:
+      atomic64_inc(&s->exits_done);
+      break;
+    default:
+      atomic64_inc(&s->exits_error);
+      break;
+  }
+}
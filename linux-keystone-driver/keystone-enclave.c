@@ -41,25 +41,38 @@ int destroy_enclave(struct enclave* enclave)
     sem_destroy(sem);
     kfree(sem);
   }
-  kfree(enclave);
+  /* get_enclave_by_id() may still be looking at it under RCU */
+  kfree_rcu(enclave, rcu);
   return 0;
 }
 
+static void enclave_release(struct kref* ref)
+{
+  destroy_enclave(container_of(ref, struct enclave, ref));
+}
+
 struct enclave* create_enclave(unsigned long min_pages)
 {
   struct enclave* enclave;
 
-  enclave = kmalloc(sizeof(struct enclave), GFP_KERNEL);
+  /* zeroed, which also clears the statistics */
+  enclave = kzalloc(sizeof(struct enclave), GFP_KERNEL);
   if (!enclave){
     keystone_err("failed to allocate enclave struct\n");
     goto error_no_free;
   }
 
-  enclave->eid = -1;
+  kref_init(&enclave->ref);
+  enclave->eid = KEYSTONE_INVALID_EID;
   enclave->utm = NULL;
   enclave->sem = NULL;
   enclave->close_on_pexit = 1;
 
+  mutex_init(&enclave->async_lock);
+  INIT_WORK(&enclave->async_work, keystone_async_work);
+  init_waitqueue_head(&enclave->async_wait);
+  enclave->async_flags = 0;
+
   enclave->epm = kmalloc(sizeof(struct epm), GFP_KERNEL);
   enclave->is_init = true;
   if (!enclave->epm)
@@ -93,6 +106,8 @@ unsigned int enclave_idr_alloc(struct enclave* enclave)
     return 0;
   }
 
+  keystone_debugfs_add_enclave(enclave, ueid);
+
   return ueid;
 }
 
@@ -102,14 +117,30 @@ struct enclave* enclave_idr_remove(unsigned int ueid)
   mutex_lock(&idr_enclave_lock);
   enclave = idr_remove(&idr_enclave, ueid);
   mutex_unlock(&idr_enclave_lock);
+
+  if (enclave)
+    keystone_debugfs_remove_enclave(enclave);
   return enclave;
 }
 
+/* Lock-free lookup. idr_find() is safe under RCU against a concurrent
+ * enclave_idr_remove(), and the struct is freed with kfree_rcu(), so it stays
+ * valid until kref_get_unless_zero() either pins it or sees it dying.
+ * The caller must drop the reference with put_enclave(). */
 struct enclave* get_enclave_by_id(unsigned int ueid)
 {
   struct enclave* enclave;
-  mutex_lock(&idr_enclave_lock);
+
+  rcu_read_lock();
   enclave = idr_find(&idr_enclave, ueid);
-  mutex_unlock(&idr_enclave_lock);
+  if (enclave && !kref_get_unless_zero(&enclave->ref))
+    enclave = NULL;
+  rcu_read_unlock();
+
   return enclave;
 }
+
+void put_enclave(struct enclave* enclave)
+{
+  kref_put(&enclave->ref, enclave_release);
+}
@@ -5,9 +5,12 @@
 #include "keystone.h"
 #include "keystone-sbi.h"
 #include "keystone_user.h"
+#include "sm_err.h"
 #include <asm/sbi.h>
 #include <linux/uaccess.h>
 #include <linux/string.h>
+#include <linux/ktime.h>
+#include <linux/version.h>
 
 int __keystone_destroy_enclave(unsigned int ueid);
 
@@ -60,7 +63,7 @@ int keystone_finalize_enclave(unsigned long arg)
   utm = enclave->utm;
 
   if (utm) {
-    create_args.utm_region.paddr = __pa(utm->ptr);
+    create_args.utm_region.paddr = utm->pa;
     create_args.utm_region.size = utm->size;
   } else {
     create_args.utm_region.paddr = 0;
@@ -82,6 +85,7 @@ int keystone_finalize_enclave(unsigned long arg)
   create_args.user_paddr = enclp->user_paddr;
   create_args.free_paddr = enclp->free_paddr;
   create_args.free_requested = enclp->free_requested;
+  create_args.measure_flags = enclp->measure_flags;
 
   ret = sbi_sm_create_enclave(&create_args);
 
@@ -91,15 +95,132 @@ int keystone_finalize_enclave(unsigned long arg)
   }
 
   enclave->eid = ret.value;
+  put_enclave(enclave);
+
+  return 0;
+
+error_destroy_enclave:
+  /* This can handle partial initialization failure; the memory goes away
+   * with the last reference */
+  if (enclave_idr_remove(enclp->eid) == enclave)
+    put_enclave(enclave);
+  put_enclave(enclave);
+
+  return -EINVAL;
+
+}
+
+/* Create a new enclave on this file as a copy of a fresh enclave.
+ * The EPM, UTM and SEM are allocated with the sizes of the source, and the
+ * SM copies the EPM contents and the measurement over. */
+int keystone_clone_enclave(struct file *filep, unsigned long arg)
+{
+  struct sbiret ret;
+  struct enclave *src;
+  struct enclave *enclave;
+  struct keystone_sbi_create_t create_args;
+  unsigned int ueid;
+
+  struct keystone_ioctl_clone_enclave *enclp = (struct keystone_ioctl_clone_enclave *) arg;
+
+  src = get_enclave_by_id(enclp->src_eid);
+  if (!src) {
+    keystone_err("invalid source enclave id\n");
+    return -EINVAL;
+  }
+
+  if (src->eid == KEYSTONE_INVALID_EID) {
+    keystone_err("invalid source enclave id\n");
+    put_enclave(src);
+    return -EINVAL;
+  }
+
+  enclave = create_enclave(src->epm->size >> PAGE_SHIFT);
+  if (enclave == NULL) {
+    put_enclave(src);
+    return -ENOMEM;
+  }
+
+  if (src->utm) {
+    enclave->utm = kmalloc(sizeof(struct utm), GFP_KERNEL);
+    if (!enclave->utm || utm_init(enclave->utm, src->utm->size))
+      goto error_destroy_enclave;
+  }
+
+  if (src->sem) {
+    enclave->sem = kmalloc(sizeof(struct sem), GFP_KERNEL);
+    if (!enclave->sem || sem_init(enclave->sem, src->sem->size))
+      goto error_destroy_enclave;
+  }
+
+  /* the EPM is never loaded by the host, mmap() maps the UTM from now on */
+  enclave->is_init = false;
+
+  memset(&create_args, 0, sizeof(create_args));
+  create_args.epm_region.paddr = enclave->epm->pa;
+  create_args.epm_region.size = enclave->epm->size;
+  if (enclave->utm) {
+    create_args.utm_region.paddr = enclave->utm->pa;
+    create_args.utm_region.size = enclave->utm->size;
+  }
+  if (enclave->sem) {
+    create_args.sem_region.paddr = __pa(enclave->sem->ptr);
+    create_args.sem_region.size = enclave->sem->size;
+  }
+
+  ret = sbi_sm_clone_enclave(src->eid, &create_args);
+  if (ret.error) {
+    keystone_err("keystone_clone_enclave: SBI call failed with error code %ld\n", ret.error);
+    goto error_destroy_enclave;
+  }
+
+  enclave->eid = ret.value;
+
+  ueid = enclave_idr_alloc(enclave);
+  if (!ueid) {
+    /* the SM owns the memory now, have it scrub and return it */
+    ret = sbi_sm_destroy_enclave(enclave->eid);
+    if (ret.error) {
+      /* the EPM is still protected, leak it rather than hand it back */
+      keystone_err("fatal: cannot destroy enclave: SBI failed with error code %ld\n", ret.error);
+      put_enclave(src);
+      return -EINVAL;
+    }
+    goto error_destroy_enclave;
+  }
+
+  enclp->eid = ueid;
+  enclp->epm_paddr = enclave->epm->pa;
+  enclp->epm_size = enclave->epm->size;
+  enclp->utm_paddr = enclave->utm ? enclave->utm->pa : 0;
+  enclp->utm_size = enclave->utm ? enclave->utm->size : 0;
+
+  filep->private_data = (void *) enclp->eid;
+  put_enclave(src);
 
   return 0;
 
 error_destroy_enclave:
   /* This can handle partial initialization failure */
   destroy_enclave(enclave);
+  put_enclave(src);
 
   return -EINVAL;
+}
 
+/* Run or resume, timed and counted for the debugfs statistics */
+static struct sbiret keystone_sbi_run(struct enclave* enclave, bool resume)
+{
+  struct sbiret ret;
+  u64 start = ktime_get_ns();
+
+  if (resume)
+    ret = sbi_sm_resume_enclave(enclave->eid);
+  else
+    ret = sbi_sm_run_enclave(enclave->eid);
+
+  keystone_stats_account(enclave, resume, ret, ktime_get_ns() - start);
+  return ret;
 }
 
 int keystone_run_enclave(unsigned long data)
@@ -108,6 +229,7 @@ int keystone_run_enclave(unsigned long data)
   unsigned long ueid;
   struct enclave* enclave;
   struct keystone_ioctl_run_enclave *arg = (struct keystone_ioctl_run_enclave*) data;
+  int err = 0;
 
   ueid = arg->eid;
   enclave = get_enclave_by_id(ueid);
@@ -117,17 +239,170 @@ int keystone_run_enclave(unsigned long data)
     return -EINVAL;
   }
 
-  if (enclave->eid < 0) {
+  if (enclave->eid == KEYSTONE_INVALID_EID) {
     keystone_err("real enclave does not exist\n");
-    return -EINVAL;
+    err = -EINVAL;
+    goto out;
   }
 
-  ret = sbi_sm_run_enclave(enclave->eid);
+  /* held for the whole call, so no asynchronous run is queued beside it */
+  if (test_and_set_bit_lock(KEYSTONE_ASYNC_BUSY, &enclave->async_flags)) {
+    err = -EBUSY;
+    goto out;
+  }
+
+  ret = keystone_sbi_run(enclave, false);
+  clear_bit_unlock(KEYSTONE_ASYNC_BUSY, &enclave->async_flags);
 
   arg->error = ret.error;
   arg->value = ret.value;
 
-  return 0;
+out:
+  put_enclave(enclave);
+  return err;
+}
+
+/* Asynchronous run/resume
+ *
+ * The SBI call is made from keystone_wq instead of the calling thread, so a
+ * host event loop can keep many enclaves running and poll() their device
+ * files. Timer interrupts are handled here by resuming the enclave; the
+ * result only becomes readable once the enclave stops for the host
+ * (EDGE_CALL_HOST), exits, or fails. read() hands out the result and makes
+ * the enclave available for the next request. */
+void keystone_async_work(struct work_struct* work)
+{
+  struct enclave* enclave = container_of(work, struct enclave, async_work);
+  struct sbiret ret;
+
+  ret = keystone_sbi_run(enclave, enclave->async_resume);
+
+  while (ret.error == SBI_ERR_SM_ENCLAVE_INTERRUPTED &&
+         !test_bit(KEYSTONE_ASYNC_CANCEL, &enclave->async_flags)) {
+    cond_resched();
+    ret = keystone_sbi_run(enclave, true);
+  }
+
+  enclave->async_ret = ret;
+  smp_mb__before_atomic();
+  set_bit(KEYSTONE_ASYNC_DONE, &enclave->async_flags);
+  wake_up_interruptible(&enclave->async_wait);
+
+  /* taken by keystone_run_enclave_async() */
+  put_enclave(enclave);
+}
+
+int keystone_run_enclave_async(unsigned long data, bool resume)
+{
+  struct keystone_ioctl_run_enclave *arg = (struct keystone_ioctl_run_enclave*) data;
+  struct enclave* enclave;
+  int err = 0;
+
+  enclave = get_enclave_by_id(arg->eid);
+  if (!enclave) {
+    keystone_err("invalid enclave id\n");
+    return -EINVAL;
+  }
+
+  if (enclave->eid == KEYSTONE_INVALID_EID) {
+    keystone_err("real enclave does not exist\n");
+    err = -EINVAL;
+    goto out;
+  }
+
+  if (test_and_set_bit_lock(KEYSTONE_ASYNC_BUSY, &enclave->async_flags)) {
+    err = -EBUSY;
+    goto out;
+  }
+
+  /* Destroy sets CANCEL under async_lock and flushes the work after, so
+   * nothing can be queued behind its flush. The work also holds its own
+   * reference until it has returned. */
+  mutex_lock(&enclave->async_lock);
+  if (test_bit(KEYSTONE_ASYNC_CANCEL, &enclave->async_flags)) {
+    mutex_unlock(&enclave->async_lock);
+    clear_bit_unlock(KEYSTONE_ASYNC_BUSY, &enclave->async_flags);
+    err = -EINVAL;
+    goto out;
+  }
+  enclave->async_resume = resume;
+  kref_get(&enclave->ref);
+  queue_work(keystone_wq, &enclave->async_work);
+  mutex_unlock(&enclave->async_lock);
+
+out:
+  put_enclave(enclave);
+  return err;
+}
+
+ssize_t keystone_read(struct file* filep, char __user* buf, size_t len, loff_t* off)
+{
+  unsigned long ueid = (unsigned long) filep->private_data;
+  struct keystone_ioctl_run_enclave result;
+  struct enclave* enclave;
+  ssize_t err = sizeof(result);
+
+  if (len < sizeof(result))
+    return -EINVAL;
+
+  enclave = get_enclave_by_id(ueid);
+  if (!enclave)
+    return -EINVAL;
+
+  /* nothing queued, a blocking read would never return */
+  if (!test_bit(KEYSTONE_ASYNC_BUSY, &enclave->async_flags)) {
+    err = -EINVAL;
+    goto out;
+  }
+
+  while (!test_and_clear_bit(KEYSTONE_ASYNC_DONE, &enclave->async_flags)) {
+    if (filep->f_flags & O_NONBLOCK) {
+      err = -EAGAIN;
+      goto out;
+    }
+    if (wait_event_interruptible(enclave->async_wait,
+          test_bit(KEYSTONE_ASYNC_DONE, &enclave->async_flags))) {
+      err = -ERESTARTSYS;
+      goto out;
+    }
+  }
+
+  result.eid = ueid;
+  result.error = enclave->async_ret.error;
+  result.value = enclave->async_ret.value;
+  clear_bit_unlock(KEYSTONE_ASYNC_BUSY, &enclave->async_flags);
+
+  if (copy_to_user(buf, &result, sizeof(result)))
+    err = -EFAULT;
+
+out:
+  put_enclave(enclave);
+  return err;
+}
+
+__poll_t keystone_poll(struct file* filep, poll_table* wait)
+{
+  struct enclave* enclave;
+  __poll_t mask = 0;
+
+  enclave = get_enclave_by_id((unsigned long) filep->private_data);
+  if (!enclave)
+    return EPOLLERR;
+
+  /* once CANCEL is set, destroy may already have emptied async_wait for
+   * good; a waiter added after that would outlive it */
+  mutex_lock(&enclave->async_lock);
+  if (test_bit(KEYSTONE_ASYNC_CANCEL, &enclave->async_flags)) {
+    mask = EPOLLERR;
+  } else {
+    poll_wait(filep, &enclave->async_wait, wait);
+    if (test_bit(KEYSTONE_ASYNC_DONE, &enclave->async_flags))
+      mask = EPOLLIN | EPOLLRDNORM;
+  }
+  mutex_unlock(&enclave->async_lock);
+
+  put_enclave(enclave);
+  return mask;
 }
 
 int utm_init_ioctl(struct file *filp, unsigned long arg)
@@ -148,16 +423,24 @@ int utm_init_ioctl(struct file *filp, unsigned long arg)
   utm = kmalloc(sizeof(struct utm), GFP_KERNEL);
   if (!utm) {
     ret = -ENOMEM;
-    return ret;
+    goto out;
   }
 
   ret = utm_init(utm, untrusted_size);
+  if (ret) {
+    /* utm->pa is not set, do not hand it out */
+    kfree(utm);
+    enclp->utm_paddr = 0;
+    goto out;
+  }
 
   /* prepare for mmap */
   enclave->utm = utm;
 
-  enclp->utm_paddr = __pa(utm->ptr);
+  enclp->utm_paddr = utm->pa;
 
+out:
+  put_enclave(enclave);
   return ret;
 }
 
@@ -181,7 +464,7 @@ int sem_init_ioctl(struct file *filp, unsigned long arg)
   sem = kmalloc(sizeof(struct sem), GFP_KERNEL);
   if (!sem) {
     ret = -ENOMEM;
-    return ret;
+    goto out;
   }
 
   ret = sem_init(sem, untrusted_size);
@@ -190,6 +473,9 @@ int sem_init_ioctl(struct file *filp, unsigned long arg)
   /* prepare for mmap */
   enclave->sem = sem;
   enclp->sem_paddr = __pa(sem->ptr);
+
+out:
+  put_enclave(enclave);
   return ret;
 }
 
@@ -201,6 +487,7 @@ int keystone_connect_enclave(unsigned long arg)
   unsigned long ueid2 = encls->eid2;
   struct enclave* enclave1;
   struct enclave* enclave2;
+  int err = 0;
 
   // keystone_err("keystone_connect_enclave");
 
@@ -215,7 +502,8 @@ int keystone_connect_enclave(unsigned long arg)
   if (!enclave1 || !enclave2)
   {
     keystone_err("invalid enclave id\n");
-    return -EINVAL;
+    err = -EINVAL;
+    goto out;
   }
 
   // keystone_err("SBI_CALL_2");
@@ -223,9 +511,15 @@ int keystone_connect_enclave(unsigned long arg)
 
   if (ret.error) {
     keystone_err("keystone_connect_enclave: SBI call failed with error code %ld\n", ret.error);
-    return -EINVAL;
+    err = -EINVAL;
   }
-  return 0;
+
+out:
+  if (enclave1)
+    put_enclave(enclave1);
+  if (enclave2)
+    put_enclave(enclave2);
+  return err;
 }
 
 int keystone_destroy_enclave(struct file *filep, unsigned long arg)
@@ -252,19 +546,37 @@ int __keystone_destroy_enclave(unsigned int ueid)
     return -EINVAL;
   }
 
+  /* stop resuming after interrupts and wait for a queued run to return */
+  mutex_lock(&enclave->async_lock);
+  set_bit(KEYSTONE_ASYNC_CANCEL, &enclave->async_flags);
+  mutex_unlock(&enclave->async_lock);
+  flush_work(&enclave->async_work);
+
   if (enclave->eid >= 0) {
     ret = sbi_sm_destroy_enclave(enclave->eid);
     if (ret.error) {
       keystone_err("fatal: cannot destroy enclave: SBI failed with error code %ld\n", ret.error);
+      put_enclave(enclave);
       return -EINVAL;
     }
   } else {
     keystone_warn("keystone_destroy_enclave: skipping (enclave does not exist)\n");
   }
 
-
-  destroy_enclave(enclave);
-  enclave_idr_remove(ueid);
+  /* An epoll registration can outlive the enclave, the fd stays open.
+   * Detach its waiters now; async_wait is freed after an RCU grace period
+   * (kfree_rcu), as wake_up_pollfree() requires. */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 16, 0)
+  wake_up_pollfree(&enclave->async_wait);
+#else
+  wake_up_all(&enclave->async_wait);
+#endif
+
+  /* Unpublish, then drop the idr's reference and ours. Lookups that raced
+   * with us still hold theirs; the memory is freed when the last one goes. */
+  if (enclave_idr_remove(ueid) == enclave)
+    put_enclave(enclave);
+  put_enclave(enclave);
 
   return 0;
 }
@@ -275,6 +587,7 @@ int keystone_resume_enclave(unsigned long data)
   struct keystone_ioctl_run_enclave *arg = (struct keystone_ioctl_run_enclave*) data;
   unsigned long ueid = arg->eid;
   struct enclave* enclave;
+  int err = 0;
   enclave = get_enclave_by_id(ueid);
 
   if (!enclave)
@@ -283,17 +596,27 @@ int keystone_resume_enclave(unsigned long data)
     return -EINVAL;
   }
 
-  if (enclave->eid < 0) {
+  if (enclave->eid == KEYSTONE_INVALID_EID) {
     keystone_err("real enclave does not exist\n");
-    return -EINVAL;
+    err = -EINVAL;
+    goto out;
+  }
+
+  /* held for the whole call, so no asynchronous run is queued beside it */
+  if (test_and_set_bit_lock(KEYSTONE_ASYNC_BUSY, &enclave->async_flags)) {
+    err = -EBUSY;
+    goto out;
   }
 
-  ret = sbi_sm_resume_enclave(enclave->eid);
+  ret = keystone_sbi_run(enclave, true);
+  clear_bit_unlock(KEYSTONE_ASYNC_BUSY, &enclave->async_flags);
 
   arg->error = ret.error;
   arg->value = ret.value;
 
-  return 0;
+out:
+  put_enclave(enclave);
+  return err;
 }
 
 int get_smeid(unsigned long data)
@@ -309,17 +632,89 @@ int get_smeid(unsigned long data)
     return -EINVAL;
   }
 
-  if (enclave->eid < 0) {
+  if (enclave->eid == KEYSTONE_INVALID_EID) {
     keystone_err("real enclave does not exist\n");
+    put_enclave(enclave);
     return -EINVAL;
   }
 
   // just reuse this slot
   enclp->eid = enclave->eid;
+  put_enclave(enclave);
 
   return 0;
 }
 
+int keystone_get_stats(unsigned long data)
+{
+  struct sbiret ret;
+  struct keystone_ioctl_stats *arg = (struct keystone_ioctl_stats *) data;
+  struct enclave* enclave;
+  unsigned long id;
+
+  switch (arg->type) {
+    case SM_STATS_ENCLAVE:
+      enclave = get_enclave_by_id(arg->eid);
+      if (!enclave) {
+        keystone_err("invalid enclave id\n");
+        return -EINVAL;
+      }
+      id = enclave->eid;
+      put_enclave(enclave);
+      break;
+    case SM_STATS_HART:
+      id = arg->hartid;
+      break;
+    default:
+      return -EINVAL;
+  }
+
+  ret = sbi_sm_get_stats(arg->type, id, &arg->stats);
+  if (ret.error) {
+    keystone_err("keystone_get_stats: SBI call failed with error code %ld\n", ret.error);
+    return -EINVAL;
+  }
+
+  return 0;
+}
+
+/* upper bound of a single drain, so the bounce buffer stays small */
+#define KEYSTONE_TRACE_MAX_EVENTS 256
+
+int keystone_drain_trace(unsigned long data)
+{
+  struct sbiret ret;
+  struct keystone_ioctl_trace *arg = (struct keystone_ioctl_trace *) data;
+  struct sm_trace_event *events;
+  unsigned long max = arg->count;
+  int err = 0;
+
+  if (max > KEYSTONE_TRACE_MAX_EVENTS)
+    max = KEYSTONE_TRACE_MAX_EVENTS;
+
+  events = kmalloc_array(max, sizeof(struct sm_trace_event), GFP_KERNEL);
+  if (!events)
+    return -ENOMEM;
+
+  ret = sbi_sm_drain_trace(arg->hartid, events, max);
+  if (ret.error) {
+    keystone_err("keystone_drain_trace: SBI call failed with error code %ld\n", ret.error);
+    err = -EINVAL;
+    goto out;
+  }
+
+  if (copy_to_user((void __user *) arg->events, events,
+        ret.value * sizeof(struct sm_trace_event))) {
+    err = -EFAULT;
+    goto out;
+  }
+  arg->count = ret.value;
+
+out:
+  kfree(events);
+  return err;
+}
+
 long keystone_ioctl(struct file *filep, unsigned int cmd, unsigned long arg)
 {
   long ret;
@@ -343,6 +738,9 @@ long keystone_ioctl(struct file *filep, unsigned int cmd, unsigned long arg)
     case KEYSTONE_IOC_FINALIZE_ENCLAVE:
       ret = keystone_finalize_enclave((unsigned long) data);
       break;
+    case KEYSTONE_IOC_CLONE_ENCLAVE:
+      ret = keystone_clone_enclave(filep, (unsigned long) data);
+      break;
     case KEYSTONE_IOC_DESTROY_ENCLAVE:
       ret = keystone_destroy_enclave(filep, (unsigned long) data);
       break;
@@ -352,6 +750,12 @@ long keystone_ioctl(struct file *filep, unsigned int cmd, unsigned long arg)
     case KEYSTONE_IOC_RESUME_ENCLAVE:
       ret = keystone_resume_enclave((unsigned long) data);
       break;
+    case KEYSTONE_IOC_RUN_ENCLAVE_ASYNC:
+      ret = keystone_run_enclave_async((unsigned long) data, false);
+      break;
+    case KEYSTONE_IOC_RESUME_ENCLAVE_ASYNC:
+      ret = keystone_run_enclave_async((unsigned long) data, true);
+      break;
     /* Note that following commands could have been implemented as a part of ADD_PAGE ioctl.
      * However, there was a weird bug in compiler that generates a wrong control flow
      * that ends up with an illegal instruction if we combine switch-case and if statements.
@@ -368,6 +772,12 @@ long keystone_ioctl(struct file *filep, unsigned int cmd, unsigned long arg)
     case KEYSTONE_IOC_GET_SMEID:
       ret = get_smeid((unsigned long) data);
       break;
+    case KEYSTONE_IOC_GET_STATS:
+      ret = keystone_get_stats((unsigned long) data);
+      break;
+    case KEYSTONE_IOC_DRAIN_TRACE:
+      ret = keystone_drain_trace((unsigned long) data);
+      break;
     default:
       return -ENOSYS;
   }
@@ -381,6 +791,7 @@ long keystone_ioctl(struct file *filep, unsigned int cmd, unsigned long arg)
 int keystone_release(struct inode *inode, struct file *file) {
   unsigned long ueid = (unsigned long)(file->private_data);
   struct enclave *enclave;
+  int close_on_pexit;
 
   /* enclave has been already destroyed */
   if (!ueid) {
@@ -394,7 +805,10 @@ int keystone_release(struct inode *inode, struct file *file) {
     /* If eid is set to the invalid id, then we do not do anything. */
     return -EINVAL;
   }
-  if (enclave->close_on_pexit) {
+  close_on_pexit = enclave->close_on_pexit;
+  put_enclave(enclave);
+
+  if (close_on_pexit) {
     return __keystone_destroy_enclave(ueid);
   }
   return 0;
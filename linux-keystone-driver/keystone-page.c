@@ -6,8 +6,141 @@
 #include <linux/kernel.h>
 #include "keystone.h"
 #include <linux/dma-mapping.h>
+#include <linux/genalloc.h>
+#include <linux/log2.h>
+#include <linux/moduleparam.h>
 #include <linux/version.h>
 
+/* alloc_pages_exact() refuses __GFP_HIGHMEM; the regions are accessed
+ * through the linear map anyway, and RISC-V has no highmem. */
+#define KEYSTONE_GFP (GFP_HIGHUSER & ~__GFP_HIGHMEM)
+
+/* Allocate exactly count physically contiguous pages from the buddy
+ * allocator. The power-of-two block is split and the tail beyond count is
+ * returned to the allocator right away, so e.g. a 5 MiB region no longer
+ * holds on to 8 MiB. Returns 0 if no block of the covering order is free or
+ * the order is beyond what the buddy allocator serves. */
+static vaddr_t keystone_alloc_exact(unsigned long count)
+{
+  unsigned int order = get_order(count << PAGE_SHIFT);
+
+  /* prevent kernel from complaining about an invalid argument */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 8, 0)
+  if (order >= MAX_PAGE_ORDER)
+#else
+  if (order >= MAX_ORDER)
+#endif
+    return 0;
+
+  return (vaddr_t) alloc_pages_exact(count << PAGE_SHIFT, KEYSTONE_GFP);
+}
+
+/* The SM guards every region with PMP. A power-of-two region aligned to
+ * its size fits one NAPOT entry; any other region takes a TOR pair, i.e. two
+ * of the few PMP registers, and the UTM (PMP_PRI_BOTTOM in the SM) cannot be
+ * TOR at all. So the UTM is always a power of two, and EPMs and SEMs are
+ * rounded up to one as long as that wastes at most 1/KEYSTONE_NAPOT_SLACK of
+ * it; larger regions keep their exact size and cost a TOR pair. Buddy blocks
+ * of a power-of-two size are aligned to it. */
+#define KEYSTONE_NAPOT_SLACK 8
+
+static unsigned long keystone_region_pages(unsigned long count)
+{
+  unsigned long napot = roundup_pow_of_two(count);
+
+  if (napot - count <= napot / KEYSTONE_NAPOT_SLACK)
+    return napot;
+  return count;
+}
+
+/* Reserved EPM pool
+ *
+ * With epm_pool_mb set, one physically contiguous region is reserved when the
+ * module loads and EPMs are carved out of it by a genalloc first-fit
+ * allocator. Creating an enclave then neither waits on compaction nor
+ * depends on a high-order allocation succeeding on a fragmented host. Pool
+ * memory is zeroed once at reservation and again when an EPM is returned,
+ * so epm_init can hand out chunks without clearing them. Requests the pool
+ * cannot satisfy fall back to the regular allocation path. */
+static unsigned long epm_pool_mb;
+module_param(epm_pool_mb, ulong, 0444);
+MODULE_PARM_DESC(epm_pool_mb,
+    "MiB of contiguous memory reserved at load time for enclave EPMs (0 = none)");
+
+static struct gen_pool* epm_pool;
+static vaddr_t epm_pool_va;
+static paddr_t epm_pool_pa;
+static size_t epm_pool_bytes;
+static bool epm_pool_is_cma;
+
+int epm_pool_init(void)
+{
+  unsigned long count = epm_pool_mb << (20 - PAGE_SHIFT);
+  dma_addr_t device_phys_addr = 0;
+
+  if (!count)
+    return 0;
+
+  epm_pool_is_cma = false;
+  epm_pool_va = keystone_alloc_exact(count);
+
+#ifdef CONFIG_CMA
+  if (!epm_pool_va) {
+    epm_pool_is_cma = true;
+    epm_pool_va = (vaddr_t) dma_alloc_coherent(keystone_dev.this_device,
+      count << PAGE_SHIFT,
+      &device_phys_addr,
+      GFP_KERNEL | __GFP_DMA32);
+
+    if(!device_phys_addr)
+      epm_pool_va = 0;
+  }
+#endif
+
+  if (!epm_pool_va) {
+    keystone_warn("failed to reserve %lu MiB EPM pool\n", epm_pool_mb);
+    return -ENOMEM;
+  }
+
+  epm_pool_pa = epm_pool_is_cma ? device_phys_addr : __pa(epm_pool_va);
+  epm_pool_bytes = count << PAGE_SHIFT;
+  memset((void*) epm_pool_va, 0, epm_pool_bytes);
+
+  epm_pool = gen_pool_create(PAGE_SHIFT, -1);
+  if (!epm_pool || gen_pool_add_virt(epm_pool, epm_pool_va, epm_pool_pa,
+                                     epm_pool_bytes, -1)) {
+    keystone_warn("failed to set up EPM pool allocator\n");
+    epm_pool_destroy();
+    return -ENOMEM;
+  }
+
+  keystone_info("reserved %lu MiB EPM pool at pa=0x%lx\n",
+      epm_pool_mb, (unsigned long) epm_pool_pa);
+  return 0;
+}
+
+/* Called at module exit, after every enclave (and thus every EPM) is gone */
+void epm_pool_destroy(void)
+{
+  if (epm_pool) {
+    gen_pool_destroy(epm_pool);
+    epm_pool = NULL;
+  }
+
+  if (!epm_pool_va)
+    return;
+
+  if (epm_pool_is_cma) {
+    dma_free_coherent(keystone_dev.this_device,
+        epm_pool_bytes,
+        (void*) epm_pool_va,
+        epm_pool_pa);
+  } else {
+    free_pages_exact((void*) epm_pool_va, epm_pool_bytes);
+  }
+  epm_pool_va = 0;
+}
+
 /* Destroy all memory associated with an EPM */
 int epm_destroy(struct epm* epm) {
 
@@ -15,13 +148,17 @@ int epm_destroy(struct epm* epm) {
     return 0;
 
   /* free the EPM hold by the enclave */
-  if (epm->is_cma) {
+  if (epm->is_pool) {
+    /* keep the pool pre-zeroed for the next epm_init */
+    memset((void*) epm->ptr, 0, epm->size);
+    gen_pool_free(epm_pool, epm->ptr, epm->size);
+  } else if (epm->is_cma) {
     dma_free_coherent(keystone_dev.this_device,
         epm->size,
         (void*) epm->ptr,
         epm->pa);
   } else {
-    free_pages(epm->ptr, epm->order);
+    free_pages_exact((void*) epm->ptr, epm->size);
   }
 
   return 0;
@@ -31,28 +168,37 @@ int epm_destroy(struct epm* epm) {
 int epm_init(struct epm* epm, unsigned int min_pages)
 {
   vaddr_t epm_vaddr = 0;
-  unsigned long order = 0;
-  unsigned long count = min_pages;
+  unsigned long count = keystone_region_pages(min_pages);
   phys_addr_t device_phys_addr = 0;
 
-  /* try to allocate contiguous memory */
   epm->is_cma = 0;
-  order = ilog2(min_pages - 1) + 1;
-  count = 0x1 << order;
+  epm->is_pool = 0;
 
-  /* prevent kernel from complaining about an invalid argument */
-#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 8, 0)
-  if (order < MAX_PAGE_ORDER)
-#else
-  if (order < MAX_ORDER)
-#endif
-    epm_vaddr = (vaddr_t) __get_free_pages(GFP_HIGHUSER, order);
+  /* pool chunks are already zeroed; power-of-two ones are aligned to their
+   * size within the pool, which is itself a buddy block if it could be */
+  if (epm_pool) {
+    if (is_power_of_2(count))
+      epm_vaddr = gen_pool_alloc_algo(epm_pool, count << PAGE_SHIFT,
+                                      gen_pool_first_fit_order_align, NULL);
+    else
+      epm_vaddr = gen_pool_alloc(epm_pool, count << PAGE_SHIFT);
+    if (epm_vaddr) {
+      epm->is_pool = 1;
+      epm->root_page_table = (void*)epm_vaddr;
+      epm->pa = gen_pool_virt_to_phys(epm_pool, epm_vaddr);
+      epm->size = count << PAGE_SHIFT;
+      epm->ptr = epm_vaddr;
+      return 0;
+    }
+  }
+
+  /* try to allocate contiguous memory */
+  epm_vaddr = keystone_alloc_exact(count);
 
 #ifdef CONFIG_CMA
   /* If buddy allocator fails, we fall back to the CMA */
   if (!epm_vaddr) {
     epm->is_cma = 1;
-    count = min_pages;
 
     epm_vaddr = (vaddr_t) dma_alloc_coherent(keystone_dev.this_device,
       count << PAGE_SHIFT,
@@ -66,15 +212,18 @@ int epm_init(struct epm* epm, unsigned int min_pages)
 
   if(!epm_vaddr) {
     keystone_err("failed to allocate %lu page(s)\n", count);
+    atomic_inc(&keystone_alloc_stats.epm_failures);
     return -ENOMEM;
   }
 
+  if (epm->is_cma)
+    atomic_inc(&keystone_alloc_stats.epm_cma);
+
   /* zero out */
   memset((void*)epm_vaddr, 0, PAGE_SIZE*count);
 
   epm->root_page_table = (void*)epm_vaddr;
   epm->pa = (epm->is_cma) ? device_phys_addr : __pa(epm_vaddr);
-  epm->order = order;
   epm->size = count << PAGE_SHIFT;
   epm->ptr = epm_vaddr;
 
@@ -83,34 +232,76 @@ int epm_init(struct epm* epm, unsigned int min_pages)
 
 int utm_destroy(struct utm* utm){
 
-  if(utm->ptr != NULL){
-    free_pages((vaddr_t)utm->ptr, utm->order);
+  if (utm->is_cma) {
+    dma_free_coherent(keystone_dev.this_device,
+        utm->alloc_size,
+        utm->alloc_ptr,
+        utm->alloc_pa);
+  } else if(utm->ptr != NULL){
+    free_pages_exact(utm->ptr, utm->size);
   }
 
   return 0;
 }
 
+/* UTMs of PMD_SIZE or more are placed on a PMD boundary so that both the
+ * host mapping (keystone_mmap) and Eyrie can use huge pages for them. Buddy
+ * blocks are aligned to their order, which already covers that. The UTM is
+ * rounded up to a power of two for the SM, see keystone_region_pages(). */
 int utm_init(struct utm* utm, size_t untrusted_size)
 {
-  unsigned long req_pages = 0;
-  unsigned long order = 0;
-  unsigned long count;
-  req_pages += PAGE_UP(untrusted_size)/PAGE_SIZE;
-  order = ilog2(req_pages - 1) + 1;
-  count = 0x1 << order;
+  unsigned long count = roundup_pow_of_two(PAGE_UP(untrusted_size)/PAGE_SIZE);
+#ifdef CONFIG_CMA
+  dma_addr_t device_phys_addr = 0;
+  size_t align, cma_align;
+#endif
+
+  utm->is_cma = 0;
+  utm->size = count * PAGE_SIZE;
 
-  utm->order = order;
+  utm->ptr = (void*) keystone_alloc_exact(count);
+  if (utm->ptr)
+    utm->pa = __pa(utm->ptr);
 
-  /* Currently, UTM does not utilize CMA.
-   * It is always allocated from the buddy allocator */
-  utm->ptr = (void*) __get_free_pages(GFP_HIGHUSER, order);
+#ifdef CONFIG_CMA
+  /* Large UTMs are beyond the buddy allocator, use CMA like the EPM. The SM
+   * needs the UTM aligned to its size, but CMA only aligns to the size up to
+   * CONFIG_CMA_ALIGNMENT, so over-allocate by the difference. Beyond that
+   * this can cost up to as much again as the UTM; raise CMA_ALIGNMENT to
+   * avoid it. */
   if (!utm->ptr) {
-    keystone_err("failed to allocate UTM (size = %i bytes)\n",(1<<order));
+    align = utm->size;
+#ifdef CONFIG_CMA_ALIGNMENT
+    cma_align = PAGE_SIZE << min_t(unsigned int, get_order(utm->size),
+                                   CONFIG_CMA_ALIGNMENT);
+#else
+    cma_align = PAGE_SIZE;
+#endif
+    utm->alloc_size = utm->size + align - min(cma_align, align);
+    utm->alloc_ptr = dma_alloc_coherent(keystone_dev.this_device,
+      utm->alloc_size,
+      &device_phys_addr,
+      GFP_KERNEL | __GFP_DMA32);
+
+    if (utm->alloc_ptr && device_phys_addr) {
+      utm->is_cma = 1;
+      utm->alloc_pa = device_phys_addr;
+      utm->pa = ALIGN(utm->alloc_pa, align);
+      utm->ptr = utm->alloc_ptr + (utm->pa - utm->alloc_pa);
+    }
+  }
+#endif
+
+  if (!utm->ptr) {
+    keystone_err("failed to allocate UTM (size = %lu bytes)\n", count * PAGE_SIZE);
+    atomic_inc(&keystone_alloc_stats.utm_failures);
     return -ENOMEM;
   }
 
-  utm->size = count * PAGE_SIZE;
-  if (utm->size != untrusted_size) {
+  if (utm->is_cma)
+    atomic_inc(&keystone_alloc_stats.utm_cma);
+
+  if (PAGE_UP(untrusted_size) != untrusted_size) {
     /* Instead of failing, we just warn that the user has to fix the parameter. */
     keystone_warn("shared buffer size is not multiple of PAGE_SIZE\n");
   }
@@ -122,7 +313,7 @@ int utm_init(struct utm* utm, size_t untrusted_size)
 int sem_destroy(struct sem* sem) {
 
   if(sem->ptr){
-    free_pages((vaddr_t)sem->ptr, sem->order);
+    free_pages_exact((void*)sem->ptr, sem->size);
   }
 
   return 0;
@@ -131,27 +322,21 @@ int sem_destroy(struct sem* sem) {
 /* Create an shared enclave buffer */
 int sem_init(struct sem* sem, size_t size)
 {
-  unsigned long req_pages = 0;
-  unsigned long order = 0;
-  unsigned long count;
-  req_pages += PAGE_UP(size)/PAGE_SIZE;
-  order = ilog2(req_pages - 1) + 1;
-  count = 0x1 << order;
-
-  sem->order = order;
+  unsigned long count = keystone_region_pages(PAGE_UP(size)/PAGE_SIZE);
 
   /* Currently, SEM does not utilize CMA.
    * It is always allocated from the buddy allocator */
-  sem->ptr = (uintptr_t) __get_free_pages(GFP_HIGHUSER, order);
-  // Hack: we memset this page to zero to avoid random data in the shared memory
-  memset((void*)sem->ptr, 0, count << PAGE_SHIFT);
-  keystone_info("sem_init: allocated sem ptr at 0x%lx, pa=0x%lx", sem->ptr, __pa((void*)sem->ptr));
+  sem->ptr = (uintptr_t) keystone_alloc_exact(count);
   if (!sem->ptr) {
+    atomic_inc(&keystone_alloc_stats.sem_failures);
     return -ENOMEM;
   }
+  // Hack: we memset this page to zero to avoid random data in the shared memory
+  memset((void*)sem->ptr, 0, count << PAGE_SHIFT);
+  keystone_info("sem_init: allocated sem ptr at 0x%lx, pa=0x%lx", sem->ptr, __pa((void*)sem->ptr));
 
   sem->size = count * PAGE_SIZE;
-  if (sem->size != size) {
+  if (PAGE_UP(size) != size) {
     /* Instead of failing, we just warn that the user has to fix the parameter. */
     keystone_warn("shared buffer size is not multiple of PAGE_SIZE\n");
   }
@@ -6,6 +6,12 @@ struct sbiret sbi_sm_create_enclave(struct keystone_sbi_create_t* args) {
       (unsigned long) args, 0, 0, 0, 0, 0);
 }
 
+struct sbiret sbi_sm_clone_enclave(unsigned long src_eid, struct keystone_sbi_create_t* args) {
+  return sbi_ecall(SBI_EXT_EXPERIMENTAL_KEYSTONE_ENCLAVE,
+      SBI_SM_CLONE_ENCLAVE,
+      src_eid, (unsigned long) args, 0, 0, 0, 0);
+}
+
 struct sbiret sbi_sm_run_enclave(unsigned long eid) {
   return sbi_ecall(SBI_EXT_EXPERIMENTAL_KEYSTONE_ENCLAVE,
       SBI_SM_RUN_ENCLAVE,
@@ -29,3 +35,15 @@ struct sbiret sbi_sm_connect_enclaves(unsigned long eid1, unsigned long eid2) {
       SBI_SM_CON_ENCLAVES,
       eid1, eid2, 0, 0, 0, 0);
 }
+
+struct sbiret sbi_sm_get_stats(unsigned long type, unsigned long id, struct sm_stats* stats) {
+  return sbi_ecall(SBI_EXT_EXPERIMENTAL_KEYSTONE_ENCLAVE,
+      SBI_SM_GET_STATS,
+      type, id, (unsigned long) stats, 0, 0, 0);
+}
+
+struct sbiret sbi_sm_drain_trace(unsigned long hartid, struct sm_trace_event* events, unsigned long max) {
+  return sbi_ecall(SBI_EXT_EXPERIMENTAL_KEYSTONE_ENCLAVE,
+      SBI_SM_DRAIN_TRACE,
+      hartid, (unsigned long) events, max, 0, 0, 0);
+}
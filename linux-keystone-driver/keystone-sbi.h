@@ -11,9 +11,12 @@
 #include <asm/sbi.h>
 
 struct sbiret sbi_sm_create_enclave(struct keystone_sbi_create_t* args);
+struct sbiret sbi_sm_clone_enclave(unsigned long src_eid, struct keystone_sbi_create_t* args);
 struct sbiret sbi_sm_destroy_enclave(unsigned long eid);
 struct sbiret sbi_sm_run_enclave(unsigned long eid);
 struct sbiret sbi_sm_resume_enclave(unsigned long eid);
 struct sbiret sbi_sm_connect_enclaves(unsigned long eid1, unsigned long eid2);
+struct sbiret sbi_sm_get_stats(unsigned long type, unsigned long id, struct sm_stats* stats);
+struct sbiret sbi_sm_drain_trace(unsigned long hartid, struct sm_trace_event* events, unsigned long max);
 
 #endif
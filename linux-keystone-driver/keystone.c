@@ -8,7 +8,12 @@
 #include "keystone-sbi.h"
 
 #include <linux/dma-mapping.h>
+#include <linux/huge_mm.h>
 #include <linux/mm.h>
+#include <linux/version.h>
+#if LINUX_VERSION_CODE < KERNEL_VERSION(6, 17, 0)
+#include <linux/pfn_t.h>
+#endif
 #include <linux/file.h>
 #include <linux/module.h>
 #include <linux/moduleparam.h>
@@ -25,7 +30,13 @@ MODULE_LICENSE("Dual BSD/GPL");
 static const struct file_operations keystone_fops = {
     .owner          = THIS_MODULE,
     .mmap           = keystone_mmap,
+#ifdef CONFIG_TRANSPARENT_HUGEPAGE
+    /* PMD-align large mappings so the UTM can be mapped with huge pages */
+    .get_unmapped_area = thp_get_unmapped_area,
+#endif
     .unlocked_ioctl = keystone_ioctl,
+    .read           = keystone_read,
+    .poll           = keystone_poll,
     .release        = keystone_release
 };
 
@@ -36,6 +47,81 @@ struct miscdevice keystone_dev = {
   .mode = 0666,
 };
 
+/* runs KEYSTONE_IOC_*_ASYNC requests; one work item per running enclave */
+struct workqueue_struct* keystone_wq;
+
+/* UTM mappings
+ *
+ * The UTM is mapped on demand rather than with remap_pfn_range(), so that
+ * PMD-aligned parts of a large UTM get a single huge page entry instead of
+ * 512 PTEs. The mapping holds a reference on the enclave, so the UTM stays
+ * around until the host unmaps it even if the enclave is destroyed first. */
+static void keystone_utm_vm_open(struct vm_area_struct* vma)
+{
+  struct enclave* enclave = vma->vm_private_data;
+  kref_get(&enclave->ref);
+}
+
+static void keystone_utm_vm_close(struct vm_area_struct* vma)
+{
+  put_enclave(vma->vm_private_data);
+}
+
+static vm_fault_t keystone_utm_fault(struct vm_fault* vmf)
+{
+  struct vm_area_struct* vma = vmf->vma;
+  struct utm* utm = ((struct enclave*) vma->vm_private_data)->utm;
+  unsigned long offset = vmf->address - vma->vm_start;
+
+  if (offset >= utm->size)
+    return VM_FAULT_SIGBUS;
+
+  return vmf_insert_pfn(vma, vmf->address, (utm->pa + offset) >> PAGE_SHIFT);
+}
+
+#ifdef CONFIG_TRANSPARENT_HUGEPAGE
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 6, 0)
+static vm_fault_t keystone_utm_huge_fault(struct vm_fault* vmf, unsigned int order)
+#else
+static vm_fault_t keystone_utm_huge_fault(struct vm_fault* vmf, enum page_entry_size pe_size)
+#endif
+{
+  struct vm_area_struct* vma = vmf->vma;
+  struct utm* utm = ((struct enclave*) vma->vm_private_data)->utm;
+  unsigned long addr = vmf->address & PMD_MASK;
+  unsigned long offset = addr - vma->vm_start;
+  bool write = vmf->flags & FAULT_FLAG_WRITE;
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 6, 0)
+  if (order != PMD_ORDER)
+#else
+  if (pe_size != PE_SIZE_PMD)
+#endif
+    return VM_FAULT_FALLBACK;
+
+  /* the huge page must lie within the VMA and the UTM, and be aligned */
+  if (addr < vma->vm_start || addr + PMD_SIZE > vma->vm_end ||
+      offset + PMD_SIZE > utm->size || !IS_ALIGNED(utm->pa + offset, PMD_SIZE))
+    return VM_FAULT_FALLBACK;
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 17, 0)
+  return vmf_insert_pfn_pmd(vmf, (utm->pa + offset) >> PAGE_SHIFT, write);
+#else
+  return vmf_insert_pfn_pmd(vmf,
+      __pfn_to_pfn_t((utm->pa + offset) >> PAGE_SHIFT, PFN_DEV), write);
+#endif
+}
+#endif
+
+static const struct vm_operations_struct keystone_utm_vm_ops = {
+  .open       = keystone_utm_vm_open,
+  .close      = keystone_utm_vm_close,
+  .fault      = keystone_utm_fault,
+#ifdef CONFIG_TRANSPARENT_HUGEPAGE
+  .huge_fault = keystone_utm_huge_fault,
+#endif
+};
+
 int keystone_mmap(struct file* filp, struct vm_area_struct *vma)
 {
   struct utm* utm;
@@ -55,7 +141,7 @@ int keystone_mmap(struct file* filp, struct vm_area_struct *vma)
 
   if(enclave->is_init){
     if (vsize > PAGE_SIZE)
-      return -EINVAL;
+      goto error;
     paddr = epm->pa + (vma->vm_pgoff << PAGE_SHIFT);
     remap_pfn_range(vma,
                     vma->vm_start,
@@ -66,28 +152,52 @@ int keystone_mmap(struct file* filp, struct vm_area_struct *vma)
   {
     psize = utm->size;
     if (vsize > psize)
-      return -EINVAL;
-    remap_pfn_range(vma,
-                    vma->vm_start,
-                    __pa(utm->ptr) >> PAGE_SHIFT,
-                    vsize, vma->vm_page_prot);
+      goto error;
+    /* a private writable mapping would be COW, which PFN mappings cannot
+     * do (the first fault would BUG in the mm) */
+    if (!(vma->vm_flags & VM_SHARED))
+      goto error;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 3, 0)
+    vm_flags_set(vma, VM_PFNMAP | VM_IO | VM_DONTEXPAND | VM_DONTDUMP);
+#else
+    vma->vm_flags |= VM_PFNMAP | VM_IO | VM_DONTEXPAND | VM_DONTDUMP;
+#endif
+    vma->vm_ops = &keystone_utm_vm_ops;
+    /* the lookup reference now belongs to the mapping */
+    vma->vm_private_data = enclave;
+    return 0;
   }
+  put_enclave(enclave);
   return 0;
+
+error:
+  put_enclave(enclave);
+  return -EINVAL;
 }
 
 static int __init keystone_dev_init(void)
 {
   int  ret;
 
+  keystone_wq = alloc_workqueue("keystone_enclave", WQ_UNBOUND, 0);
+  if (!keystone_wq)
+    return -ENOMEM;
 
   ret = misc_register(&keystone_dev);
   if (ret < 0)
   {
     pr_err("keystone_enclave: misc_register() failed\n");
+    destroy_workqueue(keystone_wq);
+    return ret;
   }
 
   keystone_dev.this_device->coherent_dma_mask = DMA_BIT_MASK(32);
 
+  /* optional; enclaves still work from regular allocations without it */
+  if (epm_pool_init())
+    keystone_warn("continuing without the EPM pool\n");
+  keystone_debugfs_init();
+
   pr_info("keystone_enclave: " DRV_DESCRIPTION " v" DRV_VERSION "\n");
   return ret;
 }
@@ -96,6 +206,9 @@ static void __exit keystone_dev_exit(void)
 {
   pr_info("keystone_enclave: keystone_dev_exit()\n");
   misc_deregister(&keystone_dev);
+  keystone_debugfs_exit();
+  destroy_workqueue(keystone_wq);
+  epm_pool_destroy();
   return;
 }
 
@@ -16,6 +16,12 @@
 #include <linux/fs.h>
 #include <linux/miscdevice.h>
 #include <linux/idr.h>
+#include <linux/kref.h>
+#include <linux/mutex.h>
+#include <linux/rcupdate.h>
+#include <linux/poll.h>
+#include <linux/wait.h>
+#include <linux/workqueue.h>
 
 #include <linux/file.h>
 
@@ -28,9 +34,12 @@ typedef uintptr_t vaddr_t;
 typedef uintptr_t paddr_t;
 
 extern struct miscdevice keystone_dev;
+extern struct workqueue_struct* keystone_wq;
 
 long keystone_ioctl(struct file* filep, unsigned int cmd, unsigned long arg);
 int keystone_release(struct inode *inode, struct file *file);
+ssize_t keystone_read(struct file* filep, char __user* buf, size_t len, loff_t* off);
+__poll_t keystone_poll(struct file* filep, poll_table* wait);
 int keystone_mmap(struct file *filp, struct vm_area_struct *vma);
 
 /* enclave private memory */
@@ -38,34 +47,83 @@ struct epm {
   pte_t* root_page_table;
   vaddr_t ptr;
   size_t size;
-  unsigned long order;
   paddr_t pa;
   bool is_cma;
+  bool is_pool;
 };
 
 struct utm {
   pte_t* root_page_table;
   void* ptr;
   size_t size;
-  unsigned long order;
+  paddr_t pa;
+  bool is_cma;
+  /* CMA only: the allocation ptr/pa/size were carved from */
+  void* alloc_ptr;
+  paddr_t alloc_pa;
+  size_t alloc_size;
 };
 
 struct sem {
   pte_t* root_page_table;
   vaddr_t ptr;
   size_t size;
-  unsigned long order;
 };
 
 
+/* per-enclave counters, see keystone-debugfs.c */
+struct keystone_enclave_stats {
+  atomic64_t runs;
+  atomic64_t resumes;
+  atomic64_t exits_interrupt;
+  atomic64_t exits_edge_call;
+  atomic64_t exits_done;
+  atomic64_t exits_error;
+  atomic64_t run_ns;  /* time spent in run/resume SBI calls */
+};
+
+/* driver-wide allocation counters */
+struct keystone_alloc_stats {
+  atomic_t epm_failures;
+  atomic_t utm_failures;
+  atomic_t sem_failures;
+  atomic_t epm_cma;
+  atomic_t utm_cma;
+};
+extern struct keystone_alloc_stats keystone_alloc_stats;
+
+/* enclave->async_flags */
+#define KEYSTONE_ASYNC_BUSY   0 /* run/resume running or queued, or result not read yet */
+#define KEYSTONE_ASYNC_DONE   1 /* async_ret is valid, fd is readable */
+#define KEYSTONE_ASYNC_CANCEL 2 /* enclave is being destroyed */
+
+/* enclave->eid before the SM has created the enclave */
+#define KEYSTONE_INVALID_EID ((unsigned long) -1)
+
 struct enclave
 {
+  /* one reference is held by idr_enclave, one by each get_enclave_by_id() */
+  struct kref ref;
+  struct rcu_head rcu;
+
   unsigned long eid;
   int close_on_pexit;
   struct utm* utm;
   struct epm* epm;
   struct sem* sem;
   bool is_init;
+
+  /* asynchronous run/resume (KEYSTONE_IOC_*_ASYNC); async_lock orders
+   * queuing work and adding pollers against KEYSTONE_ASYNC_CANCEL */
+  struct mutex async_lock;
+  struct work_struct async_work;
+  wait_queue_head_t async_wait;
+  unsigned long async_flags;
+  bool async_resume;
+  struct sbiret async_ret;
+
+  struct keystone_enclave_stats stats;
+  struct dentry* debugfs;
 };
 
 
@@ -80,18 +138,28 @@ int keystone_rtld_init_app(struct enclave* enclave, void* __user app_ptr, size_t
 // untrusted memory mapper
 int keystone_rtld_init_untrusted(struct enclave* enclave, void* untrusted_ptr, size_t untrusted_size);
 
-struct enclave* get_enclave_by_id(unsigned int ueid);
 struct enclave* create_enclave(unsigned long min_pages);
 int destroy_enclave(struct enclave* enclave);
+void keystone_async_work(struct work_struct* work);
 
 unsigned int enclave_idr_alloc(struct enclave* enclave);
 struct enclave* enclave_idr_remove(unsigned int ueid);
 struct enclave* get_enclave_by_id(unsigned int ueid);
+void put_enclave(struct enclave* enclave);
 
 static inline uintptr_t  epm_satp(struct epm* epm) {
   return ((uintptr_t)epm->root_page_table >> RISCV_PGSHIFT | SATP_MODE_CHOICE);
 }
 
+void keystone_debugfs_init(void);
+void keystone_debugfs_exit(void);
+void keystone_debugfs_add_enclave(struct enclave* enclave, unsigned int ueid);
+void keystone_debugfs_remove_enclave(struct enclave* enclave);
+void keystone_stats_account(struct enclave* enclave, bool resume,
+    struct sbiret ret, u64 ns);
+
+int epm_pool_init(void);
+void epm_pool_destroy(void);
 int epm_destroy(struct epm* epm);
 int epm_init(struct epm* epm, unsigned int count);
 int utm_destroy(struct utm* utm);
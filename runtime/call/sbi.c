@@ -91,6 +91,11 @@ sbi_attest_enclave(void* report, void* buf, uintptr_t len, void* log_ptr, uintpt
   return SBI_CALL_5(SBI_EXT_EXPERIMENTAL_KEYSTONE_ENCLAVE, SBI_SM_ATTEST_ENCLAVE, report, buf, len, log_ptr, log_size);
 }
 
+uintptr_t
+sbi_attest_enclave_mac(void* tag, void* buf, uintptr_t len, void* peer_public_key) {
+  return SBI_CALL_5(SBI_EXT_EXPERIMENTAL_KEYSTONE_ENCLAVE, SBI_SM_ATTEST_MAC, tag, buf, len, peer_public_key, 0);
+}
+
 uintptr_t
 sbi_get_sealing_key(uintptr_t key_struct, uintptr_t key_ident, uintptr_t len) {
   return SBI_CALL_3(SBI_EXT_EXPERIMENTAL_KEYSTONE_ENCLAVE, SBI_SM_GET_SEALING_KEY, key_struct, key_ident, len);
@@ -0,0 +1,50 @@
+#include "call/sealing.h"
+#include "util/string.h"
+
+struct sealing_cache_entry {
+  size_t ident_size;
+  unsigned char ident[SEALING_CACHE_IDENT_MAX];
+  unsigned char key[SEALING_KEY_STRUCT_SIZE];
+};
+
+static struct sealing_cache_entry sealing_cache[SEALING_CACHE_ENTRIES];
+static unsigned int sealing_cache_used;
+static unsigned int sealing_cache_next;
+
+int sealing_cache_lookup(void* key, const void* ident, size_t ident_size)
+{
+  unsigned int i;
+
+  if (ident_size > SEALING_CACHE_IDENT_MAX)
+    return 0;
+
+  for (i = 0; i < sealing_cache_used; i++) {
+    struct sealing_cache_entry* entry = &sealing_cache[i];
+
+    if (entry->ident_size == ident_size &&
+        !memcmp(entry->ident, ident, ident_size)) {
+      memcpy(key, entry->key, SEALING_KEY_STRUCT_SIZE);
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+void sealing_cache_insert(const void* key, const void* ident, size_t ident_size)
+{
+  struct sealing_cache_entry* entry;
+
+  if (ident_size > SEALING_CACHE_IDENT_MAX)
+    return;
+
+  /* round-robin once full */
+  entry = &sealing_cache[sealing_cache_next];
+  sealing_cache_next = (sealing_cache_next + 1) % SEALING_CACHE_ENTRIES;
+  if (sealing_cache_used < SEALING_CACHE_ENTRIES)
+    sealing_cache_used++;
+
+  entry->ident_size = ident_size;
+  memcpy(entry->ident, ident, ident_size);
+  memcpy(entry->key, key, SEALING_KEY_STRUCT_SIZE);
+}
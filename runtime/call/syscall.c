@@ -11,6 +11,7 @@
 #include "uaccess.h"
 #include "mm/mm.h"
 #include "util/rt_util.h"
+#include "call/sealing.h"
 
 #include "call/syscall_nums.h"
 
@@ -127,6 +128,66 @@ uintptr_t dispatch_edgecall_ocall( unsigned long call_id,
   return 1;
 }
 
+/* Like dispatch_edgecall_ocall(), but the arguments and results are lists
+ * of segments in user memory. IN segments are copied straight into the
+ * shared buffer and OUT segments straight back out of it, so nothing is
+ * staged in between. The layout is checked against the buffer once, before
+ * anything is copied. */
+uintptr_t dispatch_edgecall_ocall_v(unsigned long call_id,
+                                    struct edge_iovec* user_iov, size_t count){
+  struct edge_iovec iov[EDGE_IOV_MAX];
+  struct edge_call* edge_call = (struct edge_call*)shared_buffer;
+  uintptr_t buffer_data_start = edge_call_data_ptr();
+  size_t avail = shared_buffer_size - (buffer_data_start - shared_buffer);
+  size_t pos[EDGE_IOV_MAX];
+  size_t off = 0;
+  size_t i;
+
+  if(count > EDGE_IOV_MAX){
+    goto ocall_error;
+  }
+  copy_from_user(iov, user_iov, count * sizeof(struct edge_iovec));
+
+  for(i = 0; i < count; i++){
+    off = EDGE_IOV_ALIGN_UP(off);
+    if(off > avail || iov[i].len > avail - off){
+      goto ocall_error;
+    }
+    pos[i] = off;
+    off += iov[i].len;
+  }
+
+  for(i = 0; i < count; i++){
+    if(iov[i].flags & EDGE_IOV_IN){
+      copy_from_user((void*)(buffer_data_start + pos[i]), iov[i].base, iov[i].len);
+    }
+  }
+
+  edge_call->call_id = call_id;
+  if(edge_call_setup_call(edge_call, (void*)buffer_data_start, off) != 0){
+    goto ocall_error;
+  }
+
+  if(sbi_stop_enclave(STOP_EDGE_CALL_HOST) != 0){
+    goto ocall_error;
+  }
+
+  if(edge_call->return_data.call_status != CALL_STATUS_OK){
+    goto ocall_error;
+  }
+
+  for(i = 0; i < count; i++){
+    if(iov[i].flags & EDGE_IOV_OUT){
+      copy_to_user(iov[i].base, (void*)(buffer_data_start + pos[i]), iov[i].len);
+    }
+  }
+
+  return 0;
+
+ ocall_error:
+  return 1;
+}
+
 uintptr_t handle_copy_from_shared(void* dst, uintptr_t offset, size_t size){
 
   /* This is where we would handle cache side channels for a given
@@ -171,19 +232,41 @@ void handle_syscall(struct encl_ctx* ctx)
   case(RUNTIME_SYSCALL_OCALL):
     ret = dispatch_edgecall_ocall(arg0, (void*)arg1, arg2, (void*)arg3, arg4);
     break;
+  case(RUNTIME_SYSCALL_OCALL_V):
+    ret = dispatch_edgecall_ocall_v(arg0, (struct edge_iovec*)arg1, arg2);
+    break;
   case(RUNTIME_SYSCALL_SHAREDCOPY):
     ret = handle_copy_from_shared((void*)arg0, arg1, arg2);
     break;
   case(RUNTIME_SYSCALL_ATTEST_ENCLAVE):;
+    if (arg2 > sizeof(rt_copy_buffer_2)) {
+      ret = -1;
+      break;
+    }
+
     copy_from_user((void*)rt_copy_buffer_2, (void*)arg1, arg2); // nonce in rt_copy_buffer_2
-    if (arg3 && arg4)
-      copy_from_user((void*)rt_copy_buffer_1, (void*)arg3, arg4); // copy the log from enclave to rt_copy_buffer_1
-    ret = sbi_attest_enclave(rt_copy_buffer_1, rt_copy_buffer_2, arg2, rt_copy_buffer_1, arg4); // result in rt_copy_buffer_1, nonce in rt_copy_buffer_2, size of nonce in arg2
+    /* the SM hashes the log straight out of user memory, in place */
+    ALLOW_USER_ACCESS(ret = sbi_attest_enclave(rt_copy_buffer_1, rt_copy_buffer_2, arg2, (void*)arg3, arg4)); // result in rt_copy_buffer_1, nonce in rt_copy_buffer_2, size of nonce in arg2
 
-    /* TODO we consistently don't have report size when we need it */
-    copy_to_user((void*)arg0, (void*)rt_copy_buffer_1, 4096);
+    if (!ret) {
+      copy_to_user((void*)arg0, (void*)rt_copy_buffer_1, ATTEST_REPORT_SIZE);
+    }
     //print_strace("[ATTEST] p1 0x%p->0x%p p2 0x%p->0x%p sz %lx = %lu\r\n",arg0,arg0_trans,arg1,arg1_trans,arg2,ret);
     break;
+  case(RUNTIME_SYSCALL_ATTEST_MAC):;
+    if (arg2 > sizeof(rt_copy_buffer_2)) {
+      ret = -1;
+      break;
+    }
+
+    copy_from_user((void*)rt_copy_buffer_2, (void*)arg1, arg2); // challenge in rt_copy_buffer_2
+    copy_from_user((void*)rt_copy_buffer_1, (void*)arg3, ATTEST_MAC_PEER_SIZE); // verifier key in rt_copy_buffer_1
+    ret = sbi_attest_enclave_mac(rt_copy_buffer_1, rt_copy_buffer_2, arg2, rt_copy_buffer_1); // tag in rt_copy_buffer_1
+
+    if (!ret) {
+      copy_to_user((void*)arg0, (void*)rt_copy_buffer_1, ATTEST_MAC_SIZE);
+    }
+    break;
   case(RUNTIME_SYSCALL_GET_SEALING_KEY):;
     /* Stores the key receive structure */
     uintptr_t buffer_1_pa = translate((uintptr_t) rt_copy_buffer_1);
@@ -199,7 +282,13 @@ void handle_syscall(struct encl_ctx* ctx)
 
     copy_from_user(rt_copy_buffer_2, (void *)arg2, arg3);
 
-    ret = sbi_get_sealing_key(buffer_1_pa, buffer_2_pa, arg3);
+    if (sealing_cache_lookup(rt_copy_buffer_1, rt_copy_buffer_2, arg3)) {
+      ret = 0;
+    } else {
+      ret = sbi_get_sealing_key(buffer_1_pa, buffer_2_pa, arg3);
+      if (!ret)
+        sealing_cache_insert(rt_copy_buffer_1, rt_copy_buffer_2, arg3);
+    }
 
     if (!ret) {
       copy_to_user((void *)arg0, (void *)rt_copy_buffer_1, arg1);
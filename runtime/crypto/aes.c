@@ -6,7 +6,7 @@
 * Copyright:
 * Disclaimer: This code is presented "as is" without any guarantees.
 * Details:    This code is the implementation of the AES algorithm and
-              the CTR, CBC, and CCM modes of operation it can be used in.
+              the CTR, CBC, CCM and GCM modes of operation it can be used in.
                AES is, specified by the NIST in in publication FIPS PUB 197,
               availible at:
                * http://csrc.nist.gov/publications/fips/fips197/fips-197.pdf .
@@ -16,6 +16,7 @@
               The CCM mode of operation is specified by NIST SP80-38 C,
 available at:
                * http://csrc.nist.gov/publications/nistpubs/800-38C/SP800-38C_updated-July20_2007.pdf
+              The GCM mode of operation is specified by NIST SP800-38D.
 *********************************************************************/
 
 /*************************** HEADER FILES ***************************/
@@ -28,6 +29,18 @@ available at:
 /****************************** MACROS ******************************/
 // The least significant byte of the word is rotated to the end.
 #define KE_ROTWORD(x) (((x) << 8) | ((x) >> 24))
+#define ROTR_WORD(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+#define GET_WORD(b)                                                  \
+  (((WORD)(b)[0] << 24) | ((WORD)(b)[1] << 16) | ((WORD)(b)[2] << 8) | \
+   ((WORD)(b)[3]))
+#define PUT_WORD(b, w)          \
+  do {                          \
+    (b)[0] = (BYTE)((w) >> 24); \
+    (b)[1] = (BYTE)((w) >> 16); \
+    (b)[2] = (BYTE)((w) >> 8);  \
+    (b)[3] = (BYTE)(w);         \
+  } while (0)
 
 #define TRUE 1
 #define FALSE 0
@@ -110,7 +123,7 @@ static const BYTE aes_invsbox[16][16] = {
      0x55, 0x21, 0x0C, 0x7D}};
 
 // This table stores pre-calculated values for all possible GF(2^8)
-// calculations.This table is only used by the (Inv)MixColumns steps. USAGE: The
+// calculations.This table is only used by the InvMixColumns step. USAGE: The
 // second index (column) is the coefficient of multiplication. Only 7 different
 // coefficients are used: 0x01, 0x02, 0x03, 0x09, 0x0b, 0x0d, 0x0e, but
 // multiplication by 1 is negligible leaving only 6 coefficients. Each column of
@@ -246,6 +259,55 @@ static const BYTE gf_mul[256][6] = {
     {0xe3, 0x1f, 0x5d, 0xbe, 0x80, 0x9f}, {0xe1, 0x1c, 0x54, 0xb5, 0x8d, 0x91},
     {0xe7, 0x19, 0x4f, 0xa8, 0x9a, 0x83}, {0xe5, 0x1a, 0x46, 0xa3, 0x97, 0x8d}};
 
+// SubBytes, ShiftRows and MixColumns of one column folded into a single
+// lookup: each entry is the S-box output multiplied by the MixColumns column
+// (02, 01, 01, 03). The other three columns are byte rotations of this one.
+static const WORD aes_te0[256] = {
+    0xc66363a5, 0xf87c7c84, 0xee777799, 0xf67b7b8d, 0xfff2f20d, 0xd66b6bbd,
+    0xde6f6fb1, 0x91c5c554, 0x60303050, 0x02010103, 0xce6767a9, 0x562b2b7d,
+    0xe7fefe19, 0xb5d7d762, 0x4dababe6, 0xec76769a, 0x8fcaca45, 0x1f82829d,
+    0x89c9c940, 0xfa7d7d87, 0xeffafa15, 0xb25959eb, 0x8e4747c9, 0xfbf0f00b,
+    0x41adadec, 0xb3d4d467, 0x5fa2a2fd, 0x45afafea, 0x239c9cbf, 0x53a4a4f7,
+    0xe4727296, 0x9bc0c05b, 0x75b7b7c2, 0xe1fdfd1c, 0x3d9393ae, 0x4c26266a,
+    0x6c36365a, 0x7e3f3f41, 0xf5f7f702, 0x83cccc4f, 0x6834345c, 0x51a5a5f4,
+    0xd1e5e534, 0xf9f1f108, 0xe2717193, 0xabd8d873, 0x62313153, 0x2a15153f,
+    0x0804040c, 0x95c7c752, 0x46232365, 0x9dc3c35e, 0x30181828, 0x379696a1,
+    0x0a05050f, 0x2f9a9ab5, 0x0e070709, 0x24121236, 0x1b80809b, 0xdfe2e23d,
+    0xcdebeb26, 0x4e272769, 0x7fb2b2cd, 0xea75759f, 0x1209091b, 0x1d83839e,
+    0x582c2c74, 0x341a1a2e, 0x361b1b2d, 0xdc6e6eb2, 0xb45a5aee, 0x5ba0a0fb,
+    0xa45252f6, 0x763b3b4d, 0xb7d6d661, 0x7db3b3ce, 0x5229297b, 0xdde3e33e,
+    0x5e2f2f71, 0x13848497, 0xa65353f5, 0xb9d1d168, 0x00000000, 0xc1eded2c,
+    0x40202060, 0xe3fcfc1f, 0x79b1b1c8, 0xb65b5bed, 0xd46a6abe, 0x8dcbcb46,
+    0x67bebed9, 0x7239394b, 0x944a4ade, 0x984c4cd4, 0xb05858e8, 0x85cfcf4a,
+    0xbbd0d06b, 0xc5efef2a, 0x4faaaae5, 0xedfbfb16, 0x864343c5, 0x9a4d4dd7,
+    0x66333355, 0x11858594, 0x8a4545cf, 0xe9f9f910, 0x04020206, 0xfe7f7f81,
+    0xa05050f0, 0x783c3c44, 0x259f9fba, 0x4ba8a8e3, 0xa25151f3, 0x5da3a3fe,
+    0x804040c0, 0x058f8f8a, 0x3f9292ad, 0x219d9dbc, 0x70383848, 0xf1f5f504,
+    0x63bcbcdf, 0x77b6b6c1, 0xafdada75, 0x42212163, 0x20101030, 0xe5ffff1a,
+    0xfdf3f30e, 0xbfd2d26d, 0x81cdcd4c, 0x180c0c14, 0x26131335, 0xc3ecec2f,
+    0xbe5f5fe1, 0x359797a2, 0x884444cc, 0x2e171739, 0x93c4c457, 0x55a7a7f2,
+    0xfc7e7e82, 0x7a3d3d47, 0xc86464ac, 0xba5d5de7, 0x3219192b, 0xe6737395,
+    0xc06060a0, 0x19818198, 0x9e4f4fd1, 0xa3dcdc7f, 0x44222266, 0x542a2a7e,
+    0x3b9090ab, 0x0b888883, 0x8c4646ca, 0xc7eeee29, 0x6bb8b8d3, 0x2814143c,
+    0xa7dede79, 0xbc5e5ee2, 0x160b0b1d, 0xaddbdb76, 0xdbe0e03b, 0x64323256,
+    0x743a3a4e, 0x140a0a1e, 0x924949db, 0x0c06060a, 0x4824246c, 0xb85c5ce4,
+    0x9fc2c25d, 0xbdd3d36e, 0x43acacef, 0xc46262a6, 0x399191a8, 0x319595a4,
+    0xd3e4e437, 0xf279798b, 0xd5e7e732, 0x8bc8c843, 0x6e373759, 0xda6d6db7,
+    0x018d8d8c, 0xb1d5d564, 0x9c4e4ed2, 0x49a9a9e0, 0xd86c6cb4, 0xac5656fa,
+    0xf3f4f407, 0xcfeaea25, 0xca6565af, 0xf47a7a8e, 0x47aeaee9, 0x10080818,
+    0x6fbabad5, 0xf0787888, 0x4a25256f, 0x5c2e2e72, 0x381c1c24, 0x57a6a6f1,
+    0x73b4b4c7, 0x97c6c651, 0xcbe8e823, 0xa1dddd7c, 0xe874749c, 0x3e1f1f21,
+    0x964b4bdd, 0x61bdbddc, 0x0d8b8b86, 0x0f8a8a85, 0xe0707090, 0x7c3e3e42,
+    0x71b5b5c4, 0xcc6666aa, 0x904848d8, 0x06030305, 0xf7f6f601, 0x1c0e0e12,
+    0xc26161a3, 0x6a35355f, 0xae5757f9, 0x69b9b9d0, 0x17868691, 0x99c1c158,
+    0x3a1d1d27, 0x279e9eb9, 0xd9e1e138, 0xebf8f813, 0x2b9898b3, 0x22111133,
+    0xd26969bb, 0xa9d9d970, 0x078e8e89, 0x339494a7, 0x2d9b9bb6, 0x3c1e1e22,
+    0x15878792, 0xc9e9e920, 0x87cece49, 0xaa5555ff, 0x50282878, 0xa5dfdf7a,
+    0x038c8c8f, 0x59a1a1f8, 0x09898980, 0x1a0d0d17, 0x65bfbfda, 0xd7e6e631,
+    0x844242c6, 0xd06868b8, 0x824141c3, 0x299999b0, 0x5a2d2d77, 0x1e0f0f11,
+    0x7bb0b0cb, 0xa85454fc, 0x6dbbbbd6, 0x2c16163a,
+};
+
 /*********************** FUNCTION DEFINITIONS ***********************/
 // XORs the in and out buffers, storing the result in out. Length is in bytes.
 void
@@ -381,6 +443,160 @@ aes_decrypt_ctr(
   aes_encrypt_ctr(in, in_len, out, key, keysize, iv);
 }
 
+/*******************
+ * AES - GCM
+ *******************/
+// Reduction constants for shifting a GHASH value right by four bits.
+static const uint64_t gcm_last4[16] = {
+    0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+    0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0};
+
+static uint64_t
+gcm_get_u64(const BYTE b[]) {
+  return ((uint64_t)GET_WORD(b) << 32) | GET_WORD(b + 4);
+}
+
+static void
+gcm_put_u64(BYTE b[], uint64_t v) {
+  PUT_WORD(b, (WORD)(v >> 32));
+  PUT_WORD(b + 4, (WORD)v);
+}
+
+// x = x * H in GF(2^128), four bits at a time (Shoup's method) using the
+// multiples of H from aes_gcm_setup.
+static void
+gcm_mult(const AES_GCM_CTX* ctx, BYTE x[]) {
+  uint64_t zh, zl;
+  BYTE lo, hi, rem;
+  int idx;
+
+  lo = x[15] & 0x0f;
+  zh = ctx->hh[lo];
+  zl = ctx->hl[lo];
+
+  for (idx = 15; idx >= 0; idx--) {
+    lo = x[idx] & 0x0f;
+    hi = x[idx] >> 4;
+
+    if (idx != 15) {
+      rem = (BYTE)zl & 0x0f;
+      zl  = (zh << 60) | (zl >> 4);
+      zh  = (zh >> 4) ^ (gcm_last4[rem] << 48) ^ ctx->hh[lo];
+      zl ^= ctx->hl[lo];
+    }
+
+    rem = (BYTE)zl & 0x0f;
+    zl  = (zh << 60) | (zl >> 4);
+    zh  = (zh >> 4) ^ (gcm_last4[rem] << 48) ^ ctx->hh[hi];
+    zl ^= ctx->hl[hi];
+  }
+
+  gcm_put_u64(x, zh);
+  gcm_put_u64(x + 8, zl);
+}
+
+// Absorbs len bytes into the GHASH state y, zero padding the last block.
+static void
+gcm_ghash(const AES_GCM_CTX* ctx, BYTE y[], const BYTE in[], size_t len) {
+  while (len >= AES_BLOCK_SIZE) {
+    xor_buf(in, y, AES_BLOCK_SIZE);
+    gcm_mult(ctx, y);
+    in += AES_BLOCK_SIZE;
+    len -= AES_BLOCK_SIZE;
+  }
+  if (len) {
+    xor_buf(in, y, len);
+    gcm_mult(ctx, y);
+  }
+}
+
+void
+aes_gcm_setup(AES_GCM_CTX* ctx, const BYTE key[], int keysize) {
+  BYTE h[AES_BLOCK_SIZE] = {0};
+  uint64_t vh, vl;
+  int i, j;
+
+  aes_key_setup(key, ctx->key, keysize);
+  ctx->keysize = keysize;
+
+  // H = E(K, 0^128); hh/hl hold i * H for every 4-bit i
+  aes_encrypt(h, h, ctx->key, keysize);
+  vh = gcm_get_u64(h);
+  vl = gcm_get_u64(h + 8);
+
+  ctx->hh[0] = 0;
+  ctx->hl[0] = 0;
+  ctx->hh[8] = vh;
+  ctx->hl[8] = vl;
+
+  for (i = 4; i > 0; i >>= 1) {
+    uint64_t t = (vl & 1) * 0xe1000000;
+    vl         = (vh << 63) | (vl >> 1);
+    vh         = (vh >> 1) ^ (t << 32);
+    ctx->hh[i] = vh;
+    ctx->hl[i] = vl;
+  }
+
+  for (i = 2; i <= 8; i *= 2) {
+    for (j = 1; j < i; j++) {
+      ctx->hh[i + j] = ctx->hh[i] ^ ctx->hh[j];
+      ctx->hl[i + j] = ctx->hl[i] ^ ctx->hl[j];
+    }
+  }
+}
+
+// Shared by encryption and decryption: CTR over in, GHASH over the
+// ciphertext side (out when encrypting, in when decrypting). Each block is
+// hashed and en/decrypted in the same pass.
+static void
+gcm_crypt(
+    const AES_GCM_CTX* ctx, const BYTE iv[], const BYTE aad[], size_t aad_len,
+    const BYTE in[], size_t in_len, BYTE out[], BYTE tag[], int decrypt) {
+  BYTE j0[AES_BLOCK_SIZE], ctr[AES_BLOCK_SIZE], ks[AES_BLOCK_SIZE];
+  BYTE y[AES_BLOCK_SIZE] = {0};
+  BYTE lens[AES_BLOCK_SIZE];
+  size_t idx, blk;
+
+  memcpy(j0, iv, AES_GCM_IV_SIZE);
+  PUT_WORD(j0 + AES_GCM_IV_SIZE, 1);
+  memcpy(ctr, j0, AES_BLOCK_SIZE);
+
+  gcm_ghash(ctx, y, aad, aad_len);
+
+  for (idx = 0; idx < in_len; idx += blk) {
+    blk = in_len - idx < AES_BLOCK_SIZE ? in_len - idx : AES_BLOCK_SIZE;
+
+    increment_iv(ctr, 4);
+    aes_encrypt(ctr, ks, ctx->key, ctx->keysize);
+
+    if (decrypt) gcm_ghash(ctx, y, &in[idx], blk);
+    if (in != out) memcpy(&out[idx], &in[idx], blk);
+    xor_buf(ks, &out[idx], blk);
+    if (!decrypt) gcm_ghash(ctx, y, &out[idx], blk);
+  }
+
+  gcm_put_u64(lens, (uint64_t)aad_len * 8);
+  gcm_put_u64(lens + 8, (uint64_t)in_len * 8);
+  gcm_ghash(ctx, y, lens, AES_BLOCK_SIZE);
+
+  aes_encrypt(j0, tag, ctx->key, ctx->keysize);
+  xor_buf(y, tag, AES_BLOCK_SIZE);
+}
+
+void
+aes_encrypt_gcm(
+    const AES_GCM_CTX* ctx, const BYTE iv[], const BYTE aad[], size_t aad_len,
+    const BYTE in[], size_t in_len, BYTE out[], BYTE tag[]) {
+  gcm_crypt(ctx, iv, aad, aad_len, in, in_len, out, tag, FALSE);
+}
+
+void
+aes_decrypt_gcm(
+    const AES_GCM_CTX* ctx, const BYTE iv[], const BYTE aad[], size_t aad_len,
+    const BYTE in[], size_t in_len, BYTE out[], BYTE tag[]) {
+  gcm_crypt(ctx, iv, aad, aad_len, in, in_len, out, tag, TRUE);
+}
+
 /*******************
  * AES
  *******************/
@@ -498,31 +714,9 @@ AddRoundKey(BYTE state[][4], const WORD w[]) {
 }
 
 /////////////////
-// (Inv)SubBytes
+// InvSubBytes
 /////////////////
 
-// Performs the SubBytes step. All bytes in the state are substituted with a
-// pre-calculated value from a lookup table.
-void
-SubBytes(BYTE state[][4]) {
-  state[0][0] = aes_sbox[state[0][0] >> 4][state[0][0] & 0x0F];
-  state[0][1] = aes_sbox[state[0][1] >> 4][state[0][1] & 0x0F];
-  state[0][2] = aes_sbox[state[0][2] >> 4][state[0][2] & 0x0F];
-  state[0][3] = aes_sbox[state[0][3] >> 4][state[0][3] & 0x0F];
-  state[1][0] = aes_sbox[state[1][0] >> 4][state[1][0] & 0x0F];
-  state[1][1] = aes_sbox[state[1][1] >> 4][state[1][1] & 0x0F];
-  state[1][2] = aes_sbox[state[1][2] >> 4][state[1][2] & 0x0F];
-  state[1][3] = aes_sbox[state[1][3] >> 4][state[1][3] & 0x0F];
-  state[2][0] = aes_sbox[state[2][0] >> 4][state[2][0] & 0x0F];
-  state[2][1] = aes_sbox[state[2][1] >> 4][state[2][1] & 0x0F];
-  state[2][2] = aes_sbox[state[2][2] >> 4][state[2][2] & 0x0F];
-  state[2][3] = aes_sbox[state[2][3] >> 4][state[2][3] & 0x0F];
-  state[3][0] = aes_sbox[state[3][0] >> 4][state[3][0] & 0x0F];
-  state[3][1] = aes_sbox[state[3][1] >> 4][state[3][1] & 0x0F];
-  state[3][2] = aes_sbox[state[3][2] >> 4][state[3][2] & 0x0F];
-  state[3][3] = aes_sbox[state[3][3] >> 4][state[3][3] & 0x0F];
-}
-
 void
 InvSubBytes(BYTE state[][4]) {
   state[0][0] = aes_invsbox[state[0][0] >> 4][state[0][0] & 0x0F];
@@ -544,35 +738,9 @@ InvSubBytes(BYTE state[][4]) {
 }
 
 /////////////////
-// (Inv)ShiftRows
+// InvShiftRows
 /////////////////
 
-// Performs the ShiftRows step. All rows are shifted cylindrically to the left.
-void
-ShiftRows(BYTE state[][4]) {
-  int t;
-
-  // Shift left by 1
-  t           = state[1][0];
-  state[1][0] = state[1][1];
-  state[1][1] = state[1][2];
-  state[1][2] = state[1][3];
-  state[1][3] = t;
-  // Shift left by 2
-  t           = state[2][0];
-  state[2][0] = state[2][2];
-  state[2][2] = t;
-  t           = state[2][1];
-  state[2][1] = state[2][3];
-  state[2][3] = t;
-  // Shift left by 3
-  t           = state[3][0];
-  state[3][0] = state[3][3];
-  state[3][3] = state[3][2];
-  state[3][2] = state[3][1];
-  state[3][1] = t;
-}
-
 // All rows are shifted cylindrically to the right.
 void
 InvShiftRows(BYTE state[][4]) {
@@ -600,103 +768,9 @@ InvShiftRows(BYTE state[][4]) {
 }
 
 /////////////////
-// (Inv)MixColumns
+// InvMixColumns
 /////////////////
 
-// Performs the MixColums step. The state is multiplied by itself using matrix
-// multiplication in a Galios Field 2^8. All multiplication is pre-computed in a
-// table. Addition is equivilent to XOR. (Must always make a copy of the column
-// as the original values will be destoyed.)
-void
-MixColumns(BYTE state[][4]) {
-  BYTE col[4];
-
-  // Column 1
-  col[0]      = state[0][0];
-  col[1]      = state[1][0];
-  col[2]      = state[2][0];
-  col[3]      = state[3][0];
-  state[0][0] = gf_mul[col[0]][0];
-  state[0][0] ^= gf_mul[col[1]][1];
-  state[0][0] ^= col[2];
-  state[0][0] ^= col[3];
-  state[1][0] = col[0];
-  state[1][0] ^= gf_mul[col[1]][0];
-  state[1][0] ^= gf_mul[col[2]][1];
-  state[1][0] ^= col[3];
-  state[2][0] = col[0];
-  state[2][0] ^= col[1];
-  state[2][0] ^= gf_mul[col[2]][0];
-  state[2][0] ^= gf_mul[col[3]][1];
-  state[3][0] = gf_mul[col[0]][1];
-  state[3][0] ^= col[1];
-  state[3][0] ^= col[2];
-  state[3][0] ^= gf_mul[col[3]][0];
-  // Column 2
-  col[0]      = state[0][1];
-  col[1]      = state[1][1];
-  col[2]      = state[2][1];
-  col[3]      = state[3][1];
-  state[0][1] = gf_mul[col[0]][0];
-  state[0][1] ^= gf_mul[col[1]][1];
-  state[0][1] ^= col[2];
-  state[0][1] ^= col[3];
-  state[1][1] = col[0];
-  state[1][1] ^= gf_mul[col[1]][0];
-  state[1][1] ^= gf_mul[col[2]][1];
-  state[1][1] ^= col[3];
-  state[2][1] = col[0];
-  state[2][1] ^= col[1];
-  state[2][1] ^= gf_mul[col[2]][0];
-  state[2][1] ^= gf_mul[col[3]][1];
-  state[3][1] = gf_mul[col[0]][1];
-  state[3][1] ^= col[1];
-  state[3][1] ^= col[2];
-  state[3][1] ^= gf_mul[col[3]][0];
-  // Column 3
-  col[0]      = state[0][2];
-  col[1]      = state[1][2];
-  col[2]      = state[2][2];
-  col[3]      = state[3][2];
-  state[0][2] = gf_mul[col[0]][0];
-  state[0][2] ^= gf_mul[col[1]][1];
-  state[0][2] ^= col[2];
-  state[0][2] ^= col[3];
-  state[1][2] = col[0];
-  state[1][2] ^= gf_mul[col[1]][0];
-  state[1][2] ^= gf_mul[col[2]][1];
-  state[1][2] ^= col[3];
-  state[2][2] = col[0];
-  state[2][2] ^= col[1];
-  state[2][2] ^= gf_mul[col[2]][0];
-  state[2][2] ^= gf_mul[col[3]][1];
-  state[3][2] = gf_mul[col[0]][1];
-  state[3][2] ^= col[1];
-  state[3][2] ^= col[2];
-  state[3][2] ^= gf_mul[col[3]][0];
-  // Column 4
-  col[0]      = state[0][3];
-  col[1]      = state[1][3];
-  col[2]      = state[2][3];
-  col[3]      = state[3][3];
-  state[0][3] = gf_mul[col[0]][0];
-  state[0][3] ^= gf_mul[col[1]][1];
-  state[0][3] ^= col[2];
-  state[0][3] ^= col[3];
-  state[1][3] = col[0];
-  state[1][3] ^= gf_mul[col[1]][0];
-  state[1][3] ^= gf_mul[col[2]][1];
-  state[1][3] ^= col[3];
-  state[2][3] = col[0];
-  state[2][3] ^= col[1];
-  state[2][3] ^= gf_mul[col[2]][0];
-  state[2][3] ^= gf_mul[col[3]][1];
-  state[3][3] = gf_mul[col[0]][1];
-  state[3][3] ^= col[1];
-  state[3][3] ^= col[2];
-  state[3][3] ^= gf_mul[col[3]][0];
-}
-
 void
 InvMixColumns(BYTE state[][4]) {
   BYTE col[4];
@@ -791,121 +865,54 @@ InvMixColumns(BYTE state[][4]) {
 // (En/De)Crypt
 /////////////////
 
+// Encrypts one block with the column tables above. The state is kept as four
+// big-endian column words, which is also the layout of the key schedule.
 void
 aes_encrypt(const BYTE in[], BYTE out[], const WORD key[], int keysize) {
-  BYTE state[4][4];
-
-  // Copy input array (should be 16 bytes long) to a matrix (sequential bytes
-  // are ordered by row, not col) called "state" for processing.
-  // *** Implementation note: The official AES documentation references the
-  // state by column, then row. Accessing an element in C requires row then
-  // column. Thus, all state references in AES must have the column and row
-  // indexes reversed for C implementation.
-  state[0][0] = in[0];
-  state[1][0] = in[1];
-  state[2][0] = in[2];
-  state[3][0] = in[3];
-  state[0][1] = in[4];
-  state[1][1] = in[5];
-  state[2][1] = in[6];
-  state[3][1] = in[7];
-  state[0][2] = in[8];
-  state[1][2] = in[9];
-  state[2][2] = in[10];
-  state[3][2] = in[11];
-  state[0][3] = in[12];
-  state[1][3] = in[13];
-  state[2][3] = in[14];
-  state[3][3] = in[15];
-
-  // Perform the necessary number of rounds. The round key is added first.
-  // The last round does not perform the MixColumns step.
-  AddRoundKey(state, &key[0]);
-  SubBytes(state);
-  ShiftRows(state);
-  MixColumns(state);
-  AddRoundKey(state, &key[4]);
-  SubBytes(state);
-  ShiftRows(state);
-  MixColumns(state);
-  AddRoundKey(state, &key[8]);
-  SubBytes(state);
-  ShiftRows(state);
-  MixColumns(state);
-  AddRoundKey(state, &key[12]);
-  SubBytes(state);
-  ShiftRows(state);
-  MixColumns(state);
-  AddRoundKey(state, &key[16]);
-  SubBytes(state);
-  ShiftRows(state);
-  MixColumns(state);
-  AddRoundKey(state, &key[20]);
-  SubBytes(state);
-  ShiftRows(state);
-  MixColumns(state);
-  AddRoundKey(state, &key[24]);
-  SubBytes(state);
-  ShiftRows(state);
-  MixColumns(state);
-  AddRoundKey(state, &key[28]);
-  SubBytes(state);
-  ShiftRows(state);
-  MixColumns(state);
-  AddRoundKey(state, &key[32]);
-  SubBytes(state);
-  ShiftRows(state);
-  MixColumns(state);
-  AddRoundKey(state, &key[36]);
-  if (keysize != 128) {
-    SubBytes(state);
-    ShiftRows(state);
-    MixColumns(state);
-    AddRoundKey(state, &key[40]);
-    SubBytes(state);
-    ShiftRows(state);
-    MixColumns(state);
-    AddRoundKey(state, &key[44]);
-    if (keysize != 192) {
-      SubBytes(state);
-      ShiftRows(state);
-      MixColumns(state);
-      AddRoundKey(state, &key[48]);
-      SubBytes(state);
-      ShiftRows(state);
-      MixColumns(state);
-      AddRoundKey(state, &key[52]);
-      SubBytes(state);
-      ShiftRows(state);
-      AddRoundKey(state, &key[56]);
-    } else {
-      SubBytes(state);
-      ShiftRows(state);
-      AddRoundKey(state, &key[48]);
-    }
-  } else {
-    SubBytes(state);
-    ShiftRows(state);
-    AddRoundKey(state, &key[40]);
+  WORD s0, s1, s2, s3, t0, t1, t2, t3;
+  const BYTE* sbox = &aes_sbox[0][0];
+  int rounds       = keysize / 32 + 6;
+  int round;
+
+  s0 = GET_WORD(in) ^ key[0];
+  s1 = GET_WORD(in + 4) ^ key[1];
+  s2 = GET_WORD(in + 8) ^ key[2];
+  s3 = GET_WORD(in + 12) ^ key[3];
+
+#define TE(a, b, c, d)                                            \
+  (aes_te0[(a) >> 24] ^ ROTR_WORD(aes_te0[((b) >> 16) & 0xff], 8) ^ \
+   ROTR_WORD(aes_te0[((c) >> 8) & 0xff], 16) ^                      \
+   ROTR_WORD(aes_te0[(d)&0xff], 24))
+
+  for (round = 1; round < rounds; round++) {
+    key += 4;
+    t0 = TE(s0, s1, s2, s3) ^ key[0];
+    t1 = TE(s1, s2, s3, s0) ^ key[1];
+    t2 = TE(s2, s3, s0, s1) ^ key[2];
+    t3 = TE(s3, s0, s1, s2) ^ key[3];
+    s0 = t0;
+    s1 = t1;
+    s2 = t2;
+    s3 = t3;
   }
+#undef TE
 
-  // Copy the state to the output array.
-  out[0]  = state[0][0];
-  out[1]  = state[1][0];
-  out[2]  = state[2][0];
-  out[3]  = state[3][0];
-  out[4]  = state[0][1];
-  out[5]  = state[1][1];
-  out[6]  = state[2][1];
-  out[7]  = state[3][1];
-  out[8]  = state[0][2];
-  out[9]  = state[1][2];
-  out[10] = state[2][2];
-  out[11] = state[3][2];
-  out[12] = state[0][3];
-  out[13] = state[1][3];
-  out[14] = state[2][3];
-  out[15] = state[3][3];
+  // The last round does not perform the MixColumns step.
+#define SB(a, b, c, d)                                                  \
+  (((WORD)sbox[(a) >> 24] << 24) | ((WORD)sbox[((b) >> 16) & 0xff] << 16) | \
+   ((WORD)sbox[((c) >> 8) & 0xff] << 8) | ((WORD)sbox[(d)&0xff]))
+
+  key += 4;
+  t0 = SB(s0, s1, s2, s3) ^ key[0];
+  t1 = SB(s1, s2, s3, s0) ^ key[1];
+  t2 = SB(s2, s3, s0, s1) ^ key[2];
+  t3 = SB(s3, s0, s1, s2) ^ key[3];
+#undef SB
+
+  PUT_WORD(out, t0);
+  PUT_WORD(out + 4, t1);
+  PUT_WORD(out + 8, t2);
+  PUT_WORD(out + 12, t3);
 }
 
 void
@@ -0,0 +1,19 @@
+#ifndef _SEALING_H_
+#define _SEALING_H_
+
+#include <stddef.h>
+
+/* struct sealing_key as written by the SM: the key and its signature */
+#define SEALING_KEY_STRUCT_SIZE (128 + 64)
+
+#define SEALING_CACHE_ENTRIES   8
+#define SEALING_CACHE_IDENT_MAX 64
+
+/* Sealing keys only depend on the enclave hash and the key identifier, so
+ * the runtime keeps the last few around instead of asking the SM (which
+ * runs HKDF and signs the key) every time. Longer identifiers are never
+ * cached. */
+int sealing_cache_lookup(void* key, const void* ident, size_t ident_size);
+void sealing_cache_insert(const void* key, const void* ident, size_t ident_size);
+
+#endif /* _SEALING_H_ */
@@ -1,109 +1,153 @@
-/*********************************************************************
- * Filename:   aes.h
- * Author:     Brad Conte (brad AT bradconte.com)
- * Copyright:
- * Disclaimer: This code is presented "as is" without any guarantees.
- * Details:    Defines the API for the corresponding AES implementation.
- *********************************************************************/
-
-#ifndef AES_H
-#define AES_H
-
-/*************************** HEADER FILES ***************************/
-#include <stddef.h>
-
-/****************************** MACROS ******************************/
-#define AES_BLOCK_SIZE 16  // AES operates on 16 bytes at a time
-
-/**************************** DATA TYPES ****************************/
-typedef unsigned char BYTE;  // 8-bit byte
-typedef unsigned int WORD;  // 32-bit word, change to "long" for 16-bit machines
-
-/*********************** FUNCTION DECLARATIONS **********************/
-///////////////////
-// AES
-///////////////////
-// Key setup must be done before any AES en/de-cryption functions can be used.
-void
-aes_key_setup(
-    const BYTE key[],  // The key, must be 128, 192, or 256 bits
-    WORD w[],          // Output key schedule to be used later
-    int keysize);      // Bit length of the key, 128, 192, or 256
-
-void
-aes_encrypt(
-    const BYTE in[],   // 16 bytes of plaintext
-    BYTE out[],        // 16 bytes of ciphertext
-    const WORD key[],  // From the key setup
-    int keysize);      // Bit length of the key, 128, 192, or 256
-
-void
-aes_decrypt(
-    const BYTE in[],   // 16 bytes of ciphertext
-    BYTE out[],        // 16 bytes of plaintext
-    const WORD key[],  // From the key setup
-    int keysize);      // Bit length of the key, 128, 192, or 256
-
-///////////////////
-// AES - CBC
-///////////////////
-int
-aes_encrypt_cbc(
-    const BYTE in[],   // Plaintext
-    size_t in_len,     // Must be a multiple of AES_BLOCK_SIZE
-    BYTE out[],        // Ciphertext, same length as plaintext
-    const WORD key[],  // From the key setup
-    int keysize,       // Bit length of the key, 128, 192, or 256
-    const BYTE iv[]);  // IV, must be AES_BLOCK_SIZE bytes long
-
-// Only output the CBC-MAC of the input.
-int
-aes_encrypt_cbc_mac(
-    const BYTE in[],   // plaintext
-    size_t in_len,     // Must be a multiple of AES_BLOCK_SIZE
-    BYTE out[],        // Output MAC
-    const WORD key[],  // From the key setup
-    int keysize,       // Bit length of the key, 128, 192, or 256
-    const BYTE iv[]);  // IV, must be AES_BLOCK_SIZE bytes long
-
-///////////////////
-// AES - CTR
-///////////////////
-void
-increment_iv(
-    BYTE iv[],          // Must be a multiple of AES_BLOCK_SIZE
-    int counter_size);  // Bytes of the IV used for counting (low end)
-
-void
-aes_encrypt_ctr(
-    const BYTE in[],   // Plaintext
-    size_t in_len,     // Any byte length
-    BYTE out[],        // Ciphertext, same length as plaintext
-    const WORD key[],  // From the key setup
-    int keysize,       // Bit length of the key, 128, 192, or 256
-    const BYTE iv[]);  // IV, must be AES_BLOCK_SIZE bytes long
-
-void
-aes_decrypt_ctr(
-    const BYTE in[],   // Ciphertext
-    size_t in_len,     // Any byte length
-    BYTE out[],        // Plaintext, same length as ciphertext
-    const WORD key[],  // From the key setup
-    int keysize,       // Bit length of the key, 128, 192, or 256
-    const BYTE iv[]);  // IV, must be AES_BLOCK_SIZE bytes long
-
-///////////////////
-// Test functions
-///////////////////
-int
-aes_test();
-int
-aes_ecb_test();
-int
-aes_cbc_test();
-int
-aes_ctr_test();
-int
-aes_ccm_test();
-
-#endif  // AES_H
+/*********************************************************************
+ * Filename:   aes.h
+ * Author:     Brad Conte (brad AT bradconte.com)
+ * Copyright:
+ * Disclaimer: This code is presented "as is" without any guarantees.
+ * Details:    Defines the API for the corresponding AES implementation.
+ *********************************************************************/
+
+#ifndef AES_H
+#define AES_H
+
+/*************************** HEADER FILES ***************************/
+#include <stddef.h>
+#include <stdint.h>
+
+/****************************** MACROS ******************************/
+#define AES_BLOCK_SIZE 16  // AES operates on 16 bytes at a time
+#define AES_GCM_IV_SIZE 12  // GCM nonce length supported here (96 bits)
+
+/**************************** DATA TYPES ****************************/
+typedef unsigned char BYTE;  // 8-bit byte
+typedef unsigned int WORD;  // 32-bit word, change to "long" for 16-bit machines
+
+typedef struct {
+  WORD key[60];      // Key schedule
+  int keysize;       // Bit length of the key
+  uint64_t hh[16];   // Multiples of the GHASH key, high halves
+  uint64_t hl[16];   // Multiples of the GHASH key, low halves
+} AES_GCM_CTX;
+
+/*********************** FUNCTION DECLARATIONS **********************/
+///////////////////
+// AES
+///////////////////
+// Key setup must be done before any AES en/de-cryption functions can be used.
+void
+aes_key_setup(
+    const BYTE key[],  // The key, must be 128, 192, or 256 bits
+    WORD w[],          // Output key schedule to be used later
+    int keysize);      // Bit length of the key, 128, 192, or 256
+
+void
+aes_encrypt(
+    const BYTE in[],   // 16 bytes of plaintext
+    BYTE out[],        // 16 bytes of ciphertext
+    const WORD key[],  // From the key setup
+    int keysize);      // Bit length of the key, 128, 192, or 256
+
+void
+aes_decrypt(
+    const BYTE in[],   // 16 bytes of ciphertext
+    BYTE out[],        // 16 bytes of plaintext
+    const WORD key[],  // From the key setup
+    int keysize);      // Bit length of the key, 128, 192, or 256
+
+///////////////////
+// AES - CBC
+///////////////////
+int
+aes_encrypt_cbc(
+    const BYTE in[],   // Plaintext
+    size_t in_len,     // Must be a multiple of AES_BLOCK_SIZE
+    BYTE out[],        // Ciphertext, same length as plaintext
+    const WORD key[],  // From the key setup
+    int keysize,       // Bit length of the key, 128, 192, or 256
+    const BYTE iv[]);  // IV, must be AES_BLOCK_SIZE bytes long
+
+// Only output the CBC-MAC of the input.
+int
+aes_encrypt_cbc_mac(
+    const BYTE in[],   // plaintext
+    size_t in_len,     // Must be a multiple of AES_BLOCK_SIZE
+    BYTE out[],        // Output MAC
+    const WORD key[],  // From the key setup
+    int keysize,       // Bit length of the key, 128, 192, or 256
+    const BYTE iv[]);  // IV, must be AES_BLOCK_SIZE bytes long
+
+///////////////////
+// AES - CTR
+///////////////////
+void
+increment_iv(
+    BYTE iv[],          // Must be a multiple of AES_BLOCK_SIZE
+    int counter_size);  // Bytes of the IV used for counting (low end)
+
+void
+aes_encrypt_ctr(
+    const BYTE in[],   // Plaintext
+    size_t in_len,     // Any byte length
+    BYTE out[],        // Ciphertext, same length as plaintext
+    const WORD key[],  // From the key setup
+    int keysize,       // Bit length of the key, 128, 192, or 256
+    const BYTE iv[]);  // IV, must be AES_BLOCK_SIZE bytes long
+
+void
+aes_decrypt_ctr(
+    const BYTE in[],   // Ciphertext
+    size_t in_len,     // Any byte length
+    BYTE out[],        // Plaintext, same length as ciphertext
+    const WORD key[],  // From the key setup
+    int keysize,       // Bit length of the key, 128, 192, or 256
+    const BYTE iv[]);  // IV, must be AES_BLOCK_SIZE bytes long
+
+///////////////////
+// AES - GCM
+///////////////////
+// Expands the key and precomputes the GHASH tables. The context can then be
+// reused for any number of messages.
+void
+aes_gcm_setup(
+    AES_GCM_CTX* ctx,  // Output context
+    const BYTE key[],  // The key, must be 128, 192, or 256 bits
+    int keysize);      // Bit length of the key, 128, 192, or 256
+
+void
+aes_encrypt_gcm(
+    const AES_GCM_CTX* ctx,  // From aes_gcm_setup
+    const BYTE iv[],         // AES_GCM_IV_SIZE bytes, unique per message
+    const BYTE aad[],        // Authenticated, unencrypted data
+    size_t aad_len,          // Any byte length
+    const BYTE in[],         // Plaintext
+    size_t in_len,           // Any byte length
+    BYTE out[],              // Ciphertext, may be the same buffer as in
+    BYTE tag[]);             // Output tag, AES_BLOCK_SIZE bytes
+
+// Writes the tag computed over the ciphertext to tag. The caller compares it
+// with the expected tag before trusting out.
+void
+aes_decrypt_gcm(
+    const AES_GCM_CTX* ctx,  // From aes_gcm_setup
+    const BYTE iv[],         // AES_GCM_IV_SIZE bytes
+    const BYTE aad[],        // Authenticated, unencrypted data
+    size_t aad_len,          // Any byte length
+    const BYTE in[],         // Ciphertext
+    size_t in_len,           // Any byte length
+    BYTE out[],              // Plaintext, may be the same buffer as in
+    BYTE tag[]);             // Output tag, AES_BLOCK_SIZE bytes
+
+///////////////////
+// Test functions
+///////////////////
+int
+aes_test();
+int
+aes_ecb_test();
+int
+aes_cbc_test();
+int
+aes_ctr_test();
+int
+aes_ccm_test();
+
+#endif  // AES_H
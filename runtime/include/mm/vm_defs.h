@@ -29,6 +29,9 @@
 #define PAGE_UP(n) ROUND_UP(n, RISCV_PAGE_BITS)
 #define MEGAPAGE_DOWN(n) ROUND_DOWN(n, RISCV_GET_LVL_PGSIZE_BITS(2))
 #define MEGAPAGE_UP(n) ROUND_UP(n, RISCV_GET_LVL_PGSIZE_BITS(2))
+/* leaf size one level above a 4 KiB page */
+#define MEGAPAGE_BITS RISCV_GET_LVL_PGSIZE_BITS(RISCV_PT_LEVELS - 1)
+#define MEGAPAGE_SIZE BIT(MEGAPAGE_BITS)
 
 /* Starting address of the enclave memory */
 
@@ -27,10 +27,22 @@ void map_physical_memory(uintptr_t dram_base, uintptr_t dram_size) {
       ptr, load_l2_page_table_storage, load_l3_page_table_storage);
 }
 
+/* Large UTMs are mostly mapped with megapages, wherever the physical
+ * address lines up, so bulk I/O through the buffer does not thrash the TLB.
+ * A megapage slot that already holds a page table is filled with 4 KiB
+ * pages instead. */
 int map_untrusted_memory(uintptr_t untrusted_ptr, uintptr_t untrusted_size) {
   uintptr_t va        = EYRIE_UNTRUSTED_START;
-  while (va < EYRIE_UNTRUSTED_START + untrusted_size) {
-    if (!map_page(vpn(va), ppn(untrusted_ptr), PTE_W | PTE_R | PTE_D)) {
+  uintptr_t end       = EYRIE_UNTRUSTED_START + untrusted_size;
+  while (va < end) {
+    if (IS_ALIGNED(va, MEGAPAGE_BITS) && IS_ALIGNED(untrusted_ptr, MEGAPAGE_BITS) &&
+        end - va >= MEGAPAGE_SIZE &&
+        map_megapage(vpn(va), ppn(untrusted_ptr), PTE_W | PTE_R | PTE_D) == 1) {
+      va += MEGAPAGE_SIZE;
+      untrusted_ptr += MEGAPAGE_SIZE;
+      continue;
+    }
+    if (map_page(vpn(va), ppn(untrusted_ptr), PTE_W | PTE_R | PTE_D) != 1) {
       return -1;
     }
     va += RISCV_PAGE_SIZE;
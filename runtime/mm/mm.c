@@ -6,7 +6,7 @@
 
 /* Page table utilities */
 static pte*
-__walk_create(pte* root, uintptr_t addr);
+__walk_create(pte* root, uintptr_t addr, int level);
 
 /* Hacky storage of current u-mode break */
 static uintptr_t current_program_break;
@@ -22,32 +22,43 @@ void set_program_break(uintptr_t new_break)
 }
 
 static pte*
-__continue_walk_create(pte* root, uintptr_t addr, pte* pte)
+__continue_walk_create(pte* root, uintptr_t addr, pte* pte, int level)
 {
   uintptr_t new_page = spa_get_zero();
   assert(new_page);
 
   unsigned long free_ppn = ppn(__pa(new_page));
   *pte = ptd_create(free_ppn);
-  return __walk_create(root, addr);
+  return __walk_create(root, addr, level);
 }
 
+/* walk down to the PTE of the given level (RISCV_PT_LEVELS for 4 KiB pages)
+ * stops early at a superpage leaf, whose PTE then covers addr; the level of
+ * the returned PTE is stored in found if that is not NULL */
 static pte*
-__walk_internal(pte* root, uintptr_t addr, int create)
+__walk_internal(pte* root, uintptr_t addr, int create, int level, int* found)
 {
   pte* t = root;
   int i;
-  for (i = 1; i < RISCV_PT_LEVELS; i++)
+  for (i = 1; i < level; i++)
   {
     size_t idx = RISCV_GET_PT_INDEX(addr, i);
 
     if (!(t[idx] & PTE_V))
-      return create ? __continue_walk_create(root, addr, &t[idx]) : 0;
+      return create ? __continue_walk_create(root, addr, &t[idx], level) : 0;
+
+    if (t[idx] & (PTE_R | PTE_W | PTE_X)) {
+      if (found)
+        *found = i;
+      return &t[idx];
+    }
 
     t = (pte*) __va(pte_ppn(t[idx]) << RISCV_PAGE_BITS);
   }
 
-  return &t[RISCV_GET_PT_INDEX(addr, RISCV_PT_LEVELS)];
+  if (found)
+    *found = level;
+  return &t[RISCV_GET_PT_INDEX(addr, level)];
 }
 
 /* walk the page table and return PTE
@@ -55,22 +66,22 @@ __walk_internal(pte* root, uintptr_t addr, int create)
 static pte*
 __walk(pte* root, uintptr_t addr)
 {
-  return __walk_internal(root, addr, 0);
+  return __walk_internal(root, addr, 0, RISCV_PT_LEVELS, NULL);
 }
 
 /* walk the page table and return PTE
  * create the mapping if non exists */
 static pte*
-__walk_create(pte* root, uintptr_t addr)
+__walk_create(pte* root, uintptr_t addr, int level)
 {
-  return __walk_internal(root, addr, 1);
+  return __walk_internal(root, addr, 1, level, NULL);
 }
 
 /* Create a virtual memory mapping between a physical and virtual page */
 uintptr_t 
 map_page(uintptr_t vpn, uintptr_t ppn, int flags)
 {
-  pte* pte = __walk_create(root_page_table, vpn << RISCV_PAGE_BITS);
+  pte* pte = __walk_create(root_page_table, vpn << RISCV_PAGE_BITS, RISCV_PT_LEVELS);
 
   // TODO: what is supposed to happen if page is already allocated?
   if (*pte & PTE_V) {
@@ -81,13 +92,32 @@ map_page(uintptr_t vpn, uintptr_t ppn, int flags)
   return 1;
 }
 
+/* Same as map_page, but maps one superpage of the next-to-last level
+ * (2 MiB on Sv39, 4 MiB on Sv32). vpn and ppn must be aligned to it. */
+uintptr_t
+map_megapage(uintptr_t vpn, uintptr_t ppn, int flags)
+{
+  pte* pte;
+
+  assert(IS_ALIGNED(vpn << RISCV_PAGE_BITS, MEGAPAGE_BITS));
+  assert(IS_ALIGNED(ppn << RISCV_PAGE_BITS, MEGAPAGE_BITS));
+
+  pte = __walk_create(root_page_table, vpn << RISCV_PAGE_BITS, RISCV_PT_LEVELS - 1);
+  if (*pte & PTE_V) {
+    return -1;
+  }
+
+  *pte = pte_create(ppn, PTE_D | PTE_A | PTE_V | flags);
+  return 1;
+}
+
 /* allocate a new page to a given vpn
  * returns VA of the page, (returns 0 if fails) */
 uintptr_t
 alloc_page(uintptr_t vpn, int flags)
 {
   uintptr_t page;
-  pte* pte = __walk_create(root_page_table, vpn << RISCV_PAGE_BITS);
+  pte* pte = __walk_create(root_page_table, vpn << RISCV_PAGE_BITS, RISCV_PT_LEVELS);
 
   if (!pte)
     return 0;
@@ -187,7 +217,7 @@ test_va_range(uintptr_t vpn, size_t count){
   unsigned int i;
   /* Validate the region */
   for (i = 0; i < count; i++) {
-    pte* pte = __walk_internal(root_page_table, (vpn+i) << RISCV_PAGE_BITS, 0);
+    pte* pte = __walk(root_page_table, (vpn+i) << RISCV_PAGE_BITS);
     // If the page exists and is valid then we cannot use it
     if(pte && *pte){
       break;
@@ -200,10 +230,13 @@ test_va_range(uintptr_t vpn, size_t count){
 uintptr_t
 translate(uintptr_t va)
 {
-  pte* pte = __walk(root_page_table, va);
+  int level;
+  pte* pte = __walk_internal(root_page_table, va, 0, RISCV_PT_LEVELS, &level);
 
+  /* the offset within a superpage leaf is wider than a page offset */
   if(pte && (*pte & PTE_V))
-    return (pte_ppn(*pte) << RISCV_PAGE_BITS) | (RISCV_PAGE_OFFSET(va));
+    return (pte_ppn(*pte) << RISCV_PAGE_BITS) |
+           (va & MASK(RISCV_GET_LVL_PGSIZE_BITS(level)));
   else
     return 0;
 }
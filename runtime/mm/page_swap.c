@@ -15,6 +15,13 @@
 #define NUM_CTR_INDIRECTS 24
 static uintptr_t ctr_indirect_ptrs[NUM_CTR_INDIRECTS];
 
+/* With both confidentiality and integrity enabled, pages are sealed with
+ * AES-GCM in a single pass and the GCM tag takes the place of the SHA-256
+ * page hash in the merkle tree. */
+#if defined(USE_PAGE_CRYPTO) && defined(USE_PAGE_HASH)
+#define PSWAP_AEAD
+#endif
+
 static uintptr_t paging_next_backing_page_offset;
 static uintptr_t paging_inc_backing_page_offset_by;
 
@@ -95,7 +102,8 @@ pswap_pageout_ctr(uintptr_t page) {
 #ifdef USE_PAGE_CRYPTO
 static volatile atomic_bool pswap_boot_key_reserved = false;
 static volatile atomic_bool pswap_boot_key_set      = false;
-static uint8_t pswap_boot_key[32];
+/* key schedule and GHASH tables of the boot key, expanded once */
+static AES_GCM_CTX pswap_boot_ctx;
 
 static void
 pswap_establish_boot_key(void) {
@@ -115,7 +123,8 @@ pswap_establish_boot_key(void) {
     return;
   }
 
-  memcpy(pswap_boot_key, boot_key_tmp, 32);
+  aes_gcm_setup(&pswap_boot_ctx, boot_key_tmp, 256);
+  memset(boot_key_tmp, 0, sizeof(boot_key_tmp));
   atomic_store(&pswap_boot_key_set, true);
 }
 #endif  // USE_PAGE_CRYPTO
@@ -124,6 +133,7 @@ pswap_establish_boot_key(void) {
 static merkle_node_t paging_merk_root = {};
 #endif
 
+#ifndef PSWAP_AEAD
 static void
 pswap_encrypt(const void* addr, void* dst, uint64_t pageout_ctr) {
   size_t len = RISCV_PAGE_SIZE;
@@ -131,12 +141,12 @@ pswap_encrypt(const void* addr, void* dst, uint64_t pageout_ctr) {
 #ifdef USE_PAGE_CRYPTO
   pswap_establish_boot_key();
   uint8_t iv[32] = {0};
-  WORD key_sched[80];
-  aes_key_setup(pswap_boot_key, key_sched, 256);
 
   memcpy(iv + 8, &pageout_ctr, 8);
 
-  aes_encrypt_ctr((uint8_t*)addr, len, (uint8_t*)dst, key_sched, 256, iv);
+  aes_encrypt_ctr(
+      (uint8_t*)addr, len, (uint8_t*)dst, pswap_boot_ctx.key,
+      pswap_boot_ctx.keysize, iv);
 #else
   memcpy(dst, addr, len);
 #endif
@@ -149,12 +159,12 @@ pswap_decrypt(const void* addr, void* dst, uint64_t pageout_ctr) {
 #ifdef USE_PAGE_CRYPTO
   pswap_establish_boot_key();
   uint8_t iv[32] = {0};
-  WORD key_sched[80];
-  aes_key_setup(pswap_boot_key, key_sched, 256);
 
   memcpy(iv + 8, &pageout_ctr, 8);
 
-  aes_decrypt_ctr((uint8_t*)addr, len, (uint8_t*)dst, key_sched, 256, iv);
+  aes_decrypt_ctr(
+      (uint8_t*)addr, len, (uint8_t*)dst, pswap_boot_ctx.key,
+      pswap_boot_ctx.keysize, iv);
 #else
   memcpy(dst, addr, len);
 #endif
@@ -171,6 +181,61 @@ pswap_hash(uint8_t* hash, void* page_addr, uint64_t pageout_ctr) {
   sha256_final(&hasher, hash);
 #endif
 }
+#endif  // !PSWAP_AEAD
+
+#ifdef PSWAP_AEAD
+/* The nonce is the backing page index and its pageout counter, so it is
+ * unique per page and per swap-out under the boot key. */
+static void
+pswap_aead_iv(uint8_t* iv, uintptr_t back_page, uint64_t pageout_ctr) {
+  uint32_t idx = (back_page - paging_backing_region()) >> RISCV_PAGE_BITS;
+
+  memcpy(iv, &idx, sizeof(idx));
+  memcpy(iv + sizeof(idx), &pageout_ctr, sizeof(pageout_ctr));
+}
+#endif
+
+/* encrypt a page to dst and compute the value the merkle tree keeps for it */
+static void
+pswap_seal(
+    const void* addr, void* dst, uintptr_t back_page, uint64_t pageout_ctr,
+    uint8_t* hash) {
+#ifdef PSWAP_AEAD
+  uint8_t iv[AES_GCM_IV_SIZE];
+
+  pswap_establish_boot_key();
+  pswap_aead_iv(iv, back_page, pageout_ctr);
+  memset(hash, 0, 32);
+  aes_encrypt_gcm(
+      &pswap_boot_ctx, iv, NULL, 0, (const uint8_t*)addr, RISCV_PAGE_SIZE,
+      (uint8_t*)dst, hash);
+#else
+  (void)back_page;
+  pswap_hash(hash, (void*)addr, pageout_ctr);
+  pswap_encrypt(addr, dst, pageout_ctr);
+#endif
+}
+
+/* decrypt a page from addr and recompute its merkle value for verification */
+static void
+pswap_open(
+    const void* addr, void* dst, uintptr_t back_page, uint64_t pageout_ctr,
+    uint8_t* hash) {
+#ifdef PSWAP_AEAD
+  uint8_t iv[AES_GCM_IV_SIZE];
+
+  pswap_establish_boot_key();
+  pswap_aead_iv(iv, back_page, pageout_ctr);
+  memset(hash, 0, 32);
+  aes_decrypt_gcm(
+      &pswap_boot_ctx, iv, NULL, 0, (const uint8_t*)addr, RISCV_PAGE_SIZE,
+      (uint8_t*)dst, hash);
+#else
+  (void)back_page;
+  pswap_decrypt(addr, dst, pageout_ctr);
+  pswap_hash(hash, dst, pageout_ctr);
+#endif
+}
 
 /* evict a page from EPM and store it to the backing storage
  * back_page (PA1) <-- epm_page (PA2) <-- swap_page (PA1)
@@ -192,13 +257,13 @@ page_swap_epm(uintptr_t back_page, uintptr_t epm_page, uintptr_t swap_page) {
   uint64_t new_pageout_ctr = old_pageout_ctr + 1;
 
   uint8_t new_hash[32];
-  pswap_hash(new_hash, (void*)epm_page, new_pageout_ctr);
-  pswap_encrypt((void*)epm_page, (void*)back_page, new_pageout_ctr);
+  pswap_seal(
+      (void*)epm_page, (void*)back_page, back_page, new_pageout_ctr, new_hash);
 
   if (swap_page) {
     uint8_t old_hash[32];
-    pswap_decrypt((void*)buffer, (void*)epm_page, old_pageout_ctr);
-    pswap_hash(old_hash, (void*)epm_page, old_pageout_ctr);
+    pswap_open(
+        (void*)buffer, (void*)epm_page, back_page, old_pageout_ctr, old_hash);
 
 #ifdef USE_PAGE_HASH
     bool ok = merk_verify(&paging_merk_root, back_page, old_hash);
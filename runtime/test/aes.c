@@ -0,0 +1,114 @@
+#include <string.h>
+
+#include "../crypto/aes.c"
+
+#include "mock.h"
+
+/* FIPS-197 appendix C */
+static const BYTE fips_pt[16] = {
+    0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+    0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff};
+static const BYTE fips_ct[3][16] = {
+    {0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30, 0xd8, 0xcd, 0xb7, 0x80,
+     0x70, 0xb4, 0xc5, 0x5a},
+    {0xdd, 0xa9, 0x7c, 0xa4, 0x86, 0x4c, 0xdf, 0xe0, 0x6e, 0xaf, 0x70, 0xa0,
+     0xec, 0x0d, 0x71, 0x91},
+    {0x8e, 0xa2, 0xb7, 0xca, 0x51, 0x67, 0x45, 0xbf, 0xea, 0xfc, 0x49, 0x90,
+     0x4b, 0x49, 0x60, 0x89}};
+
+/* GCM specification (McGrew & Viega), test case 16 */
+static const BYTE gcm_key[32] = {
+    0xfe, 0xff, 0xe9, 0x92, 0x86, 0x65, 0x73, 0x1c, 0x6d, 0x6a, 0x8f,
+    0x94, 0x67, 0x30, 0x83, 0x08, 0xfe, 0xff, 0xe9, 0x92, 0x86, 0x65,
+    0x73, 0x1c, 0x6d, 0x6a, 0x8f, 0x94, 0x67, 0x30, 0x83, 0x08};
+static const BYTE gcm_iv[12] = {0xca, 0xfe, 0xba, 0xbe, 0xfa, 0xce,
+                                0xdb, 0xad, 0xde, 0xca, 0xf8, 0x88};
+static const BYTE gcm_aad[20] = {
+    0xfe, 0xed, 0xfa, 0xce, 0xde, 0xad, 0xbe, 0xef, 0xfe, 0xed,
+    0xfa, 0xce, 0xde, 0xad, 0xbe, 0xef, 0xab, 0xad, 0xda, 0xd2};
+static const BYTE gcm_pt[60] = {
+    0xd9, 0x31, 0x32, 0x25, 0xf8, 0x84, 0x06, 0xe5, 0xa5, 0x59, 0x09, 0xc5,
+    0xaf, 0xf5, 0x26, 0x9a, 0x86, 0xa7, 0xa9, 0x53, 0x15, 0x34, 0xf7, 0xda,
+    0x2e, 0x4c, 0x30, 0x3d, 0x8a, 0x31, 0x8a, 0x72, 0x1c, 0x3c, 0x0c, 0x95,
+    0x95, 0x68, 0x09, 0x53, 0x2f, 0xcf, 0x0e, 0x24, 0x49, 0xa6, 0xb5, 0x25,
+    0xb1, 0x6a, 0xed, 0xf5, 0xaa, 0x0d, 0xe6, 0x57, 0xba, 0x63, 0x7b, 0x39};
+static const BYTE gcm_ct[60] = {
+    0x52, 0x2d, 0xc1, 0xf0, 0x99, 0x56, 0x7d, 0x07, 0xf4, 0x7f, 0x37, 0xa3,
+    0x2a, 0x84, 0x42, 0x7d, 0x64, 0x3a, 0x8c, 0xdc, 0xbf, 0xe5, 0xc0, 0xc9,
+    0x75, 0x98, 0xa2, 0xbd, 0x25, 0x55, 0xd1, 0xaa, 0x8c, 0xb0, 0x8e, 0x48,
+    0x59, 0x0d, 0xbb, 0x3d, 0xa7, 0xb0, 0x8b, 0x10, 0x56, 0x82, 0x88, 0x38,
+    0xc5, 0xf6, 0x1e, 0x63, 0x93, 0xba, 0x7a, 0x0a, 0xbc, 0xc9, 0xf6, 0x62};
+static const BYTE gcm_tag[16] = {0x76, 0xfc, 0x6e, 0xce, 0x0f, 0x4e,
+                                 0x17, 0x68, 0xcd, 0xdf, 0x88, 0x53,
+                                 0xbb, 0x2d, 0x55, 0x1b};
+
+static void
+test_aes_block(void** ctx) {
+  BYTE key[32], ct[16], pt[16];
+  WORD sched[60];
+  int keysize;
+
+  for (int i = 0; i < 32; i++) key[i] = i;
+
+  for (int i = 0; i < 3; i++) {
+    keysize = 128 + 64 * i;
+    aes_key_setup(key, sched, keysize);
+    aes_encrypt(fips_pt, ct, sched, keysize);
+    assert_memory_equal(ct, fips_ct[i], 16);
+    aes_decrypt(ct, pt, sched, keysize);
+    assert_memory_equal(pt, fips_pt, 16);
+  }
+}
+
+static void
+test_aes_gcm(void** ctx) {
+  AES_GCM_CTX gcm;
+  BYTE out[60], back[60], tag[16];
+
+  aes_gcm_setup(&gcm, gcm_key, 256);
+
+  aes_encrypt_gcm(
+      &gcm, gcm_iv, gcm_aad, sizeof(gcm_aad), gcm_pt, sizeof(gcm_pt), out, tag);
+  assert_memory_equal(out, gcm_ct, sizeof(gcm_ct));
+  assert_memory_equal(tag, gcm_tag, sizeof(gcm_tag));
+
+  aes_decrypt_gcm(
+      &gcm, gcm_iv, gcm_aad, sizeof(gcm_aad), out, sizeof(out), back, tag);
+  assert_memory_equal(back, gcm_pt, sizeof(gcm_pt));
+  assert_memory_equal(tag, gcm_tag, sizeof(gcm_tag));
+
+  /* a flipped ciphertext bit shows up in the recomputed tag */
+  out[17] ^= 1;
+  aes_decrypt_gcm(
+      &gcm, gcm_iv, gcm_aad, sizeof(gcm_aad), out, sizeof(out), back, tag);
+  assert_memory_not_equal(tag, gcm_tag, sizeof(gcm_tag));
+}
+
+static void
+test_aes_gcm_in_place(void** ctx) {
+  AES_GCM_CTX gcm;
+  BYTE buf[60], tag[16];
+
+  aes_gcm_setup(&gcm, gcm_key, 256);
+
+  memcpy(buf, gcm_pt, sizeof(buf));
+  aes_encrypt_gcm(
+      &gcm, gcm_iv, gcm_aad, sizeof(gcm_aad), buf, sizeof(buf), buf, tag);
+  assert_memory_equal(buf, gcm_ct, sizeof(gcm_ct));
+  assert_memory_equal(tag, gcm_tag, sizeof(gcm_tag));
+
+  aes_decrypt_gcm(
+      &gcm, gcm_iv, gcm_aad, sizeof(gcm_aad), buf, sizeof(buf), buf, tag);
+  assert_memory_equal(buf, gcm_pt, sizeof(gcm_pt));
+  assert_memory_equal(tag, gcm_tag, sizeof(gcm_tag));
+}
+
+int
+main() {
+  const struct CMUnitTest tests[] = {
+      cmocka_unit_test(test_aes_block),
+      cmocka_unit_test(test_aes_gcm),
+      cmocka_unit_test(test_aes_gcm_in_place),
+  };
+  return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,71 @@
+#include <string.h>
+
+#include "../call/sealing.c"
+
+#include "mock.h"
+
+static void
+make_key(unsigned char* key, int seed) {
+  for (int i = 0; i < SEALING_KEY_STRUCT_SIZE; i++) key[i] = seed + i;
+}
+
+static void
+test_sealing_cache_hit(void** ctx) {
+  unsigned char key[SEALING_KEY_STRUCT_SIZE];
+  unsigned char out[SEALING_KEY_STRUCT_SIZE];
+
+  assert_false(sealing_cache_lookup(out, "ident", 5));
+
+  make_key(key, 1);
+  sealing_cache_insert(key, "ident", 5);
+  assert_true(sealing_cache_lookup(out, "ident", 5));
+  assert_memory_equal(out, key, SEALING_KEY_STRUCT_SIZE);
+
+  /* the size is part of the identifier */
+  assert_false(sealing_cache_lookup(out, "ident", 4));
+  assert_false(sealing_cache_lookup(out, "identx", 6));
+}
+
+static void
+test_sealing_cache_long_ident(void** ctx) {
+  unsigned char key[SEALING_KEY_STRUCT_SIZE];
+  unsigned char out[SEALING_KEY_STRUCT_SIZE];
+  char ident[SEALING_CACHE_IDENT_MAX + 1];
+
+  memset(ident, 'a', sizeof(ident));
+  make_key(key, 2);
+  sealing_cache_insert(key, ident, sizeof(ident));
+  assert_false(sealing_cache_lookup(out, ident, sizeof(ident)));
+}
+
+static void
+test_sealing_cache_eviction(void** ctx) {
+  unsigned char key[SEALING_KEY_STRUCT_SIZE];
+  unsigned char out[SEALING_KEY_STRUCT_SIZE];
+  int i;
+
+  for (i = 0; i < SEALING_CACHE_ENTRIES + 2; i++) {
+    make_key(key, i);
+    sealing_cache_insert(key, &i, sizeof(i));
+  }
+
+  /* the oldest two are gone, the rest are still there */
+  for (i = 0; i < SEALING_CACHE_ENTRIES + 2; i++) {
+    int found = sealing_cache_lookup(out, &i, sizeof(i));
+    assert_int_equal(found, i >= 2);
+    if (found) {
+      make_key(key, i);
+      assert_memory_equal(out, key, SEALING_KEY_STRUCT_SIZE);
+    }
+  }
+}
+
+int
+main() {
+  const struct CMUnitTest tests[] = {
+      cmocka_unit_test(test_sealing_cache_hit),
+      cmocka_unit_test(test_sealing_cache_long_ident),
+      cmocka_unit_test(test_sealing_cache_eviction),
+  };
+  return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -14,6 +14,9 @@
 #ifndef SEALING_H
 #define SEALING_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 #define SEALING_KEY_SIZE 128
 #define SIGNATURE_SIZE 64
 
@@ -23,4 +26,34 @@ struct sealing_key {
   uint8_t signature[SIGNATURE_SIZE];
 };
 
+/* Authenticated encryption with a sealing key, entirely inside the
+ * enclave: the SM is only asked for the key once per seal_key_init().
+ * Sealed data is nonce || ciphertext || tag, SEAL_OVERHEAD bytes longer
+ * than the plaintext. The cipher is SHAKE256(enc key || nonce) as a key
+ * stream and the tag is SHA3-256(mac key || nonce || length || ciphertext). */
+#define SEAL_NONCE_SIZE 16
+#define SEAL_TAG_SIZE 32
+#define SEAL_OVERHEAD (SEAL_NONCE_SIZE + SEAL_TAG_SIZE)
+#define SEAL_KEY_LABEL "keystone seal"
+
+struct seal_key {
+  uint8_t enc[32];
+  uint8_t mac[32];
+};
+
+int
+seal_key_init(
+    struct seal_key* key, const void* key_ident, size_t key_ident_size);
+void
+seal_key_clear(struct seal_key* key);
+/* A nonce must never be used twice with the same key */
+void
+seal(
+    const struct seal_key* key, const uint8_t* nonce, const void* in,
+    size_t len, void* out);
+/* Returns -1 and leaves out alone if the data was not sealed with key */
+int
+unseal(
+    const struct seal_key* key, const void* in, size_t sealed_len, void* out);
+
 #endif /* SEALING_H */
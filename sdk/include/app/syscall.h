@@ -9,6 +9,7 @@
 #include <stdint.h>
 #include "sealing.h"
 
+#include "edge/edge_common.h"
 #include "shared/eyrie_call.h"
 
 #define SYSCALL(which, arg0, arg1, arg2, arg3, arg4)           \
@@ -43,11 +44,26 @@ int
 ocall(
     unsigned long call_id, void* data, size_t data_len, void* return_buffer,
     size_t return_len);
+/* Scatter/gather ocall: IN segments are copied into the shared buffer and
+ * OUT segments back from it, without staging (see struct edge_iovec). At
+ * most EDGE_IOV_MAX segments. Returns 0 on success. */
+int
+ocall_v(unsigned long call_id, struct edge_iovec* iov, size_t count);
 uintptr_t
 untrusted_mmap();
+/* Writes an ATTEST_REPORT_SIZE-byte report. The log can be any size; only
+ * its SHA3-512 digest is signed, so send the log itself along with the
+ * report and check it with Report::setLog(). Keep the log in enclave
+ * memory while attesting. */
 int
 attest_enclave(void* report, void* data, size_t size, void* log_ptr, size_t log_size);
 
+/* Binds data to this enclave for the verifier owning verifier_key (an
+ * ed25519 public key), writing an ATTEST_MAC_SIZE-byte tag. Much cheaper
+ * than attest_enclave(); see Report::verifyMac() */
+int
+attest_enclave_mac(void* tag, void* data, size_t size, const void* verifier_key);
+
 int
 get_sealing_key(
     struct sealing_key* sealing_key_struct, size_t sealing_key_struct_size,
@@ -41,4 +41,17 @@ sha3_final(void* md, sha3_ctx_t* c);  // digest goes to md
 void*
 sha3(const void* in, size_t inlen, void* md, int mdlen);
 
+// SHAKE128 and SHAKE256 extensible-output functions
+#define shake128_init(c) sha3_init(c, 16)
+#define shake256_init(c) sha3_init(c, 32)
+#define shake_update sha3_update
+
+void
+shake_xof(sha3_ctx_t* c);
+void
+shake_out(sha3_ctx_t* c, void* out, size_t len);
+// out = in ^ the next len bytes of output; out may be in
+void
+shake_xor(sha3_ctx_t* c, void* out, const void* in, size_t len);
+
 #endif /* __SHA3_H_ */
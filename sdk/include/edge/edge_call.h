@@ -19,6 +19,11 @@ edge_call_check_ptr_valid(uintptr_t ptr, size_t data_len);
 
 void
 edge_call_init_internals(uintptr_t buffer_start, size_t buffer_len);
+/* Same, but only for the calling thread, and taking precedence over the
+   process-wide buffer. Lets enclaves that are run from different threads of
+   one process (e.g. an EnclaveGroup) serve their edge calls concurrently. */
+void
+edge_call_init_thread_internals(uintptr_t buffer_start, size_t buffer_len);
 
 int
 edge_call_get_ptr_from_offset(
@@ -35,6 +40,9 @@ edge_call_ret_ptr(struct edge_call* edge_call, uintptr_t* ptr, size_t* size);
 uintptr_t
 edge_call_data_ptr();
 int
+edge_call_iov_next(
+    uintptr_t args, size_t args_len, size_t* off, size_t len, uintptr_t* ptr);
+int
 edge_call_setup_call(struct edge_call* edge_call, void* ptr, size_t size);
 int
 edge_call_setup_ret(struct edge_call* edge_call, void* ptr, size_t size);
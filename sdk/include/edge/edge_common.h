@@ -14,9 +14,12 @@ typedef size_t edge_data_offset;
 
 typedef void (*edgecallwrapper)(void*);
 
+/* Call ids are not bounded by this any more (see register_call), it only
+   fixes the number of EDGECALL_SYSCALL shared with the runtime */
 #define MAX_EDGE_CALL 10
 
-extern edgecallwrapper edge_call_table[MAX_EDGE_CALL];
+/* Carries several calls in one enclave exit, see struct edge_batch_record */
+#define EDGECALL_BATCH (MAX_EDGE_CALL + 2)
 
 /* Call status indicates if the wrapper code, pointers, offsets, etc went OK
  * It has no bearing on data contained in the returns. */
@@ -54,6 +57,32 @@ struct edge_return {
   size_t call_ret_size;
 };
 
+/* Scatter/gather ocalls (ocall_v). Segments are laid out back to back in
+ * the shared data section, each starting EDGE_IOV_ALIGN-aligned. IN
+ * segments are copied there before the call, OUT segments are copied back
+ * from the same place after it; the host reads and writes them in place. */
+#define EDGE_IOV_IN 0x1
+#define EDGE_IOV_OUT 0x2
+#define EDGE_IOV_MAX 16
+#define EDGE_IOV_ALIGN 8
+#define EDGE_IOV_ALIGN_UP(n) \
+  (((n) + (EDGE_IOV_ALIGN - 1)) & ~((size_t)EDGE_IOV_ALIGN - 1))
+
+struct edge_iovec {
+  void* base;
+  size_t len;
+  unsigned long flags;
+};
+
+/* The arguments of an EDGECALL_BATCH call are a sequence of these, each
+ * followed by size bytes of arguments for call_id and padded to
+ * EDGE_IOV_ALIGN. Batched calls return nothing; whatever their handlers
+ * return is dropped. */
+struct edge_batch_record {
+  unsigned long call_id;
+  size_t size;
+};
+
 struct edge_call {
   /* Similar to syscall number.  User-defined call id, handled at the
    * edges only */
@@ -13,7 +13,9 @@
 
 #include <cerrno>
 #include <cstring>
+#include <exception>
 #include <functional>
+#include <future>
 #include <iostream>
 
 #include "./common.h"
@@ -22,13 +24,22 @@ extern "C" {
 }
 #include "ElfFile.hpp"
 #include "Error.hpp"
+#include "Executor.hpp"
 #include "KeystoneDevice.hpp"
 #include "Memory.hpp"
+#include "Ocall.hpp"
 #include "Params.hpp"
 
 namespace Keystone {
 
 typedef std::function<void(void*)> OcallFunc;
+/* Reports that an asynchronous ocall is complete, with the exception it
+ * failed with or nullptr. Can be called from any thread, once. */
+typedef std::function<void(std::exception_ptr)> OcallCompletion;
+/* May return before the call is complete; the enclave is resumed once done
+ * is called. A failed call or an exception thrown by the handler fails the
+ * run with that exception. */
+typedef std::function<void(void*, OcallCompletion done)> AsyncOcallFunc;
 
 class Enclave {
  private:
@@ -40,6 +51,7 @@ class Enclave {
   void* shared_buffer;
   size_t shared_buffer_size;
   OcallFunc oFuncDispatch;
+  AsyncOcallFunc oFuncDispatchAsync;
   bool mapUntrusted(size_t size);
   void copyFile(uintptr_t filePtr, size_t fileSize);
   void allocUninitialized(ElfFile* elfFile);
@@ -50,25 +62,60 @@ class Enclave {
   bool prepareEnclaveMemory(size_t requiredPages, uintptr_t alternatePhysAddr);
   bool initMemory();
 
+  friend class Executor;
+
  public:
   Enclave();
+  /* Runs on an existing device instead of the one init() opens, e.g. a mock
+   * device in tests, with an untrusted buffer of untrustedSize mapped from
+   * it. The device must outlive the enclave. */
+  Enclave(KeystoneDevice* device, size_t untrustedSize);
   ~Enclave();
-  static Error measure(char* hash, const char* eapppath, const char* runtimepath, const char* loaderpath);
+  static Error measure(
+      char* hash, const char* eapppath, const char* runtimepath,
+      const char* loaderpath, uintptr_t measureFlags = 0);
   void* getSharedBuffer();
   size_t getSharedBufferSize();
   Memory* getMemory();
   uintptr_t getRuntimeElfAddr() { return runtimeElfAddr; }
   uintptr_t getEnclaveElfAddr() { return enclaveElfAddr; }
   Error registerOcallDispatch(OcallFunc func);
+  Error registerAsyncOcallDispatch(AsyncOcallFunc func);
+  /* Registers a typed handler for ocall ID, see Ocall.hpp for how arguments
+   * and results are laid out. Like register_call(), the handler is
+   * process-wide, not tied to this enclave: the last handler registered for
+   * ID serves every enclave of the process. incoming_call_dispatch becomes
+   * the enclave's dispatch function unless another one was registered. */
+  template <unsigned long ID, typename R, typename... Args>
+  Error registerOcall(std::function<R(Args...)> func) {
+    OcallSlot<ID>::handler = OcallWrapper<R, Args...>(func);
+    if (register_call(ID, OcallSlot<ID>::dispatch)) {
+      return Error::OcallRegisterFailure;
+    }
+    if (!oFuncDispatch && !oFuncDispatchAsync) {
+      oFuncDispatch = incoming_call_dispatch;
+    }
+    return Error::Success;
+  }
+  template <unsigned long ID, typename R, typename... Args>
+  Error registerOcall(R (*func)(Args...)) {
+    return registerOcall<ID>(std::function<R(Args...)>(func));
+  }
   Error init(const char* filepath, const char* runtime, const char* loaderpath, Params parameters);
   Error init(
       const char* eapppath, const char* runtimepath, const char* loaderpath, Params _params,
       uintptr_t alternatePhysAddr);
+  Error clone(Enclave& source);
   Error destroy();
   Error run(uintptr_t* ret = nullptr);
+  /* Like run(), but returns at once. *ret and the enclave must stay valid
+   * until the future is ready. */
+  std::future<Error> runAsync(
+      uintptr_t* ret = nullptr, Executor& executor = Executor::getDefault());
   Error connect(int otherEid);
   int getEid() { return pDevice->getEid(); }
   unsigned int getSMeid() {return pDevice->getSMeid(); }
+  Error getStats(struct sm_stats* stats) { return pDevice->getStats(stats); }
 };
 
 uint64_t
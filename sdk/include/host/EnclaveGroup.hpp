@@ -0,0 +1,77 @@
+//******************************************************************************
+// Copyright (c) 2020, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Error.hpp"
+
+namespace Keystone {
+
+class Enclave;
+
+/* Runs several enclaves of one process side by side.
+ *
+ * Every member gets its own host thread, optionally pinned to a CPU, which
+ * waits until the member is started and then drives it with Enclave::run().
+ * Members can be connected (Enclave::connect) before they run, and started
+ * one at a time, so ordering between them can be done in memory, e.g. by an
+ * ocall handler of one member starting the next, instead of through flag
+ * files between processes.
+ *
+ * Ocalls of a member are served on that member's thread, which is bound to
+ * the member's shared buffer with edge_call_init_thread_internals(), so the
+ * edge library functions used by handlers see the right enclave. */
+class EnclaveGroup {
+ private:
+  struct Member {
+    Enclave* enclave;
+    int cpu;
+    std::thread thread;
+    bool started;
+    bool finished;
+    Error result;
+    uintptr_t ret;
+  };
+
+  std::mutex lock;
+  std::condition_variable cond;
+  std::vector<std::unique_ptr<Member>> members;  // guarded by lock
+  bool stopping;
+
+  void runMember(Member* member);
+
+ public:
+  EnclaveGroup();
+  ~EnclaveGroup();
+  EnclaveGroup(const EnclaveGroup&) = delete;
+  EnclaveGroup& operator=(const EnclaveGroup&) = delete;
+
+  /* Adds an initialized enclave, owned by the caller, and returns its index.
+   * cpu pins the member's thread, -1 leaves it to the scheduler. */
+  int add(Enclave* enclave, int cpu = -1);
+  Error connect(int from, int to);
+
+  Error start(int index);
+  void startAll();
+  /* Members that were not started yet are cancelled; running ones are left
+   * to finish, there is no way to stop an enclave from the host. */
+  void stop();
+
+  /* Waits for a member to finish and returns what its run() returned, or
+   * Error::EnclaveCancelled if it never started */
+  Error wait(int index, uintptr_t* ret = nullptr);
+  /* Waits for every member; returns the first error, if any */
+  Error waitAll();
+
+  Enclave* get(int index);
+  int size();
+};
+
+}  // namespace Keystone
@@ -19,6 +19,9 @@ enum class Error {
   IoctlErrorRun,
   IoctlErrorResume,
   IoctlErrorUTMInit,
+  IoctlErrorStats,
+  IoctlErrorTrace,
+  IoctlErrorClone,
   DeviceMemoryMapError,
   ELFLoadFailure,
   InvalidEnclave,
@@ -26,6 +29,8 @@ enum class Error {
   PageAllocationFailure,
   EdgeCallHost,
   EnclaveInterrupted,
+  EnclaveCancelled,
+  OcallRegisterFailure,
 };
 
 }  // namespace Keystone
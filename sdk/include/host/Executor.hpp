@@ -0,0 +1,80 @@
+//******************************************************************************
+// Copyright (c) 2020, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Error.hpp"
+
+namespace Keystone {
+
+class Enclave;
+
+/* Drives enclaves started with Enclave::runAsync() from a single thread.
+ *
+ * The enclaves run on driver workqueues (KEYSTONE_IOC_*_ASYNC); this thread
+ * only waits on their device fds with epoll, serves edge calls and resumes
+ * them. The shared buffer of the enclave being served is bound to the thread
+ * (edge_call_init_thread_internals) before each dispatch. Asynchronous ocall
+ * handlers are not waited on: their completion callback queues the enclave
+ * and wakes the executor, which then resumes it; other enclaves keep being
+ * served in the meantime. An ocall that fails with an exception fails its
+ * enclave's run with it. */
+class Executor {
+ private:
+  struct Task {
+    Enclave* enclave;
+    uintptr_t* ret;
+    std::promise<Error> done;
+  };
+  struct Completion {
+    Task* task;
+    std::exception_ptr error;
+  };
+
+  int epollFd;
+  int wakeFd;
+  std::thread thread;
+  std::atomic<bool> stopping;
+
+  std::mutex lock;
+  std::vector<std::unique_ptr<Task>> incoming;  // guarded by lock
+  std::vector<Completion> completed;            // guarded by lock
+  size_t pending;                               // guarded by lock
+  std::condition_variable idle;                 // pending dropped to 0
+  std::list<std::unique_ptr<Task>> tasks;       // executor thread only
+
+  void loop();
+  void wake();
+  void start(Task* task);
+  void step(Task* task);
+  void dispatch(Task* task);
+  bool resume(Task* task);
+  void finish(Task* task, Error error);
+  void fail(Task* task, std::exception_ptr error);
+
+ public:
+  Executor();
+  /* Fails the enclaves still running. Asynchronous ocalls still pending are
+   * waited for first. */
+  ~Executor();
+  Executor(const Executor&) = delete;
+  Executor& operator=(const Executor&) = delete;
+
+  std::future<Error> submit(Enclave* enclave, uintptr_t* ret);
+
+  /* executor used by Enclave::runAsync() unless one is passed in */
+  static Executor& getDefault();
+};
+
+}  // namespace Keystone
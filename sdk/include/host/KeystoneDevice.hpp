@@ -31,6 +31,7 @@ class KeystoneDevice {
  private:
   int fd;
   Error __run(bool resume, uintptr_t* ret);
+  Error __runAsync(bool resume);
 
  public:
   virtual uintptr_t getPhysAddr() { return physAddr; }
@@ -39,16 +40,29 @@ class KeystoneDevice {
   virtual ~KeystoneDevice() {}
   virtual bool initDevice(Params params);
   virtual Error create(uint64_t minPages);
+  virtual Error clone(int srcEid, uint64_t* epmPages);
   virtual uintptr_t initUTM(size_t size);
   virtual uintptr_t initSEM(size_t size);
   virtual Error connectEnclaves(int eid);
   virtual Error finalize(
       uintptr_t runtimePhysAddr, uintptr_t eappPhysAddr, uintptr_t freePhysAddr,
-      uintptr_t freeRequested);
+      uintptr_t freeRequested, uintptr_t measureFlags);
   virtual Error destroy();
   virtual Error run(uintptr_t* ret);
   virtual Error resume(uintptr_t* ret);
+  /* Start run/resume and return at once. getFd() becomes readable (poll,
+   * epoll) when the enclave stops, and asyncResult() then returns what
+   * run()/resume() would have. Interrupts are handled by the driver. */
+  virtual Error runAsync();
+  virtual Error resumeAsync();
+  virtual Error asyncResult(uintptr_t* ret);
+  virtual int getFd() { return fd; }
   virtual void* map(uintptr_t addr, size_t size);
+  virtual Error getStats(struct sm_stats* stats);
+  virtual Error getHartStats(unsigned int hartid, struct sm_stats* stats);
+  virtual Error drainTrace(
+      unsigned int hartid, struct sm_trace_event* events, size_t max,
+      size_t* count);
   int getEid() { return eid; }
   unsigned int getSMeid();
 };
@@ -63,15 +77,25 @@ class MockKeystoneDevice : public KeystoneDevice {
   ~MockKeystoneDevice();
   bool initDevice(Params params);
   Error create(uint64_t minPages);
+  Error clone(int srcEid, uint64_t* epmPages);
   uintptr_t initUTM(size_t size);
   uintptr_t initSEM(size_t size);
   Error connectEnclaves(int eid);
   Error finalize(
       uintptr_t runtimePhysAddr, uintptr_t eappPhysAddr, uintptr_t freePhysAddr,
-      uintptr_t freeRequested);
+      uintptr_t freeRequested, uintptr_t measureFlags);
   Error destroy();
   Error run(uintptr_t* ret);
   Error resume(uintptr_t* ret);
+  Error runAsync();
+  Error resumeAsync();
+  Error asyncResult(uintptr_t* ret);
+  int getFd() { return -1; }
+  Error getStats(struct sm_stats* stats);
+  Error getHartStats(unsigned int hartid, struct sm_stats* stats);
+  Error drainTrace(
+      unsigned int hartid, struct sm_trace_event* events, size_t max,
+      size_t* count);
   void* map(uintptr_t addr, size_t size);
 };
 
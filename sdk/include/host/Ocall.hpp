@@ -0,0 +1,213 @@
+//******************************************************************************
+// Copyright (c) 2020, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cstring>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+
+#include "edge/edge_call.h"
+
+namespace Keystone {
+
+/* Typed ocall handlers, see Enclave::registerOcall().
+ *
+ * The argument buffer the enclave passed to ocall() is decoded into the
+ * handler's parameters as if it were a C struct of them, in order and with
+ * natural alignment. Parameters are views into the shared buffer, nothing is
+ * copied out of it:
+ *
+ *   T, const T&    trivially copyable T, read in place
+ *   char*          NUL-terminated string, the rest of the buffer
+ *   OcallBuffer    the rest of the buffer, raw
+ *
+ * char* and OcallBuffer consume everything after them, so they can only be
+ * the last parameter. Buffers that are too short are rejected with
+ * CALL_STATUS_BAD_OFFSET before the handler runs.
+ *
+ * Results are copied into the shared buffer's data section, over the
+ * arguments, once the handler has returned. A handler that fills the shared
+ * buffer itself can return an OcallBuffer describing what it wrote. */
+struct OcallBuffer {
+  void* data;
+  size_t size;
+};
+
+template <typename T>
+struct OcallArg {
+  typedef typename std::decay<T>::type Type;
+  typedef const Type* View;
+  static_assert(
+      std::is_trivially_copyable<Type>::value,
+      "ocall arguments must be trivially copyable");
+
+  static bool decode(uintptr_t base, size_t len, size_t& off, View& view) {
+    off = (off + alignof(Type) - 1) & ~(alignof(Type) - 1);
+    if (off > len || len - off < sizeof(Type)) {
+      return false;
+    }
+    view = reinterpret_cast<View>(base + off);
+    off += sizeof(Type);
+    return true;
+  }
+  static const Type& get(View view) { return *view; }
+};
+
+template <typename T>
+struct OcallStringArg {
+  typedef T View;
+
+  static bool decode(uintptr_t base, size_t len, size_t& off, View& view) {
+    const char* str = reinterpret_cast<const char*>(base);
+    size_t i;
+    for (i = off; i < len && str[i]; i++) {
+    }
+    if (i >= len) {
+      return false;
+    }
+    view = reinterpret_cast<View>(base + off);
+    off  = len;
+    return true;
+  }
+  static View get(View view) { return view; }
+};
+
+template <>
+struct OcallArg<char*> : OcallStringArg<char*> {};
+template <>
+struct OcallArg<const char*> : OcallStringArg<const char*> {};
+
+template <>
+struct OcallArg<OcallBuffer> {
+  typedef OcallBuffer View;
+
+  static bool decode(uintptr_t base, size_t len, size_t& off, View& view) {
+    if (off > len) {
+      return false;
+    }
+    view.data = reinterpret_cast<void*>(base + off);
+    view.size = len - off;
+    off       = len;
+    return true;
+  }
+  static View get(View view) { return view; }
+};
+
+template <typename R>
+struct OcallReturn {
+  static_assert(
+      std::is_trivially_copyable<R>::value,
+      "ocall results must be trivially copyable");
+
+  template <typename F>
+  static unsigned long invoke(struct edge_call* edge_call, F call) {
+    void* data = reinterpret_cast<void*>(edge_call_data_ptr());
+    if (edge_call_check_ptr_valid((uintptr_t)data, sizeof(R))) {
+      return CALL_STATUS_BAD_PTR;
+    }
+    /* the argument views point where the result goes, so the handler must
+     * be done with them before any of it is written */
+    R result = call();
+    memcpy(data, &result, sizeof(R));
+    if (edge_call_setup_ret(edge_call, data, sizeof(R))) {
+      return CALL_STATUS_BAD_PTR;
+    }
+    return CALL_STATUS_OK;
+  }
+};
+
+template <>
+struct OcallReturn<void> {
+  template <typename F>
+  static unsigned long invoke(struct edge_call* edge_call, F call) {
+    call();
+    return CALL_STATUS_OK;
+  }
+};
+
+template <>
+struct OcallReturn<OcallBuffer> {
+  template <typename F>
+  static unsigned long invoke(struct edge_call* edge_call, F call) {
+    OcallBuffer ret = call();
+    if (edge_call_setup_ret(edge_call, ret.data, ret.size)) {
+      return CALL_STATUS_BAD_PTR;
+    }
+    return CALL_STATUS_OK;
+  }
+};
+
+template <size_t... I>
+struct OcallIndices {};
+template <size_t N, size_t... I>
+struct OcallMakeIndices : OcallMakeIndices<N - 1, N - 1, I...> {};
+template <size_t... I>
+struct OcallMakeIndices<0, I...> {
+  typedef OcallIndices<I...> type;
+};
+
+template <typename R, typename... Args>
+class OcallWrapper {
+ private:
+  std::function<R(Args...)> func;
+
+  template <size_t... I>
+  unsigned long call(
+      struct edge_call* edge_call, uintptr_t args, size_t len,
+      OcallIndices<I...>) {
+    std::tuple<typename OcallArg<Args>::View...> views;
+    size_t off = 0;
+    bool ok    = true;
+
+    /* braced initializers are evaluated in order */
+    int unused[] = {
+        0, (ok = ok && OcallArg<Args>::decode(args, len, off, std::get<I>(views)),
+            0)...};
+    (void)unused;
+    (void)off;
+    if (!ok) {
+      return CALL_STATUS_BAD_OFFSET;
+    }
+
+    return OcallReturn<R>::invoke(edge_call, [&]() -> R {
+      return func(OcallArg<Args>::get(std::get<I>(views))...);
+    });
+  }
+
+ public:
+  explicit OcallWrapper(std::function<R(Args...)> f) : func(f) {}
+
+  void operator()(void* buffer) {
+    struct edge_call* edge_call = (struct edge_call*)buffer;
+    uintptr_t args;
+    size_t len;
+    if (edge_call_args_ptr(edge_call, &args, &len) != 0) {
+      edge_call->return_data.call_status = CALL_STATUS_BAD_OFFSET;
+      return;
+    }
+    edge_call->return_data.call_status = call(
+        edge_call, args, len,
+        typename OcallMakeIndices<sizeof...(Args)>::type());
+  }
+};
+
+/* register_call() takes a plain function pointer, so every call id gets its
+ * own trampoline and handler. Both are per process, like the call table:
+ * registering ID again, from any Enclave, replaces the handler for all of
+ * them. */
+template <unsigned long ID>
+struct OcallSlot {
+  static std::function<void(void*)> handler;
+  static void dispatch(void* buffer) { handler(buffer); }
+};
+
+template <unsigned long ID>
+std::function<void(void*)> OcallSlot<ID>::handler;
+
+}  // namespace Keystone
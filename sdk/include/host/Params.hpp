@@ -36,19 +36,24 @@ class Params {
     untrusted_size = DEFAULT_UNTRUSTED_SIZE;
     connect_size = DEFAULT_CONNECT_SIZE;
     freemem_size   = DEFAULT_FREEMEM_SIZE;
+    measure_flags  = 0;
   }
 
   void setUntrustedSize(uint64_t size) { untrusted_size = size; }
   void setConnectSize(uint64_t size) { connect_size = size; }
   void setFreeMemSize(uint64_t size) { freemem_size = size; }
+  /* SM_MEASURE_* flags; must match what Enclave::measure() was given */
+  void setMeasureFlags(uint64_t flags) { measure_flags = flags; }
   uintptr_t getUntrustedSize() { return untrusted_size; }
   uintptr_t getConnectSize() { return connect_size; }
   uintptr_t getFreeMemSize() { return freemem_size; }
+  uintptr_t getMeasureFlags() { return measure_flags; }
 
  private:
   uint64_t untrusted_size;
   uint64_t connect_size;
   uint64_t freemem_size;
+  uint64_t measure_flags;
 };
 
 }  // namespace Keystone
@@ -1 +1,2 @@
 #include "Enclave.hpp"
+#include "EnclaveGroup.hpp"
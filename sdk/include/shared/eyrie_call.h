@@ -7,6 +7,8 @@
 #define RUNTIME_SYSCALL_ATTEST_ENCLAVE      1003
 #define RUNTIME_SYSCALL_GET_SEALING_KEY     1004
 #define RUNTIME_SYSCALL_CONNECT_ENCLAVES    1005
+#define RUNTIME_SYSCALL_ATTEST_MAC          1006
+#define RUNTIME_SYSCALL_OCALL_V             1007
 #define RUNTIME_SYSCALL_EXIT                1101
 
 #endif  // __EYRIE_CALL_H__
@@ -32,7 +32,17 @@
   _IOR(KEYSTONE_IOC_MAGIC, 0x09, struct keystone_ioctl_con_enclave)
 #define KEYSTONE_IOC_GET_SMEID \
   _IOR(KEYSTONE_IOC_MAGIC, 0x0A, unsigned int)
-  
+#define KEYSTONE_IOC_GET_STATS \
+  _IOR(KEYSTONE_IOC_MAGIC, 0x0B, struct keystone_ioctl_stats)
+#define KEYSTONE_IOC_DRAIN_TRACE \
+  _IOR(KEYSTONE_IOC_MAGIC, 0x0C, struct keystone_ioctl_trace)
+#define KEYSTONE_IOC_CLONE_ENCLAVE \
+  _IOR(KEYSTONE_IOC_MAGIC, 0x0D, struct keystone_ioctl_clone_enclave)
+#define KEYSTONE_IOC_RUN_ENCLAVE_ASYNC \
+  _IOR(KEYSTONE_IOC_MAGIC, 0x0E, struct keystone_ioctl_run_enclave)
+#define KEYSTONE_IOC_RESUME_ENCLAVE_ASYNC \
+  _IOR(KEYSTONE_IOC_MAGIC, 0x0F, struct keystone_ioctl_run_enclave)
+
 #define RT_NOEXEC 0
 #define USER_NOEXEC 1
 #define RT_FULL 2
@@ -54,6 +64,7 @@ struct keystone_ioctl_create_enclave {
   uintptr_t user_paddr;
   uintptr_t free_paddr;
   uintptr_t free_requested;
+  uintptr_t measure_flags; // SM_MEASURE_*
 
   // driver -> host
   uintptr_t epm_paddr;
@@ -62,6 +73,22 @@ struct keystone_ioctl_create_enclave {
   uintptr_t sem_paddr;
 };
 
+struct keystone_ioctl_clone_enclave {
+  // host -> driver
+  uintptr_t src_eid;
+
+  // driver -> host
+  uintptr_t eid;
+  uintptr_t epm_paddr;
+  uintptr_t epm_size;
+  uintptr_t utm_paddr;
+  uintptr_t utm_size;
+};
+
+/* RUN/RESUME_ENCLAVE fill in error/value before returning. The _ASYNC
+ * variants only take eid and return at once; the enclave device fd becomes
+ * readable (poll/epoll) when the enclave stops for anything but a timer
+ * interrupt, and read() on it returns this struct with error/value set. */
 struct keystone_ioctl_run_enclave {
   uintptr_t eid;
   uintptr_t error;
@@ -74,4 +101,17 @@ struct keystone_ioctl_con_enclave {
   uintptr_t eid2;
 };
 
+struct keystone_ioctl_stats {
+  uintptr_t eid;     // SM_STATS_ENCLAVE
+  uintptr_t hartid;  // SM_STATS_HART
+  uintptr_t type;
+  struct sm_stats stats;
+};
+
+struct keystone_ioctl_trace {
+  uintptr_t hartid;
+  uintptr_t events;  // user buffer of struct sm_trace_event
+  uintptr_t count;   // in: buffer capacity, out: number of events drained
+};
+
 #endif
@@ -15,6 +15,9 @@
 #define SBI_SM_DESTROY_ENCLAVE   2002
 #define SBI_SM_RUN_ENCLAVE       2003
 #define SBI_SM_RESUME_ENCLAVE    2005
+#define SBI_SM_GET_STATS         2006
+#define SBI_SM_DRAIN_TRACE       2007
+#define SBI_SM_CLONE_ENCLAVE     2008
 #define FID_RANGE_HOST           2999
 
 /* 3000-3999 are called by enclave */
@@ -23,6 +26,7 @@
 #define SBI_SM_GET_SEALING_KEY   3003
 #define SBI_SM_STOP_ENCLAVE      3004
 #define SBI_SM_EXIT_ENCLAVE      3006
+#define SBI_SM_ATTEST_MAC        3007
 #define FID_RANGE_ENCLAVE        3999
 
 /* 4000-4999 are experimental */
@@ -43,6 +47,38 @@
 #define STOP_EDGE_CALL_HOST   1
 #define STOP_EXIT_ENCLAVE     2
 
+/* Performance counter scopes for SBI_SM_GET_STATS */
+#define SM_STATS_ENCLAVE      0
+#define SM_STATS_HART         1
+
+/* Enclave measurement formats, see keystone_sbi_create_t.measure_flags.
+ * The default (0) hashes the region sizes and then every page of the image
+ * as a single SHA3 stream. Any other format starts with the 64-bit words
+ * (SM_MEASURE_FORMAT_TAG | flags, SM_MEASURE_TREE_CHUNK_PAGES); no size
+ * has the tag bit set, so it can't be mistaken for the default format.
+ * - SM_MEASURE_TREE: every SM_MEASURE_TREE_CHUNK_PAGES pages are hashed on
+ *   their own and the measurement covers the list of chunk hashes, so the
+ *   chunks can be hashed in parallel.
+ * - SM_MEASURE_SPARSE: pages go in groups of 64 behind a bitmap of the
+ *   non-zero pages of the group; zero pages are not hashed. */
+#define SM_MEASURE_TREE              0x1
+#define SM_MEASURE_SPARSE            0x2
+#define SM_MEASURE_FLAGS_ALL         (SM_MEASURE_TREE | SM_MEASURE_SPARSE)
+#define SM_MEASURE_TREE_CHUNK_PAGES  32
+#define SM_MEASURE_FORMAT_TAG        (1ULL << 63)
+
+/* SBI_SM_ATTEST_ENCLAVE writes a report of this size. The log can be any
+ * length: the SM streams it through SHA3-512 and signs only the digest,
+ * so the log itself travels next to the report. */
+#define ATTEST_REPORT_SIZE    1424
+
+/* SBI_SM_ATTEST_MAC: the MAC key of an enclave for a verifier is
+ * SHA3-512(ATTEST_MAC_KEY_LABEL || X25519(SM key, verifier key) || enclave
+ * hash), and the tag of some data is SHA3-512(MAC key || data) */
+#define ATTEST_MAC_KEY_LABEL  "keystone attestation mac"
+#define ATTEST_MAC_SIZE       64
+#define ATTEST_MAC_PEER_SIZE  32  // ed25519 public key of the verifier
+
 /* Structs for interfacing into the SM */
 struct runtime_params_t {
   uintptr_t dram_base;
@@ -71,6 +107,47 @@ struct keystone_sbi_create_t {
   uintptr_t user_paddr;
   uintptr_t free_paddr;
   uintptr_t free_requested;
+  uintptr_t measure_flags;
+};
+
+/* SM performance counters, kept per enclave and per hart.
+ * Cycle counts are read from mcycle on the hart doing the work. */
+struct sm_stats {
+  uint64_t run;
+  uint64_t resume;
+  uint64_t exit;
+  uint64_t stop_edge_call;
+  uint64_t stop_interrupt;
+  uint64_t switch_to_enclave_cycles;
+  uint64_t switch_to_host_cycles;
+  uint64_t hash_cycles;
+  uint64_t sign_cycles;
+  uint64_t destroy_cycles;
+};
+
+/* SM trace event types, see SBI_SM_DRAIN_TRACE */
+#define SM_TRACE_CREATE       1  // arg: EPM size
+#define SM_TRACE_DESTROY      2
+#define SM_TRACE_RUN          3
+#define SM_TRACE_RESUME       4
+#define SM_TRACE_STOP         5  // arg: stop request (STOP_*)
+#define SM_TRACE_EXIT         6  // arg: return value
+#define SM_TRACE_PMP_SET      7  // arg: (region << 8) | perm
+#define SM_TRACE_PMP_UNSET    8  // arg: region
+#define SM_TRACE_IPI          9  // arg: target hart mask
+#define SM_TRACE_ATTEST       10 // arg: 0 for a report, 1 for a MAC
+#define SM_TRACE_CONNECT      11 // arg: the other enclave's eid
+#define SM_TRACE_CLONE        12 // arg: source eid
+
+#define SM_TRACE_NO_EID       0xffffffff
+
+/* One entry of the per-hart SM trace ring. The timestamp is read from the
+ * platform timer, so events from different harts can be merged. */
+struct sm_trace_event {
+  uint64_t time;
+  uint32_t type;
+  uint32_t eid;
+  uint64_t arg;
 };
 
 #endif  // __SM_CALL_H__
@@ -6,9 +6,13 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
 #include "Keys.hpp"
+extern "C" {
 #include "common/sha3.h"
+}
 #include "ed25519/ed25519.h"
+#include "shared/sm_call.h"
 #include "verifier/json11.h"
 
 struct enc_info {
@@ -21,7 +25,7 @@ struct enclave_report_t {
   uint64_t data_len;
   uint64_t log_len;
   byte data[ATTEST_DATA_MAXLEN];
-  byte log[ATTEST_DATA_MAXLEN];
+  byte log_hash[MDSIZE];
   byte signature[SIGNATURE_SIZE];
 };
 
@@ -37,15 +41,65 @@ struct report_t {
   byte dev_public_key[PUBLIC_KEY_SIZE];
 };
 
+/* Compact wire format: a fixed little-endian header followed by only the
+ * used part of data. Fields are packed with no padding. Like the log
+ * itself, which travels separately, the format only carries its digest.
+ *
+ *   0   magic "KSRP"        4   version (u16)    6   flags (u16)
+ *   8   device public key   40  SM hash          104 SM public key
+ *   136 SM signature        200 enclave hash     264 data_len (u64)
+ *   272 log_len (u64)       280 log hash         344 enclave signature
+ *   408 data[data_len], or data[ATTEST_DATA_MAXLEN] with
+ *       REPORT_WIRE_FULL_DATA
+ *
+ * Without REPORT_WIRE_FULL_DATA, the signed data tail is all zeroes. */
+#define REPORT_WIRE_MAGIC 0x5052534b
+#define REPORT_WIRE_VERSION 2
+#define REPORT_WIRE_FULL_DATA 0x1
+#define REPORT_WIRE_HEADER_SIZE 408
+#define REPORT_WIRE_MAX_SIZE (REPORT_WIRE_HEADER_SIZE + ATTEST_DATA_MAXLEN)
+
+/* Validates a compact report in place and verifies it without copying
+ * or allocating. The buffer must outlive the view. */
+class ReportView {
+ private:
+  const byte* buf = nullptr;
+  const byte* data;
+  uint64_t data_len;
+  uint64_t log_len;
+  uint16_t flags;
+
+ public:
+  bool parse(const byte* bin, size_t len);
+  int verify(
+      const byte* expected_enclave_hash, const byte* expected_sm_hash,
+      const byte* dev_public_key) const;
+  int checkSignaturesOnly(const byte* dev_public_key) const;
+  const byte* getDevicePublicKey() const;
+  const byte* getEnclaveHash() const;
+  const byte* getSmHash() const;
+  const byte* getDataSection() const { return data; }
+  size_t getDataSize() const { return data_len; }
+  /* Length of the signed log; checkLog() matches a log against it */
+  size_t getLogSize() const { return log_len; }
+  bool checkLog(const byte* log, size_t len) const;
+};
+
 class Report {
  private:
   struct report_t report;
+  std::vector<byte> log;
+  byte mac_key[MDSIZE];
+  bool mac_key_valid = false;
 
  public:
   std::string BytesToHex(byte* bytes, size_t len);
   void HexToBytes(byte* bytes, size_t len, std::string hexstr);
   void fromJson(std::string json);
   void fromBytes(byte* bin);
+  /* Compact wire format, see REPORT_WIRE_MAGIC */
+  bool fromCompact(const byte* bin, size_t len);
+  std::vector<byte> toCompact();
   std::string stringfy();
   void printJson();
   void printPretty();
@@ -53,10 +107,32 @@ class Report {
       const byte* expected_enclave_hash, const byte* expected_sm_hash,
       const byte* dev_public_key);
   int checkSignaturesOnly(const byte* dev_public_key);
+  /* Same as verify()/checkSignaturesOnly() on every report, with one
+   * ed25519 batch per chunk of signatures spread over worker threads.
+   * Identical SM reports are checked once. threads = 0 picks the number
+   * of hardware threads. Returns one result per report. A signature
+   * crafted against the batch equation can pass here but fail verify(),
+   * see ed25519_verify_batch(). */
+  static std::vector<int> verifyBatch(
+      std::vector<Report>& reports, const byte* expected_enclave_hash,
+      const byte* expected_sm_hash, const byte* dev_public_key,
+      unsigned int threads = 0);
+  static std::vector<int> checkSignaturesBatch(
+      std::vector<Report>& reports, const byte* dev_public_key,
+      unsigned int threads = 0);
+  /* Tags from attest_enclave_mac(), for a report that passed verify().
+   * The private key is the 64-byte ed25519 key of the verifier. */
+  void setMacVerifierKey(const byte* verifier_private_key);
+  int verifyMac(const byte* tag, const byte* data, size_t len);
   void* getDataSection();
   size_t getDataSize();
+  /* The log is sent next to the report; it is kept only if it matches the
+   * signed log hash. Until then getLogSection() is NULL and getLogSize()
+   * is 0. */
+  bool setLog(const byte* log, size_t len);
   void* getLogSection();
   size_t getLogSize();
+  byte* getLogHash();
   byte* getEnclaveHash();
   byte* getSmHash();
 };
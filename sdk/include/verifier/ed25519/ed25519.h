@@ -36,11 +36,27 @@ int ED25519_DECLSPEC
 ed25519_verify(
     const unsigned char* signature, const unsigned char* message,
     size_t message_len, const unsigned char* public_key);
+/* Same as ed25519_verify, for a message split over num_parts buffers */
+int ED25519_DECLSPEC
+ed25519_verify_parts(
+    const unsigned char* signature, const unsigned char* const* parts,
+    const size_t* part_lens, size_t num_parts,
+    const unsigned char* public_key);
+/* Verifies n signatures at once. valid[i], if given, receives each result.
+ * Returns 1 only if every signature is valid. Maliciously built signatures
+ * can pass here and still fail ed25519_verify, see batch.c. */
+int ED25519_DECLSPEC
+ed25519_verify_batch(
+    const unsigned char* const* signatures,
+    const unsigned char* const* messages, const size_t* message_lens,
+    const unsigned char* const* public_keys, size_t n, int* valid);
 
 // void ED25519_DECLSPEC ed25519_add_scalar(unsigned char *public_key, unsigned
 // char *private_key, const unsigned char *scalar);
-// void ED25519_DECLSPEC ed25519_key_exchange(unsigned char *shared_secret,
-// const unsigned char *public_key, const unsigned char *private_key);
+void ED25519_DECLSPEC
+ed25519_key_exchange(
+    unsigned char* shared_secret, const unsigned char* public_key,
+    const unsigned char* private_key);
 
 #ifdef __cplusplus
 }
@@ -1,6 +1,7 @@
 #ifndef GE_H
 #define GE_H
 
+#include <stddef.h>
 #include "fe.h"
 
 /*
@@ -65,6 +66,10 @@ void
 ge_double_scalarmult_vartime(
     ge_p2* r, const unsigned char* a, const ge_p3* A, const unsigned char* b);
 void
+ge_multi_scalarmult_vartime(
+    ge_p3* r, const unsigned char* b, const unsigned char* scalars,
+    const ge_p3* points, size_t n, signed char* aslide, ge_cached* Ai);
+void
 ge_madd(ge_p1p1* r, const ge_p3* p, const ge_precomp* q);
 void
 ge_msub(ge_p1p1* r, const ge_p3* p, const ge_precomp* q);
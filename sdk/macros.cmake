@@ -158,3 +158,26 @@ macro(add_keystone_package target_name package_name package_script) # files are
     )
 
 endmacro(add_keystone_package)
+
+# CMake macro for edge call stubs generated from an IDL file
+# (see scripts/keystone-edgegen.py). Sets ${name}_EAPP_SOURCES,
+# ${name}_HOST_SOURCES and ${name}_INCLUDE_DIR for the two sides.
+macro(add_edge_idl name idl)
+  find_program(PYTHON3 python3)
+
+  set(${name}_INCLUDE_DIR ${CMAKE_CURRENT_BINARY_DIR}/${name}-edge)
+  set(${name}_EAPP_SOURCES ${${name}_INCLUDE_DIR}/${name}_eapp.c)
+  set(${name}_HOST_SOURCES ${${name}_INCLUDE_DIR}/${name}_host.c)
+  get_filename_component(idl_path ${idl} ABSOLUTE)
+
+  add_custom_command(
+    OUTPUT
+      ${${name}_INCLUDE_DIR}/${name}_edge.h
+      ${${name}_INCLUDE_DIR}/${name}_eapp.h ${${name}_EAPP_SOURCES}
+      ${${name}_INCLUDE_DIR}/${name}_host.h ${${name}_HOST_SOURCES}
+    COMMAND ${PYTHON3} ${KEYSTONE_SDK_DIR}/bin/keystone-edgegen.py
+      --name ${name} --out ${${name}_INCLUDE_DIR} ${idl_path}
+    DEPENDS ${idl_path} ${KEYSTONE_SDK_DIR}/bin/keystone-edgegen.py
+    COMMENT "Generating edge calls for ${name}")
+
+endmacro(add_edge_idl)
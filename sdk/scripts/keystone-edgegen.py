@@ -0,0 +1,581 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2020, The Regents of the University of California (Regents).
+# All Rights Reserved. See LICENSE for license details.
+#
+"""Generates matching enclave stubs and host wrappers for ocalls.
+
+The IDL is a list of C-like declarations:
+
+    // the string is copied in, the result comes back in place
+    ocall 1 unsigned long print_string([in, string] const char* str);
+
+    // len bytes go out to the host and come back modified
+    ocall 2 int transform([inout, size=len] void* buf, size_t len);
+
+    // n elements are filled in by the host
+    ocall 3 void read_values([out, count=n] unsigned long* values, size_t n);
+
+    // queued in the enclave and sent together, see <name>_flush()
+    [batch] ocall 4 void log_value(unsigned long value);
+
+Scalar parameters are passed by value. Pointer parameters need a direction,
+in, out or inout, and a length: string (in only), size=<bytes> or
+count=<elements>, where the length is a scalar parameter or a number.
+Batched calls must return void and take in parameters only.
+
+Calls go through ocall_v(): every buffer is copied once, straight between
+enclave memory and the shared buffer, and the host reads and writes it in
+place. Lengths are checked once on each side.
+
+The enclave stubs return 0 on success and non-zero if the call failed; the
+result of a call that returns a value is written to an extra last
+parameter, ret, instead.
+
+For <name>.edge this writes, to the output directory:
+
+    <name>_edge.h   call ids and argument layouts, shared by both sides
+    <name>_eapp.h   ocall_<fn>() stubs for the enclave
+    <name>_eapp.c
+    <name>_host.h   handler prototypes and <name>_register_ocalls()
+    <name>_host.c
+"""
+
+import argparse
+import os
+import re
+import sys
+
+# keep in sync with edge_common.h / edge_syscall.h
+MAX_EDGE_CALL = 10
+RESERVED_IDS = {MAX_EDGE_CALL + 1: "EDGECALL_SYSCALL",
+                MAX_EDGE_CALL + 2: "EDGECALL_BATCH"}
+EDGE_IOV_MAX = 16
+
+IDENT = r"[A-Za-z_]\w*"
+
+
+class IdlError(Exception):
+    pass
+
+
+class Param:
+    def __init__(self, text):
+        attrs = ""
+        m = re.match(r"\s*\[([^\]]*)\]\s*(.*)$", text, re.S)
+        if m:
+            attrs, text = m.group(1), m.group(2)
+        m = re.match(r"(.*?)(" + IDENT + r")\s*$", text.strip(), re.S)
+        if not m or not m.group(1).strip():
+            raise IdlError("cannot parse parameter '%s'" % text.strip())
+        self.type = " ".join(m.group(1).split())
+        self.name = m.group(2)
+        self.is_ptr = "*" in self.type
+        self.direction = None
+        self.string = False
+        self.size = None
+        self.count = None
+
+        for attr in [a.strip() for a in attrs.split(",") if a.strip()]:
+            if attr in ("in", "out", "inout"):
+                if self.direction:
+                    raise IdlError("%s: more than one direction" % self.name)
+                self.direction = attr
+            elif attr == "string":
+                self.string = True
+            elif re.match(r"(size|count)\s*=", attr):
+                key, value = [x.strip() for x in attr.split("=", 1)]
+                setattr(self, key, value)
+            else:
+                raise IdlError("%s: unknown attribute '%s'" % (self.name, attr))
+
+    @property
+    def is_in(self):
+        return self.direction in ("in", "inout")
+
+    @property
+    def is_out(self):
+        return self.direction in ("out", "inout")
+
+    @property
+    def elem_type(self):
+        return self.type[: self.type.rindex("*")].strip()
+
+    @property
+    def len_field(self):
+        return "edge_len_" + self.name
+
+
+class Ocall:
+    def __init__(self, text):
+        m = re.match(
+            r"\s*(?:\[(?P<attrs>[^\]]*)\])?\s*ocall\s+(?P<id>\d+)\s+"
+            r"(?P<ret>.+?)\b(?P<name>" + IDENT + r")\s*\((?P<params>.*)\)\s*$",
+            text, re.S)
+        if not m:
+            raise IdlError("cannot parse '%s'" % " ".join(text.split()))
+
+        self.id = int(m.group("id"))
+        self.ret = " ".join(m.group("ret").split())
+        self.name = m.group("name")
+        attrs = [a.strip() for a in (m.group("attrs") or "").split(",")]
+        self.batch = "batch" in attrs
+        for attr in attrs:
+            if attr not in ("", "batch"):
+                raise IdlError("%s: unknown attribute '%s'" % (self.name, attr))
+
+        params = split_params(m.group("params"))
+        if params == ["void"]:
+            params = []
+        self.params = [Param(p) for p in params]
+        self.check()
+
+    @property
+    def has_ret(self):
+        return self.ret != "void"
+
+    @property
+    def scalars(self):
+        return [p for p in self.params if not p.is_ptr]
+
+    @property
+    def buffers(self):
+        return [p for p in self.params if p.is_ptr]
+
+    def segments(self):
+        return (1 if self.params else 0) + (1 if self.has_ret else 0) + \
+            len(self.buffers)
+
+    def check(self):
+        where = "%s (ocall %d)" % (self.name, self.id)
+        if self.id in RESERVED_IDS:
+            raise IdlError("%s: id is reserved for %s" %
+                           (where, RESERVED_IDS[self.id]))
+        if "*" in self.ret:
+            raise IdlError("%s: pointers cannot be returned, use an out "
+                           "parameter" % where)
+
+        names = [p.name for p in self.params]
+        if len(set(names)) != len(names):
+            raise IdlError("%s: duplicate parameter names" % where)
+        if self.has_ret and "ret" in names:
+            raise IdlError("%s: ret is the name of the result parameter" %
+                           where)
+        scalars = set(p.name for p in self.scalars)
+
+        for p in self.params:
+            if not p.is_ptr:
+                if p.direction or p.string or p.size or p.count:
+                    raise IdlError("%s: %s is not a pointer, it takes no "
+                                   "attributes" % (where, p.name))
+                continue
+            if p.len_field in names:
+                raise IdlError("%s: %s clashes with a generated field" %
+                               (where, p.len_field))
+            if not p.direction:
+                raise IdlError("%s: %s needs [in], [out] or [inout]" %
+                               (where, p.name))
+            lengths = [x for x in (p.string, p.size, p.count) if x]
+            if len(lengths) != 1:
+                raise IdlError("%s: %s needs exactly one of string, size= or "
+                               "count=" % (where, p.name))
+            if p.string and (p.direction != "in" or
+                             p.elem_type.replace("const", "").strip() != "char"):
+                raise IdlError("%s: string only applies to [in] char*" % where)
+            if p.count and p.elem_type.replace("const", "").strip() == "void":
+                raise IdlError("%s: count= needs a typed pointer, use size= "
+                               "for %s" % (where, p.name))
+            for length in (p.size, p.count):
+                if length and not length.isdigit() and length not in scalars:
+                    raise IdlError("%s: length of %s must be a number or a "
+                                   "scalar parameter" % (where, p.name))
+            if p.is_out and "const" in p.elem_type.split():
+                raise IdlError("%s: %s is written by the host, it cannot be "
+                               "const" % (where, p.name))
+
+        if self.batch:
+            if self.has_ret or any(p.is_out for p in self.params):
+                raise IdlError("%s: batched calls cannot return anything" %
+                               where)
+        if self.segments() > EDGE_IOV_MAX:
+            raise IdlError("%s: too many buffers, at most %d segments" %
+                           (where, EDGE_IOV_MAX))
+
+
+def split_params(text):
+    params, depth, cur = [], 0, ""
+    for c in text:
+        if c in "[(":
+            depth += 1
+        elif c in "])":
+            depth -= 1
+        if c == "," and depth == 0:
+            params.append(cur)
+            cur = ""
+        else:
+            cur += c
+    if cur.strip():
+        params.append(cur)
+    return [p.strip() for p in params]
+
+
+def parse(text):
+    text = re.sub(r"/\*.*?\*/", " ", text, flags=re.S)
+    text = re.sub(r"//[^\n]*", " ", text)
+    ocalls = [Ocall(s) for s in text.split(";") if s.strip()]
+
+    for what in ("id", "name"):
+        seen = {}
+        for o in ocalls:
+            key = getattr(o, what)
+            if key in seen:
+                raise IdlError("ocall %s %s is declared twice" % (what, key))
+            seen[key] = o
+    return ocalls
+
+
+def byte_len(p, ref):
+    """C expression for the length of buffer p; ref(name) reads a scalar"""
+    if p.string:
+        return "strlen((char*)%s) + 1" % p.name
+    if p.size:
+        return "(size_t)(%s)" % (p.size if p.size.isdigit() else ref(p.size))
+    return "(size_t)(%s) * sizeof(%s)" % (
+        p.count if p.count.isdigit() else ref(p.count), p.elem_type)
+
+
+def flags(p):
+    return " | ".join(
+        f for f, on in (("EDGE_IOV_IN", p.is_in), ("EDGE_IOV_OUT", p.is_out))
+        if on)
+
+
+def signature(o, fn):
+    params = ", ".join("%s %s" % (p.type, p.name) for p in o.params)
+    return "%s\n%s(%s)" % (o.ret, fn, params or "void")
+
+
+def stub_signature(o, fn):
+    """enclave side: returns the status, the result goes to *ret"""
+    params = ["%s %s" % (p.type, p.name) for p in o.params]
+    if o.has_ret:
+        params.append("%s* ret" % o.ret)
+    return "int\n%s(%s)" % (fn, ", ".join(params) or "void")
+
+
+class Generator:
+    def __init__(self, name, ocalls):
+        self.name = name
+        self.guard = re.sub(r"\W", "_", name).upper()
+        self.ocalls = ocalls
+        self.batched = any(o.batch for o in ocalls)
+
+    def header(self, out):
+        out.append("/* Generated by keystone-edgegen.py, do not edit */")
+
+    def args_struct(self, o):
+        return "struct %s_%s_args" % (self.name, o.name)
+
+    def call_id(self, o):
+        return "%s_OCALL_%s" % (self.guard, o.name.upper())
+
+    def edge_h(self):
+        out = []
+        self.header(out)
+        out += ["#ifndef __%s_EDGE_H_" % self.guard,
+                "#define __%s_EDGE_H_" % self.guard, "",
+                "#include <stddef.h>", "#include <stdint.h>",
+                '#include "edge_common.h"', ""]
+        for o in self.ocalls:
+            out.append("#define %s %d" % (self.call_id(o), o.id))
+        out.append("")
+        for o in self.ocalls:
+            if not o.params:
+                continue
+            out.append("%s {" % self.args_struct(o))
+            for p in o.scalars:
+                out.append("  %s %s;" % (p.type, p.name))
+            for p in o.buffers:
+                out.append("  size_t %s;" % p.len_field)
+            out += ["};", ""]
+        out.append("#endif /* __%s_EDGE_H_ */" % self.guard)
+        return out
+
+    def eapp_h(self):
+        out = []
+        self.header(out)
+        out += ["#ifndef __%s_EAPP_H_" % self.guard,
+                "#define __%s_EAPP_H_" % self.guard, "",
+                '#include "%s_edge.h"' % self.name, ""]
+        out += ["/* Return 0, or non-zero if the call failed; a call that "
+                "fails leaves *ret",
+                "   (which must be valid) and out buffers untouched. [batch] "
+                "calls only fail",
+                "   here if they cannot be queued, what the host makes of them "
+                "is returned",
+                "   by the call that sends them. */"]
+        for o in self.ocalls:
+            out += [stub_signature(o, "ocall_" + o.name) + ";"]
+        if self.batched:
+            out += ["",
+                    "/* Sends the queued [batch] calls. Other calls flush the "
+                    "queue first, so",
+                    "   ordering is kept; call this before the enclave exits "
+                    "or waits. */",
+                    "int", "%s_flush(void);" % self.name]
+        out += ["", "#endif /* __%s_EAPP_H_ */" % self.guard]
+        return out
+
+    def eapp_c(self):
+        out = []
+        self.header(out)
+        out += ['#include "%s_eapp.h"' % self.name,
+                '#include "string.h"', '#include "syscall.h"', "",
+                "static void",
+                "edgegen_iov(",
+                "    struct edge_iovec* iov, const void* base, size_t len,",
+                "    unsigned long flags) {",
+                "  iov->base  = (void*)base;",
+                "  iov->len   = len;",
+                "  iov->flags = flags;",
+                "}", ""]
+        if self.batched:
+            out += self.eapp_batch()
+        for o in self.ocalls:
+            out += self.eapp_stub(o)
+        return out
+
+    def eapp_batch(self):
+        n, g = self.name, self.guard
+        return [
+            "#ifndef %s_BATCH_SIZE" % g,
+            "#define %s_BATCH_SIZE 4096" % g,
+            "#endif", "",
+            "static char %s_batch[%s_BATCH_SIZE]" % (n, g),
+            "    __attribute__((aligned(EDGE_IOV_ALIGN)));",
+            "static size_t %s_batch_len;" % n, "",
+            "int", "%s_flush(void) {" % n,
+            "  struct edge_iovec iov;", "",
+            "  if (!%s_batch_len) {" % n,
+            "    return 0;",
+            "  }",
+            "  edgegen_iov(&iov, %s_batch, %s_batch_len, EDGE_IOV_IN);" % (n, n),
+            "  %s_batch_len = 0;" % n,
+            "  return ocall_v(EDGECALL_BATCH, &iov, 1);",
+            "}", "",
+            "/* Queues a call, laid out as ocall_v() would lay it out. Fails "
+            "if a full",
+            "   queue could not be sent first. */",
+            "static int",
+            "%s_batch_add(unsigned long call_id, struct edge_iovec* iov, "
+            "size_t count) {" % n,
+            "  struct edge_batch_record* record;",
+            "  size_t size = 0, off, i;", "",
+            "  for (i = 0; i < count; i++) {",
+            "    size = EDGE_IOV_ALIGN_UP(size) + iov[i].len;",
+            "  }",
+            "  if (EDGE_IOV_ALIGN_UP(sizeof(*record)) + size > "
+            "%s_BATCH_SIZE) {" % g,
+            "    /* too large to ever queue */",
+            "    return %s_flush() || ocall_v(call_id, iov, count);" % n,
+            "  }",
+            "  if (EDGE_IOV_ALIGN_UP(%s_batch_len) +" % n,
+            "              EDGE_IOV_ALIGN_UP(sizeof(*record)) + size >",
+            "          %s_BATCH_SIZE &&" % g,
+            "      %s_flush()) {" % n,
+            "    return -1;",
+            "  }", "",
+            "  off    = EDGE_IOV_ALIGN_UP(%s_batch_len);" % n,
+            "  record = (struct edge_batch_record*)(%s_batch + off);" % n,
+            "  record->call_id = call_id;",
+            "  record->size    = size;",
+            "  off += EDGE_IOV_ALIGN_UP(sizeof(*record));", "",
+            "  size = 0;",
+            "  for (i = 0; i < count; i++) {",
+            "    size = EDGE_IOV_ALIGN_UP(size);",
+            "    memcpy(%s_batch + off + size, iov[i].base, iov[i].len);" % n,
+            "    size += iov[i].len;",
+            "  }",
+            "  %s_batch_len = off + size;" % n,
+            "  return 0;",
+            "}", ""]
+
+    def eapp_stub(self, o):
+        out = [stub_signature(o, "ocall_" + o.name) + " {"]
+        if o.params:
+            out.append("  %s args;" % self.args_struct(o))
+        nseg = o.segments()
+        if nseg:
+            out.append("  struct edge_iovec iov[%d];" % nseg)
+        if len(out) > 1:
+            out.append("")
+
+        for p in o.scalars:
+            out.append("  args.%s = %s;" % (p.name, p.name))
+        for p in o.buffers:
+            out.append("  args.%s = %s;" % (p.len_field,
+                                            byte_len(p, lambda s: s)))
+
+        i = 0
+        if o.params:
+            out.append("  edgegen_iov(&iov[%d], &args, sizeof(args), "
+                       "EDGE_IOV_IN);" % i)
+            i += 1
+        if o.has_ret:
+            out.append("  edgegen_iov(&iov[%d], ret, sizeof(*ret), "
+                       "EDGE_IOV_OUT);" % i)
+            i += 1
+        for p in o.buffers:
+            out.append("  edgegen_iov(&iov[%d], %s, args.%s, %s);" %
+                       (i, p.name, p.len_field, flags(p)))
+            i += 1
+        if nseg:
+            out.append("")
+
+        iov = "iov" if nseg else "NULL"
+        if o.batch:
+            out.append("  return %s_batch_add(%s, %s, %d);" %
+                       (self.name, self.call_id(o), iov, nseg))
+        elif self.batched:
+            out.append("  return %s_flush() || ocall_v(%s, %s, %d);" %
+                       (self.name, self.call_id(o), iov, nseg))
+        else:
+            out.append("  return ocall_v(%s, %s, %d);" %
+                       (self.call_id(o), iov, nseg))
+        out += ["}", ""]
+        return out
+
+    def host_h(self):
+        out = []
+        self.header(out)
+        out += ["#ifndef __%s_HOST_H_" % self.guard,
+                "#define __%s_HOST_H_" % self.guard, "",
+                '#include "%s_edge.h"' % self.name, "",
+                "#ifdef __cplusplus", 'extern "C" {', "#endif", "",
+                "/* To be implemented by the host application. Buffers point "
+                "into the",
+                "   shared buffer and are only valid during the call. */"]
+        for o in self.ocalls:
+            out.append(signature(o, o.name) + ";")
+        out += ["", "/* Registers the wrappers with register_call(); 0 on "
+                "success */",
+                "int", "%s_register_ocalls(void);" % self.name, "",
+                "#ifdef __cplusplus", "}", "#endif", "",
+                "#endif /* __%s_HOST_H_ */" % self.guard]
+        return out
+
+    def host_c(self):
+        out = []
+        self.header(out)
+        out += ['#include "%s_host.h"' % self.name,
+                '#include "edge_call.h"', ""]
+        for o in self.ocalls:
+            out += self.host_wrapper(o)
+        out += ["int", "%s_register_ocalls(void) {" % self.name]
+        for o in self.ocalls:
+            out += ["  if (register_call(%s, %s_wrapper)) {" %
+                    (self.call_id(o), o.name),
+                    "    return -1;", "  }"]
+        out += ["  return 0;", "}"]
+        return out
+
+    def host_wrapper(self, o):
+        out = ["static void", "%s_wrapper(void* buffer) {" % o.name,
+               "  struct edge_call* edge_call = (struct edge_call*)buffer;"]
+        if o.params:
+            out.append("  %s* args;" % self.args_struct(o))
+        if o.has_ret:
+            out.append("  %s* ret;" % o.ret)
+        for p in o.buffers:
+            out.append("  %s %s;" % (p.type, p.name))
+        out.append("  uintptr_t data%s;" % (", ptr" if o.segments() else ""))
+        out.append("  size_t len%s;" % (", off = 0" if o.segments() else ""))
+        out += ["",
+                "  if (edge_call_args_ptr(edge_call, &data, &len) != 0) {",
+                "    goto bad_offset;", "  }"]
+
+        def take(size, target, cast):
+            return ["  if (edge_call_iov_next(data, len, &off, %s, &ptr)) {"
+                    % size,
+                    "    goto bad_offset;", "  }",
+                    "  %s = (%s)ptr;" % (target, cast)]
+
+        if o.params:
+            out += take("sizeof(*args)", "args",
+                        "%s*" % self.args_struct(o))
+        if o.has_ret:
+            out += take("sizeof(*ret)", "ret", "%s*" % o.ret)
+        for p in o.buffers:
+            out += take("args->%s" % p.len_field, p.name, p.type)
+
+        checks = []
+        for p in o.buffers:
+            field = "args->%s" % p.len_field
+            if p.string:
+                checks.append("!%s || %s[%s - 1] != '\\0'" %
+                              (field, p.name, field))
+            elif p.size:
+                size = p.size if p.size.isdigit() else "args->" + p.size
+                checks.append("%s != (size_t)(%s)" % (field, size))
+            else:
+                count = p.count if p.count.isdigit() else "args->" + p.count
+                checks.append(
+                    "%s %% sizeof(%s) ||\n      %s / sizeof(%s) != "
+                    "(size_t)(%s)" % (field, p.elem_type, field, p.elem_type,
+                                      count))
+        if checks:
+            out += ["",
+                    "  /* the lengths must match the parameters that "
+                    "describe them */",
+                    "  if (" + " ||\n      ".join(checks) + ") {",
+                    "    goto bad_ptr;", "  }"]
+
+        call_args = ", ".join(
+            p.name if p.is_ptr else "args->" + p.name for p in o.params)
+        call = "%s(%s);" % (o.name, call_args)
+        out += ["", ("  *ret = " if o.has_ret else "  ") + call,
+                "  edge_call->return_data.call_status = CALL_STATUS_OK;",
+                "  return;", "",
+                "bad_offset:",
+                "  edge_call->return_data.call_status = "
+                "CALL_STATUS_BAD_OFFSET;",
+                "  return;"]
+        if checks:
+            out += ["", "bad_ptr:",
+                    "  edge_call->return_data.call_status = "
+                    "CALL_STATUS_BAD_PTR;"]
+        out += ["}", ""]
+        return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("idl", help="IDL file")
+    parser.add_argument("-o", "--out", default=".",
+                        help="output directory (default: .)")
+    parser.add_argument("-n", "--name",
+                        help="prefix of the generated files and symbols "
+                        "(default: IDL file name)")
+    args = parser.parse_args()
+
+    name = args.name or os.path.splitext(os.path.basename(args.idl))[0]
+    if not re.match(IDENT + "$", name):
+        sys.exit("%s: not a valid C identifier, use --name" % name)
+
+    try:
+        with open(args.idl) as f:
+            ocalls = parse(f.read())
+    except IdlError as e:
+        sys.exit("%s: %s" % (args.idl, e))
+
+    gen = Generator(name, ocalls)
+    os.makedirs(args.out, exist_ok=True)
+    for suffix, lines in (("_edge.h", gen.edge_h()), ("_eapp.h", gen.eapp_h()),
+                          ("_eapp.c", gen.eapp_c()), ("_host.h", gen.host_h()),
+                          ("_host.c", gen.host_c())):
+        with open(os.path.join(args.out, name + suffix), "w") as f:
+            f.write("\n".join(lines) + "\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,106 @@
+//******************************************************************************
+// Copyright (c) 2020, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#include "sealing.h"
+#include "common/sha3.h"
+#include "string.h"
+#include "syscall.h"
+
+int
+seal_key_init(
+    struct seal_key* key, const void* key_ident, size_t key_ident_size) {
+  struct sealing_key sealing_key;
+  uint8_t digest[64];
+  sha3_ctx_t ctx;
+  int ret;
+
+  ret = get_sealing_key(
+      &sealing_key, sizeof(sealing_key), (void*)key_ident, key_ident_size);
+  if (ret) return ret;
+
+  /* split one SHA3-512 of the sealing key into the two subkeys */
+  sha3_init(&ctx, 64);
+  sha3_update(&ctx, SEAL_KEY_LABEL, sizeof(SEAL_KEY_LABEL) - 1);
+  sha3_update(&ctx, sealing_key.key, SEALING_KEY_SIZE);
+  sha3_final(digest, &ctx);
+  memcpy(key->enc, digest, sizeof(key->enc));
+  memcpy(key->mac, digest + sizeof(key->enc), sizeof(key->mac));
+
+  memset(&sealing_key, 0, sizeof(sealing_key));
+  memset(digest, 0, sizeof(digest));
+  memset(&ctx, 0, sizeof(ctx));
+  return 0;
+}
+
+void
+seal_key_clear(struct seal_key* key) {
+  memset(key, 0, sizeof(*key));
+}
+
+static void
+seal_tag(
+    const struct seal_key* key, const uint8_t* nonce, const void* ct,
+    size_t len, uint8_t* tag) {
+  uint8_t len_le[8];
+  sha3_ctx_t ctx;
+  int i;
+
+  for (i = 0; i < 8; i++) len_le[i] = (uint8_t)((uint64_t)len >> (8 * i));
+
+  sha3_init(&ctx, SEAL_TAG_SIZE);
+  sha3_update(&ctx, key->mac, sizeof(key->mac));
+  sha3_update(&ctx, nonce, SEAL_NONCE_SIZE);
+  sha3_update(&ctx, len_le, sizeof(len_le));
+  sha3_update(&ctx, ct, len);
+  sha3_final(tag, &ctx);
+}
+
+static void
+seal_stream(
+    const struct seal_key* key, const uint8_t* nonce, const void* in,
+    size_t len, void* out) {
+  sha3_ctx_t ctx;
+
+  shake256_init(&ctx);
+  shake_update(&ctx, key->enc, sizeof(key->enc));
+  shake_update(&ctx, nonce, SEAL_NONCE_SIZE);
+  shake_xof(&ctx);
+  shake_xor(&ctx, out, in, len);
+  memset(&ctx, 0, sizeof(ctx));
+}
+
+void
+seal(
+    const struct seal_key* key, const uint8_t* nonce, const void* in,
+    size_t len, void* out) {
+  uint8_t* sealed = (uint8_t*)out;
+  uint8_t* ct     = sealed + SEAL_NONCE_SIZE;
+
+  memcpy(sealed, nonce, SEAL_NONCE_SIZE);
+  seal_stream(key, nonce, in, len, ct);
+  seal_tag(key, nonce, ct, len, ct + len);
+}
+
+int
+unseal(
+    const struct seal_key* key, const void* in, size_t sealed_len,
+    void* out) {
+  const uint8_t* sealed = (const uint8_t*)in;
+  const uint8_t* ct     = sealed + SEAL_NONCE_SIZE;
+  uint8_t tag[SEAL_TAG_SIZE];
+  uint8_t diff = 0;
+  size_t len;
+  int i;
+
+  if (sealed_len < SEAL_OVERHEAD) return -1;
+  len = sealed_len - SEAL_OVERHEAD;
+
+  /* check the tag before decrypting anything */
+  seal_tag(key, sealed, ct, len, tag);
+  for (i = 0; i < SEAL_TAG_SIZE; i++) diff |= tag[i] ^ ct[len + i];
+  if (diff) return -1;
+
+  seal_stream(key, sealed, ct, len, out);
+  return 0;
+}
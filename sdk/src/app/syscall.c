@@ -14,6 +14,11 @@ ocall(
       call_id, data, data_len, return_buffer, return_len);
 }
 
+int
+ocall_v(unsigned long call_id, struct edge_iovec* iov, size_t count) {
+  return SYSCALL_3(RUNTIME_SYSCALL_OCALL_V, call_id, iov, count);
+}
+
 int
 copy_from_shared(void* dst, uintptr_t offset, size_t data_len) {
   return SYSCALL_3(RUNTIME_SYSCALL_SHAREDCOPY, dst, offset, data_len);
@@ -24,6 +29,11 @@ attest_enclave(void* report, void* data, size_t size, void* log_ptr, size_t log_
   return SYSCALL_5(RUNTIME_SYSCALL_ATTEST_ENCLAVE, report, data, size, log_ptr, log_size);
 }
 
+int
+attest_enclave_mac(void* tag, void* data, size_t size, const void* verifier_key) {
+  return SYSCALL_4(RUNTIME_SYSCALL_ATTEST_MAC, tag, data, size, verifier_key);
+}
+
 /* returns sealing key */
 int
 get_sealing_key(
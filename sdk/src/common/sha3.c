@@ -6,6 +6,87 @@
 
 #include "common/sha3.h"
 
+#if KECCAKF_ROUNDS % 2
+#error "KECCAKF_ROUNDS must be even, rounds are done in pairs"
+#endif
+
+// Keccak-f[1600] round, fully unrolled: the lanes live in named variables
+// and the two lane sets A and E are used alternately, so nothing is
+// indexed at run time. Lanes be, bi, go, ki, mi and sa are kept complemented
+// for the whole permutation ("lane complementing"). This turns the
+// and-not of chi into a plain AND or OR for all but one lane per plane,
+// since there is no and-not instruction on RV64 without Zbb.
+
+#define KECCAK_ROUND(A, E, rc) \
+  do { \
+    Ca    = A##ba ^ A##ga ^ A##ka ^ A##ma ^ A##sa; \
+    Ce    = A##be ^ A##ge ^ A##ke ^ A##me ^ A##se; \
+    Ci    = A##bi ^ A##gi ^ A##ki ^ A##mi ^ A##si; \
+    Co    = A##bo ^ A##go ^ A##ko ^ A##mo ^ A##so; \
+    Cu    = A##bu ^ A##gu ^ A##ku ^ A##mu ^ A##su; \
+    Da    = Cu ^ ROTL64(Ce, 1); \
+    De    = Ca ^ ROTL64(Ci, 1); \
+    Di    = Ce ^ ROTL64(Co, 1); \
+    Do    = Ci ^ ROTL64(Cu, 1); \
+    Du    = Co ^ ROTL64(Ca, 1); \
+    Ba    = A##ba ^ Da; \
+    Be    = ROTL64(A##ge ^ De, 44); \
+    Bi    = ROTL64(A##ki ^ Di, 43); \
+    Bo    = ROTL64(A##mo ^ Do, 21); \
+    Bu    = ROTL64(A##su ^ Du, 14); \
+    N     = ~Bi; \
+    E##ba = Ba ^ (Be | Bi); \
+    E##be = Be ^ (N | Bo); \
+    E##bi = Bi ^ (Bo & Bu); \
+    E##bo = Bo ^ (Bu | Ba); \
+    E##bu = Bu ^ (Ba & Be); \
+    E##ba ^= (rc); \
+    Ba    = ROTL64(A##bo ^ Do, 28); \
+    Be    = ROTL64(A##gu ^ Du, 20); \
+    Bi    = ROTL64(A##ka ^ Da, 3); \
+    Bo    = ROTL64(A##me ^ De, 45); \
+    Bu    = ROTL64(A##si ^ Di, 61); \
+    N     = ~Bu; \
+    E##ga = Ba ^ (Be | Bi); \
+    E##ge = Be ^ (Bi & Bo); \
+    E##gi = Bi ^ (Bo | N); \
+    E##go = Bo ^ (Bu | Ba); \
+    E##gu = Bu ^ (Ba & Be); \
+    Ba    = ROTL64(A##be ^ De, 1); \
+    Be    = ROTL64(A##gi ^ Di, 6); \
+    Bi    = ROTL64(A##ko ^ Do, 25); \
+    Bo    = ROTL64(A##mu ^ Du, 8); \
+    Bu    = ROTL64(A##sa ^ Da, 18); \
+    N     = ~Bo; \
+    E##ka = Ba ^ (Be | Bi); \
+    E##ke = Be ^ (Bi & Bo); \
+    E##ki = Bi ^ (N & Bu); \
+    E##ko = N ^ (Bu | Ba); \
+    E##ku = Bu ^ (Ba & Be); \
+    Ba    = ROTL64(A##bu ^ Du, 27); \
+    Be    = ROTL64(A##ga ^ Da, 36); \
+    Bi    = ROTL64(A##ke ^ De, 10); \
+    Bo    = ROTL64(A##mi ^ Di, 15); \
+    Bu    = ROTL64(A##so ^ Do, 56); \
+    N     = ~Bo; \
+    E##ma = Ba ^ (Be & Bi); \
+    E##me = Be ^ (Bi | Bo); \
+    E##mi = Bi ^ (N | Bu); \
+    E##mo = N ^ (Bu & Ba); \
+    E##mu = Bu ^ (Ba | Be); \
+    Ba    = ROTL64(A##bi ^ Di, 62); \
+    Be    = ROTL64(A##go ^ Do, 55); \
+    Bi    = ROTL64(A##ku ^ Du, 39); \
+    Bo    = ROTL64(A##ma ^ Da, 41); \
+    Bu    = ROTL64(A##se ^ De, 2); \
+    N     = ~Be; \
+    E##sa = Ba ^ (N & Bi); \
+    E##se = N ^ (Bi | Bo); \
+    E##si = Bi ^ (Bo & Bu); \
+    E##so = Bo ^ (Bu | Ba); \
+    E##su = Bu ^ (Ba & Be); \
+  } while (0)
+
 // update the state with given number of rounds
 
 void
@@ -20,16 +101,25 @@ sha3_keccakf(uint64_t st[25]) {
       0x8000000000008003, 0x8000000000008002, 0x8000000000000080,
       0x000000000000800a, 0x800000008000000a, 0x8000000080008081,
       0x8000000000008080, 0x0000000080000001, 0x8000000080008008};
-  const int keccakf_rotc[24] = {1,  3,  6,  10, 15, 21, 28, 36, 45, 55, 2,  14,
-                                27, 41, 56, 8,  25, 43, 62, 18, 39, 61, 20, 44};
-  const int keccakf_piln[24] = {10, 7,  11, 17, 18, 3, 5,  16, 8,  21, 24, 4,
-                                15, 23, 19, 13, 12, 2, 20, 14, 22, 9,  6,  1};
 
   // variables
-  int i, j, r;
-  uint64_t t, bc[5];
+  int r;
+  uint64_t Aba, Abe, Abi, Abo, Abu;
+  uint64_t Aga, Age, Agi, Ago, Agu;
+  uint64_t Aka, Ake, Aki, Ako, Aku;
+  uint64_t Ama, Ame, Ami, Amo, Amu;
+  uint64_t Asa, Ase, Asi, Aso, Asu;
+  uint64_t Eba, Ebe, Ebi, Ebo, Ebu;
+  uint64_t Ega, Ege, Egi, Ego, Egu;
+  uint64_t Eka, Eke, Eki, Eko, Eku;
+  uint64_t Ema, Eme, Emi, Emo, Emu;
+  uint64_t Esa, Ese, Esi, Eso, Esu;
+  uint64_t Ca, Ce, Ci, Co, Cu, Da, De, Di, Do, Du;
+  uint64_t Ba, Be, Bi, Bo, Bu, N;
 
 #if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+  int i;
+  uint64_t t;
   uint8_t* v;
 
   // endianess conversion. this is redundant on little-endian targets
@@ -42,36 +132,66 @@ sha3_keccakf(uint64_t st[25]) {
   }
 #endif
 
-  // actual iteration
-  for (r = 0; r < KECCAKF_ROUNDS; r++) {
-    // Theta
-    for (i = 0; i < 5; i++)
-      bc[i] = st[i] ^ st[i + 5] ^ st[i + 10] ^ st[i + 15] ^ st[i + 20];
-
-    for (i = 0; i < 5; i++) {
-      t = bc[(i + 4) % 5] ^ ROTL64(bc[(i + 1) % 5], 1);
-      for (j = 0; j < 25; j += 5) st[j + i] ^= t;
-    }
+  // load the state, complementing be, bi, go, ki, mi and sa
+  Aba = st[0];
+  Abe = ~st[1];
+  Abi = ~st[2];
+  Abo = st[3];
+  Abu = st[4];
+  Aga = st[5];
+  Age = st[6];
+  Agi = st[7];
+  Ago = ~st[8];
+  Agu = st[9];
+  Aka = st[10];
+  Ake = st[11];
+  Aki = ~st[12];
+  Ako = st[13];
+  Aku = st[14];
+  Ama = st[15];
+  Ame = st[16];
+  Ami = ~st[17];
+  Amo = st[18];
+  Amu = st[19];
+  Asa = ~st[20];
+  Ase = st[21];
+  Asi = st[22];
+  Aso = st[23];
+  Asu = st[24];
 
-    // Rho Pi
-    t = st[1];
-    for (i = 0; i < 24; i++) {
-      j     = keccakf_piln[i];
-      bc[0] = st[j];
-      st[j] = ROTL64(t, keccakf_rotc[i]);
-      t     = bc[0];
-    }
-
-    //  Chi
-    for (j = 0; j < 25; j += 5) {
-      for (i = 0; i < 5; i++) bc[i] = st[j + i];
-      for (i = 0; i < 5; i++) st[j + i] ^= (~bc[(i + 1) % 5]) & bc[(i + 2) % 5];
-    }
-
-    //  Iota
-    st[0] ^= keccakf_rndc[r];
+  // actual iteration, two rounds at a time
+  for (r = 0; r < KECCAKF_ROUNDS; r += 2) {
+    KECCAK_ROUND(A, E, keccakf_rndc[r]);
+    KECCAK_ROUND(E, A, keccakf_rndc[r + 1]);
   }
 
+  // store the state, undoing the complement
+  st[0]  = Aba;
+  st[1]  = ~Abe;
+  st[2]  = ~Abi;
+  st[3]  = Abo;
+  st[4]  = Abu;
+  st[5]  = Aga;
+  st[6]  = Age;
+  st[7]  = Agi;
+  st[8]  = ~Ago;
+  st[9]  = Agu;
+  st[10] = Aka;
+  st[11] = Ake;
+  st[12] = ~Aki;
+  st[13] = Ako;
+  st[14] = Aku;
+  st[15] = Ama;
+  st[16] = Ame;
+  st[17] = ~Ami;
+  st[18] = Amo;
+  st[19] = Amu;
+  st[20] = ~Asa;
+  st[21] = Ase;
+  st[22] = Asi;
+  st[23] = Aso;
+  st[24] = Asu;
+
 #if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
   // endianess conversion. this is redundant on little-endian targets
   for (i = 0; i < 25; i++) {
@@ -109,10 +229,24 @@ int
 sha3_update(sha3_ctx_t* c, const void* data, size_t len) {
   size_t i;
   int j;
+  const uint8_t* in = (const uint8_t*)data;
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  // absorb whole blocks a lane at a time if the input is lane aligned
+  if (c->pt == 0 && (c->rsiz & 7) == 0 && ((uintptr_t)in & 7) == 0) {
+    while (len >= (size_t)c->rsiz) {
+      for (j = 0; j < c->rsiz / 8; j++)
+        c->st.q[j] ^= ((const uint64_t*)in)[j];
+      sha3_keccakf(c->st.q);
+      in += c->rsiz;
+      len -= c->rsiz;
+    }
+  }
+#endif
 
   j = c->pt;
   for (i = 0; i < len; i++) {
-    c->st.b[j++] ^= ((const uint8_t*)data)[i];
+    c->st.b[j++] ^= in[i];
     if (j >= c->rsiz) {
       sha3_keccakf(c->st.q);
       j = 0;
@@ -152,3 +286,63 @@ sha3(const void* in, size_t inlen, void* md, int mdlen) {
 
   return md;
 }
+
+// SHAKE128 and SHAKE256 extensible-output functions
+
+void
+shake_xof(sha3_ctx_t* c) {
+  c->st.b[c->pt] ^= 0x1F;
+  c->st.b[c->rsiz - 1] ^= 0x80;
+  sha3_keccakf(c->st.q);
+  c->pt = 0;
+}
+
+void
+shake_out(sha3_ctx_t* c, void* out, size_t len) {
+  size_t i;
+  int j;
+
+  j = c->pt;
+  for (i = 0; i < len; i++) {
+    if (j >= c->rsiz) {
+      sha3_keccakf(c->st.q);
+      j = 0;
+    }
+    ((uint8_t*)out)[i] = c->st.b[j++];
+  }
+  c->pt = j;
+}
+
+// xor the next len bytes of output into out = in ^ output (stream cipher)
+
+void
+shake_xor(sha3_ctx_t* c, void* out, const void* in, size_t len) {
+  uint8_t* o        = (uint8_t*)out;
+  const uint8_t* i8 = (const uint8_t*)in;
+  int j;
+
+  j = c->pt;
+  while (len > 0) {
+    if (j >= c->rsiz) {
+      sha3_keccakf(c->st.q);
+      j = 0;
+    }
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    // a whole block a lane at a time if both buffers are lane aligned
+    if (j == 0 && len >= (size_t)c->rsiz && (c->rsiz & 7) == 0 &&
+        (((uintptr_t)o | (uintptr_t)i8) & 7) == 0) {
+      int k;
+      for (k = 0; k < c->rsiz / 8; k++)
+        ((uint64_t*)o)[k] = ((const uint64_t*)i8)[k] ^ c->st.q[k];
+      o += c->rsiz;
+      i8 += c->rsiz;
+      len -= c->rsiz;
+      j = c->rsiz;
+      continue;
+    }
+#endif
+    *o++ = *i8++ ^ c->st.b[j++];
+    len--;
+  }
+  c->pt = j;
+}
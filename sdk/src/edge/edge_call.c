@@ -10,6 +10,17 @@
 uintptr_t _shared_start;
 size_t _shared_len;
 
+/* Set once a thread binds its own buffer, see edge_thread.c. The runtime
+   links this library as well and has no TLS, so nothing thread-local may be
+   referenced from this file. */
+uintptr_t (*_edge_call_thread_start)(void);
+size_t (*_edge_call_thread_len)(void);
+
+#define SHARED_START \
+  (_edge_call_thread_start ? _edge_call_thread_start() : _shared_start)
+#define SHARED_LEN \
+  (_edge_call_thread_len ? _edge_call_thread_len() : _shared_len)
+
 void
 edge_call_init_internals(uintptr_t buffer_start, size_t buffer_len) {
   _shared_start = buffer_start;
@@ -22,18 +33,18 @@ edge_call_get_ptr_from_offset(
   // TODO double check these checks
 
   /* Validate that _shared_start+offset is sane */
-  if (offset > UINTPTR_MAX - _shared_start || offset >= _shared_len) {
+  if (offset > UINTPTR_MAX - SHARED_START || offset >= SHARED_LEN) {
     return -1;
   }
 
   /* Validate that _shared_start+offset+data_len in range */
-  if (data_len > UINTPTR_MAX - (_shared_start + offset) ||
-      data_len > _shared_len - offset) {
+  if (data_len > UINTPTR_MAX - (SHARED_START + offset) ||
+      data_len > SHARED_LEN - offset) {
     return -1;
   }
 
   /* ptr looks valid, create it */
-  *ptr = _shared_start + offset;
+  *ptr = SHARED_START + offset;
   return 0;
 }
 
@@ -42,7 +53,7 @@ edge_call_check_ptr_valid(uintptr_t ptr, size_t data_len) {
   // TODO double check these checks
 
   /* Validate that ptr starts in range */
-  if (ptr > _shared_start + _shared_len || ptr < _shared_start) {
+  if (ptr > SHARED_START + SHARED_LEN || ptr < SHARED_START) {
     return 1;
   }
 
@@ -51,7 +62,7 @@ edge_call_check_ptr_valid(uintptr_t ptr, size_t data_len) {
   }
 
   /* Validate that the end is in range */
-  if (ptr + data_len > _shared_start + _shared_len) {
+  if (ptr + data_len > SHARED_START + SHARED_LEN) {
     return 3;
   }
 
@@ -65,7 +76,7 @@ edge_call_get_offset_from_ptr(
   if (valid != 0) return valid;
 
   /* ptr looks valid, create it */
-  *offset = ptr - _shared_start;
+  *offset = ptr - SHARED_START;
   return 0;
 }
 
@@ -103,25 +114,42 @@ edge_call_setup_wrapped_ret(
   struct edge_data data_wrapper;
   data_wrapper.size = size;
   edge_call_get_offset_from_ptr(
-      _shared_start + sizeof(struct edge_call) + sizeof(struct edge_data),
+      SHARED_START + sizeof(struct edge_call) + sizeof(struct edge_data),
       sizeof(struct edge_data), &data_wrapper.offset);
 
   memcpy(
-      (void*)(_shared_start + sizeof(struct edge_call) + sizeof(struct edge_data)),
+      (void*)(SHARED_START + sizeof(struct edge_call) + sizeof(struct edge_data)),
       ptr, size);
 
   memcpy(
-      (void*)(_shared_start + sizeof(struct edge_call)), &data_wrapper,
+      (void*)(SHARED_START + sizeof(struct edge_call)), &data_wrapper,
       sizeof(struct edge_data));
 
   edge_call->return_data.call_ret_size = sizeof(struct edge_data);
   return edge_call_get_offset_from_ptr(
-      _shared_start + sizeof(struct edge_call), sizeof(struct edge_data),
+      SHARED_START + sizeof(struct edge_call), sizeof(struct edge_data),
       &edge_call->return_data.call_ret_offset);
 }
 
+/* Steps through the segments of an ocall_v() argument buffer at args:
+   returns the len-byte segment at *off and moves *off past it, or -1 if the
+   segment runs past args_len */
+int
+edge_call_iov_next(
+    uintptr_t args, size_t args_len, size_t* off, size_t len, uintptr_t* ptr) {
+  size_t pos = EDGE_IOV_ALIGN_UP(*off);
+
+  if (pos < *off || pos > args_len || len > args_len - pos) {
+    return -1;
+  }
+
+  *ptr = args + pos;
+  *off = pos + len;
+  return 0;
+}
+
 /* This is temporary until we have a better way to handle multiple things */
 uintptr_t
 edge_call_data_ptr() {
-  return _shared_start + sizeof(struct edge_call);
+  return SHARED_START + sizeof(struct edge_call);
 }
@@ -2,18 +2,141 @@
 // Copyright (c) 2018, The Regents of the University of California (Regents).
 // All Rights Reserved. See LICENSE for license details.
 //------------------------------------------------------------------------------
+#include <stdlib.h>
+#include <string.h>
 #include "edge_call.h"
 
 #ifdef IO_SYSCALL_WRAPPING
 #include "edge_syscall.h"
 #endif /*  IO_SYSCALL_WRAPPING */
 
-edgecallwrapper edge_call_table[MAX_EDGE_CALL];
+/* Registered calls, an open-addressing hash table keyed by call id so that
+ * ids need not be small or dense. It grows on registration only; calls are
+ * expected to be registered before the enclave runs, lookups take no lock. */
+struct edge_call_entry {
+  unsigned long call_id;
+  edgecallwrapper func; /* NULL once unregistered */
+  int used;             /* slot holds call_id, keeps probe chains intact */
+};
+
+#define EDGE_CALL_TABLE_MIN 16
+
+static struct edge_call_entry* edge_call_table;
+static size_t edge_call_table_size; /* power of two */
+static size_t edge_call_table_used;
+
+static struct edge_call_entry*
+edge_call_slot(
+    struct edge_call_entry* table, size_t size, unsigned long call_id) {
+  size_t i = (call_id * 0x9E3779B97F4A7C15UL) & (size - 1);
+
+  while (table[i].used && table[i].call_id != call_id) {
+    i = (i + 1) & (size - 1);
+  }
+  return &table[i];
+}
+
+static int
+edge_call_table_grow(void) {
+  size_t size = edge_call_table_size ? edge_call_table_size * 2
+                                     : EDGE_CALL_TABLE_MIN;
+  struct edge_call_entry* table = calloc(size, sizeof(*table));
+  size_t i;
+
+  if (!table) {
+    return -1;
+  }
+
+  /* unregistered calls are dropped on the way */
+  edge_call_table_used = 0;
+  for (i = 0; i < edge_call_table_size; i++) {
+    if (edge_call_table[i].func) {
+      *edge_call_slot(table, size, edge_call_table[i].call_id) =
+          edge_call_table[i];
+      edge_call_table_used++;
+    }
+  }
+
+  free(edge_call_table);
+  edge_call_table      = table;
+  edge_call_table_size = size;
+  return 0;
+}
+
+static edgecallwrapper
+edge_call_lookup(unsigned long call_id) {
+  if (!edge_call_table) {
+    return NULL;
+  }
+  return edge_call_slot(edge_call_table, edge_call_table_size, call_id)->func;
+}
+
+/* Runs the calls of an EDGECALL_BATCH one after the other. Stops at the
+ * first one that fails. Handlers put their results where they would for a
+ * single call, at edge_call_data_ptr(), which is where the batch itself
+ * lies; the batch is copied out first and each record's arguments are
+ * copied back there, so every call gets the data section to itself and
+ * its results are dropped. */
+static void
+incoming_batch_dispatch(struct edge_call* edge_call) {
+  struct edge_batch_record* record;
+  struct edge_call call;
+  uintptr_t args, ptr, data;
+  size_t args_len, off = 0;
+  char* batch;
+
+  if (edge_call_args_ptr(edge_call, &args, &args_len) != 0) {
+    edge_call->return_data.call_status = CALL_STATUS_BAD_OFFSET;
+    return;
+  }
+
+  batch = malloc(args_len);
+  if (!batch) {
+    edge_call->return_data.call_status = CALL_STATUS_ERROR;
+    return;
+  }
+  memcpy(batch, (void*)args, args_len);
+  args = (uintptr_t)batch;
+  data = edge_call_data_ptr();
+
+  while (off < args_len) {
+    if (edge_call_iov_next(args, args_len, &off, sizeof(*record), &ptr)) {
+      goto bad_offset;
+    }
+    record = (struct edge_batch_record*)ptr;
+    if (record->call_id == EDGECALL_BATCH ||
+        edge_call_iov_next(args, args_len, &off, record->size, &ptr) ||
+        edge_call_get_offset_from_ptr(
+            data, record->size, &call.call_arg_offset)) {
+      goto bad_offset;
+    }
+    memcpy((void*)data, (void*)ptr, record->size);
+
+    call.call_id                 = record->call_id;
+    call.call_arg_size           = record->size;
+    call.return_data.call_status = CALL_STATUS_OK;
+    incoming_call_dispatch(&call);
+    if (call.return_data.call_status != CALL_STATUS_OK) {
+      edge_call->return_data.call_status = call.return_data.call_status;
+      free(batch);
+      return;
+    }
+  }
+
+  edge_call->return_data.call_status = CALL_STATUS_OK;
+  free(batch);
+  return;
+
+bad_offset:
+  edge_call->return_data.call_status = CALL_STATUS_BAD_OFFSET;
+  free(batch);
+}
 
 /* Registered handler for incoming edge calls */
 void
 incoming_call_dispatch(void* buffer) {
   struct edge_call* edge_call = (struct edge_call*)buffer;
+  edgecallwrapper func;
 
 #ifdef IO_SYSCALL_WRAPPING
   /* If its a syscall handle it specially */
@@ -23,13 +146,18 @@ incoming_call_dispatch(void* buffer) {
   }
 #endif /*  IO_SYSCALL_WRAPPING */
 
+  if (edge_call->call_id == EDGECALL_BATCH) {
+    incoming_batch_dispatch(edge_call);
+    return;
+  }
+
   /* Otherwise try to lookup the call in the table */
-  if (edge_call->call_id > MAX_EDGE_CALL ||
-      edge_call_table[edge_call->call_id] == NULL) {
+  func = edge_call_lookup(edge_call->call_id);
+  if (!func) {
     /* Fatal error */
     goto fatal_error;
   }
-  edge_call_table[edge_call->call_id](buffer);
+  func(buffer);
   return;
 
 fatal_error:
@@ -39,10 +167,39 @@ fatal_error:
 
 int
 register_call(unsigned long call_id, edgecallwrapper func) {
-  if (call_id > MAX_EDGE_CALL) {
+  struct edge_call_entry* slot;
+
+  /* reserved ids would never be reached, they are dispatched first */
+  if (call_id == EDGECALL_BATCH) {
+    return -1;
+  }
+#ifdef IO_SYSCALL_WRAPPING
+  if (call_id == EDGECALL_SYSCALL) {
     return -1;
   }
+#endif /*  IO_SYSCALL_WRAPPING */
 
-  edge_call_table[call_id] = func;
+  /* unregistering keeps the slot, for call_id to be registered again */
+  if (!func) {
+    if (edge_call_table) {
+      edge_call_slot(edge_call_table, edge_call_table_size, call_id)->func =
+          NULL;
+    }
+    return 0;
+  }
+
+  /* keep the load factor at or below 1/2 */
+  if ((edge_call_table_used + 1) * 2 > edge_call_table_size &&
+      edge_call_table_grow()) {
+    return -1;
+  }
+
+  slot = edge_call_slot(edge_call_table, edge_call_table_size, call_id);
+  if (!slot->used) {
+    edge_call_table_used++;
+  }
+  slot->used    = 1;
+  slot->call_id = call_id;
+  slot->func    = func;
   return 0;
 }
@@ -0,0 +1,39 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#include <edge_call.h>
+
+/* Host only: per-thread shared buffers. Kept apart from edge_call.c so that
+   enclave-side users of the library never pull in thread-local storage. */
+
+extern uintptr_t (*_edge_call_thread_start)(void);
+extern size_t (*_edge_call_thread_len)(void);
+
+static __thread uintptr_t _thread_shared_start;
+static __thread size_t _thread_shared_len;
+
+static uintptr_t
+thread_shared_start(void) {
+  return _thread_shared_start ? _thread_shared_start : _shared_start;
+}
+
+static size_t
+thread_shared_len(void) {
+  return _thread_shared_start ? _thread_shared_len : _shared_len;
+}
+
+/* The hooks are shared by every thread, install them once before any
+   thread can bind a buffer; this file is only linked in by programs that
+   call edge_call_init_thread_internals(). */
+__attribute__((constructor)) static void
+edge_call_install_thread_hooks(void) {
+  _edge_call_thread_start = thread_shared_start;
+  _edge_call_thread_len   = thread_shared_len;
+}
+
+void
+edge_call_init_thread_internals(uintptr_t buffer_start, size_t buffer_len) {
+  _thread_shared_start = buffer_start;
+  _thread_shared_len   = buffer_len;
+}
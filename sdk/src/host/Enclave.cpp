@@ -6,6 +6,11 @@
 #include <math.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
 extern "C" {
 #include "common/sha3.h"
 #include "shared/keystone_user.h"
@@ -18,6 +23,14 @@ namespace Keystone {
 Enclave::Enclave() {
 }
 
+Enclave::Enclave(KeystoneDevice* device, size_t untrustedSize) {
+  pDevice            = device;
+  pMemory            = NULL;
+  shared_buffer      = NULL;
+  shared_buffer_size = 0;
+  mapUntrusted(untrustedSize);
+}
+
 Enclave::~Enclave() {
   destroy();
 }
@@ -117,8 +130,88 @@ static void measureElfFile(hash_ctx_t* hash_ctx, ElfFile* file) {
   }
 }
 
+/* Appends the file to the image as the SM sees it, zero-padded to a page */
+static void appendElfFile(std::vector<char>& image, ElfFile* file) {
+  const char* fptr = (const char*) file->getPtr();
+  size_t fsize     = file->getFileSize();
+
+  image.insert(image.end(), fptr, fptr + fsize);
+  image.resize(image.size() + PAGE_UP(fsize) - fsize, 0);
+}
+
+static bool isZeroPage(const char* page) {
+  static const char zeroPage[PAGE_SIZE] = {0};
+  return memcmp(page, zeroPage, PAGE_SIZE) == 0;
+}
+
+/* Extends hash_ctx with the pages in [start, end), skipping zero pages
+ * behind a page map with SM_MEASURE_SPARSE.
+ * Must stay in sync with hash_extend_pages() in the SM. */
+static void measurePages(
+    hash_ctx_t* hash_ctx, const char* start, const char* end,
+    uintptr_t measureFlags) {
+  const size_t groupSize = 64 * PAGE_SIZE;
+
+  if (!(measureFlags & SM_MEASURE_SPARSE)) {
+    for (const char* page = start; page < end; page += PAGE_SIZE)
+      hash_extend_page(hash_ctx, page);
+    return;
+  }
+
+  for (const char* group = start; group < end; group += groupSize) {
+    const char* groupEnd = std::min(end, group + groupSize);
+    uint64_t map         = 0;
+    int i;
+
+    i = 0;
+    for (const char* page = group; page < groupEnd; page += PAGE_SIZE, i++)
+      if (!isZeroPage(page)) map |= 1ULL << i;
+    hash_extend(hash_ctx, &map, sizeof(map));
+
+    i = 0;
+    for (const char* page = group; page < groupEnd; page += PAGE_SIZE, i++)
+      if (map & (1ULL << i)) hash_extend_page(hash_ctx, page);
+  }
+}
+
+/* SM_MEASURE_TREE: hashes every chunk of the image on its own, spread over
+ * the host threads, then extends hash_ctx with the list of chunk hashes.
+ * Must stay in sync with hash_extend_tree() in the SM. */
+static void measureTree(
+    hash_ctx_t* hash_ctx, const std::vector<char>& image,
+    uintptr_t measureFlags) {
+  const size_t chunkSize = SM_MEASURE_TREE_CHUNK_PAGES * PAGE_SIZE;
+  size_t nleaves         = (image.size() + chunkSize - 1) / chunkSize;
+  std::vector<char> leaves(nleaves * MDSIZE);
+  std::atomic<size_t> next(0);
+
+  auto worker = [&]() {
+    size_t i;
+    while ((i = next++) < nleaves) {
+      hash_ctx_t ctx;
+      size_t end = std::min(image.size(), (i + 1) * chunkSize);
+
+      hash_init(&ctx);
+      measurePages(
+          &ctx, &image[i * chunkSize], image.data() + end, measureFlags);
+      hash_finalize(&leaves[i * MDSIZE], &ctx);
+    }
+  };
+
+  size_t nthreads = std::min<size_t>(
+      std::max(1u, std::thread::hardware_concurrency()), nleaves);
+  std::vector<std::thread> threads;
+  for (size_t t = 1; t < nthreads; t++) threads.emplace_back(worker);
+  worker();
+  for (auto& t : threads) t.join();
+
+  hash_extend(hash_ctx, leaves.data(), leaves.size());
+}
+
 Error
-Enclave::measure(char* hash, const char* eapppath, const char* runtimepath, const char* loaderpath) {
+Enclave::measure(
+    char* hash, const char* eapppath, const char* runtimepath,
+    const char* loaderpath, uintptr_t measureFlags) {
   hash_ctx_t hash_ctx;
   hash_init(&hash_ctx);
 
@@ -126,16 +219,39 @@ Enclave::measure(char* hash, const char* eapppath, const char* runtimepath, cons
   ElfFile* runtime = new ElfFile(runtimepath);
   ElfFile* eapp = new ElfFile(eapppath);
 
+  if (measureFlags) {
+    uint64_t header[2] = {SM_MEASURE_FORMAT_TAG | measureFlags,
+                          SM_MEASURE_TREE_CHUNK_PAGES};
+    hash_extend(&hash_ctx, header, sizeof(header));
+  }
+
   uintptr_t sizes[3] = { PAGE_UP(loader->getFileSize()), PAGE_UP(runtime->getFileSize()),
                           PAGE_UP(eapp->getFileSize()) };
   hash_extend(&hash_ctx, (void*) sizes, sizeof(sizes));
 
-  measureElfFile(&hash_ctx, loader);
-  delete loader;
-  measureElfFile(&hash_ctx, runtime);
-  delete runtime;
-  measureElfFile(&hash_ctx, eapp);
-  delete eapp;
+  if (measureFlags) {
+    std::vector<char> image;
+    image.reserve(sizes[0] + sizes[1] + sizes[2]);
+    appendElfFile(image, loader);
+    appendElfFile(image, runtime);
+    appendElfFile(image, eapp);
+    delete loader;
+    delete runtime;
+    delete eapp;
+
+    if (measureFlags & SM_MEASURE_TREE)
+      measureTree(&hash_ctx, image, measureFlags);
+    else
+      measurePages(
+          &hash_ctx, image.data(), image.data() + image.size(), measureFlags);
+  } else {
+    measureElfFile(&hash_ctx, loader);
+    delete loader;
+    measureElfFile(&hash_ctx, runtime);
+    delete runtime;
+    measureElfFile(&hash_ctx, eapp);
+    delete eapp;
+  }
 
   hash_finalize(hash, &hash_ctx);
 
@@ -196,7 +312,8 @@ Enclave::init(
 
   if (pDevice->finalize(
           pMemory->getRuntimePhysAddr(), pMemory->getEappPhysAddr(),
-          pMemory->getFreePhysAddr(), params.getFreeMemSize()) != Error::Success) {
+          pMemory->getFreePhysAddr(), params.getFreeMemSize(),
+          params.getMeasureFlags()) != Error::Success) {
     destroy();
     return Error::DeviceError;
   }
@@ -215,6 +332,42 @@ Enclave::init(
   return Error::Success;
 }
 
+/* Creates this enclave as a copy of a source enclave which has been
+ * initialized but never run. The SM copies the enclave memory and the
+ * measurement, so no ELF file is loaded or hashed again. */
+Error
+Enclave::clone(Enclave& source) {
+  uint64_t epmPages;
+  params = source.params;
+  /* the clone's memory is a copy, so the ELFs are at the same addresses */
+  runtimeElfAddr = source.runtimeElfAddr;
+  enclaveElfAddr = source.enclaveElfAddr;
+
+  pMemory = new PhysicalEnclaveMemory();
+  pDevice = new KeystoneDevice();
+
+  if (!pDevice->initDevice(params)) {
+    destroy();
+    return Error::DeviceInitFailure;
+  }
+
+  if (pDevice->clone(source.getEid(), &epmPages) != Error::Success) {
+    destroy();
+    return Error::DeviceError;
+  }
+  pMemory->init(pDevice, pDevice->getPhysAddr(), epmPages);
+
+  if (!mapUntrusted(params.getUntrustedSize())) {
+    ERROR(
+        "failed to clone enclave - cannot obtain the untrusted buffer "
+        "pointer \n");
+    destroy();
+    return Error::DeviceMemoryMapError;
+  }
+
+  return Error::Success;
+}
+
 bool
 Enclave::mapUntrusted(size_t size) {
   if (size == 0) {
@@ -242,7 +395,30 @@ Enclave::run(uintptr_t* retval) {
   Error ret = pDevice->run(retval);
   while (ret == Error::EdgeCallHost || ret == Error::EnclaveInterrupted) {
     /* enclave is stopped in the middle. */
-    if (ret == Error::EdgeCallHost && oFuncDispatch != NULL) {
+    if (ret == Error::EdgeCallHost && oFuncDispatchAsync) {
+      std::exception_ptr error;
+      try {
+        /* shared, done may still be called after the handler threw */
+        auto completion        = std::make_shared<std::promise<void>>();
+        std::future<void> done = completion->get_future();
+        oFuncDispatchAsync(
+            getSharedBuffer(), [completion](std::exception_ptr e) {
+              if (e) {
+                completion->set_exception(e);
+              } else {
+                completion->set_value();
+              }
+            });
+        done.get();
+      } catch (...) {
+        error = std::current_exception();
+      }
+      if (error) {
+        ERROR("ocall failed");
+        destroy();
+        std::rethrow_exception(error);
+      }
+    } else if (ret == Error::EdgeCallHost && oFuncDispatch != NULL) {
       oFuncDispatch(getSharedBuffer());
     }
     ret = pDevice->resume(retval);
@@ -257,6 +433,16 @@ Enclave::run(uintptr_t* retval) {
   return Error::Success;
 }
 
+std::future<Error>
+Enclave::runAsync(uintptr_t* retval, Executor& executor) {
+  /* no pollable device (simulated enclaves), fall back to a thread */
+  if (pDevice->getFd() < 0) {
+    return std::async(
+        std::launch::async, [this, retval]() { return run(retval); });
+  }
+  return executor.submit(this, retval);
+}
+
 void*
 Enclave::getSharedBuffer() {
   return shared_buffer;
@@ -278,6 +464,12 @@ Enclave::registerOcallDispatch(OcallFunc func) {
   return Error::Success;
 }
 
+Error
+Enclave::registerAsyncOcallDispatch(AsyncOcallFunc func) {
+  oFuncDispatchAsync = func;
+  return Error::Success;
+}
+
 Error
 Enclave::connect(int otherEid) {
   return pDevice->connectEnclaves(otherEid);
@@ -0,0 +1,157 @@
+//******************************************************************************
+// Copyright (c) 2020, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#include "EnclaveGroup.hpp"
+#include <pthread.h>
+#include <sched.h>
+#include "Enclave.hpp"
+#include "edge/edge_call.h"
+
+namespace Keystone {
+
+EnclaveGroup::EnclaveGroup() : stopping(false) {}
+
+EnclaveGroup::~EnclaveGroup() {
+  stop();
+  for (auto& member : members) {
+    member->thread.join();
+  }
+}
+
+void
+EnclaveGroup::runMember(Member* member) {
+  if (member->cpu >= 0) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(member->cpu, &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set)) {
+      ERROR("failed to pin enclave to cpu %d", member->cpu);
+    }
+  }
+
+  {
+    std::unique_lock<std::mutex> guard(lock);
+    cond.wait(guard, [&] { return member->started || stopping; });
+    if (!member->started) {
+      member->result   = Error::EnclaveCancelled;
+      member->finished = true;
+      cond.notify_all();
+      return;
+    }
+  }
+
+  /* ocalls of the member are served on this thread */
+  Enclave* enclave = member->enclave;
+  edge_call_init_thread_internals(
+      (uintptr_t)enclave->getSharedBuffer(), enclave->getSharedBufferSize());
+
+  Error result = enclave->run(&member->ret);
+
+  std::lock_guard<std::mutex> guard(lock);
+  member->result   = result;
+  member->finished = true;
+  cond.notify_all();
+}
+
+int
+EnclaveGroup::add(Enclave* enclave, int cpu) {
+  std::unique_ptr<Member> member(new Member());
+  member->enclave  = enclave;
+  member->cpu      = cpu;
+  member->started  = false;
+  member->finished = false;
+  member->result   = Error::Success;
+  member->ret      = 0;
+  member->thread   = std::thread(&EnclaveGroup::runMember, this, member.get());
+
+  std::lock_guard<std::mutex> guard(lock);
+  members.push_back(std::move(member));
+  return members.size() - 1;
+}
+
+Error
+EnclaveGroup::connect(int from, int to) {
+  Enclave* other = get(to);
+  Enclave* enclave = get(from);
+  if (!enclave || !other) {
+    return Error::InvalidEnclave;
+  }
+  return enclave->connect(other->getEid());
+}
+
+Error
+EnclaveGroup::start(int index) {
+  std::lock_guard<std::mutex> guard(lock);
+  if (index < 0 || index >= (int)members.size()) {
+    return Error::InvalidEnclave;
+  }
+  if (stopping) {
+    return Error::EnclaveCancelled;
+  }
+  members[index]->started = true;
+  cond.notify_all();
+  return Error::Success;
+}
+
+void
+EnclaveGroup::startAll() {
+  std::lock_guard<std::mutex> guard(lock);
+  if (stopping) {
+    return;
+  }
+  for (auto& member : members) {
+    member->started = true;
+  }
+  cond.notify_all();
+}
+
+void
+EnclaveGroup::stop() {
+  std::lock_guard<std::mutex> guard(lock);
+  stopping = true;
+  cond.notify_all();
+}
+
+Error
+EnclaveGroup::wait(int index, uintptr_t* ret) {
+  std::unique_lock<std::mutex> guard(lock);
+  if (index < 0 || index >= (int)members.size()) {
+    return Error::InvalidEnclave;
+  }
+  Member* member = members[index].get();
+  cond.wait(guard, [&] { return member->finished; });
+  if (ret) {
+    *ret = member->ret;
+  }
+  return member->result;
+}
+
+Error
+EnclaveGroup::waitAll() {
+  Error first = Error::Success;
+  for (int i = 0; i < size(); i++) {
+    Error result = wait(i);
+    if (first == Error::Success) {
+      first = result;
+    }
+  }
+  return first;
+}
+
+Enclave*
+EnclaveGroup::get(int index) {
+  std::lock_guard<std::mutex> guard(lock);
+  if (index < 0 || index >= (int)members.size()) {
+    return nullptr;
+  }
+  return members[index]->enclave;
+}
+
+int
+EnclaveGroup::size() {
+  std::lock_guard<std::mutex> guard(lock);
+  return members.size();
+}
+
+}  // namespace Keystone
@@ -0,0 +1,249 @@
+//******************************************************************************
+// Copyright (c) 2020, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#include "Executor.hpp"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include "Enclave.hpp"
+#include "edge/edge_call.h"
+
+namespace Keystone {
+
+Executor::Executor() : stopping(false), pending(0) {
+  epollFd = epoll_create1(EPOLL_CLOEXEC);
+  wakeFd  = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  assert(epollFd >= 0 && wakeFd >= 0);
+
+  struct epoll_event ev;
+  ev.events   = EPOLLIN;
+  ev.data.ptr = nullptr;
+  epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev);
+
+  thread = std::thread(&Executor::loop, this);
+}
+
+Executor::~Executor() {
+  stopping = true;
+  wake();
+  thread.join();
+  close(wakeFd);
+  close(epollFd);
+}
+
+Executor&
+Executor::getDefault() {
+  static Executor executor;
+  return executor;
+}
+
+std::future<Error>
+Executor::submit(Enclave* enclave, uintptr_t* ret) {
+  std::unique_ptr<Task> task(new Task());
+  task->enclave          = enclave;
+  task->ret              = ret;
+  std::future<Error> fut = task->done.get_future();
+
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    incoming.push_back(std::move(task));
+  }
+
+  wake();
+  return fut;
+}
+
+void
+Executor::wake() {
+  uint64_t one = 1;
+  if (write(wakeFd, &one, sizeof(one)) < 0) {
+    PERROR("failed to wake executor");
+  }
+}
+
+void
+Executor::start(Task* task) {
+  struct epoll_event ev;
+  ev.events   = EPOLLIN;
+  ev.data.ptr = task;
+
+  if (epoll_ctl(epollFd, EPOLL_CTL_ADD, task->enclave->pDevice->getFd(), &ev)) {
+    PERROR("failed to watch enclave");
+    finish(task, Error::DeviceError);
+    return;
+  }
+
+  if (task->enclave->pDevice->runAsync() != Error::Success) {
+    finish(task, Error::DeviceError);
+  }
+}
+
+bool
+Executor::resume(Task* task) {
+  if (task->enclave->pDevice->resumeAsync() != Error::Success) {
+    finish(task, Error::DeviceError);
+    return false;
+  }
+  return true;
+}
+
+/* the enclave fd is readable: the enclave stopped */
+void
+Executor::step(Task* task) {
+  Enclave* enclave = task->enclave;
+  Error ret        = enclave->pDevice->asyncResult(task->ret);
+
+  switch (ret) {
+    case Error::Success:
+      finish(task, Error::Success);
+      return;
+    case Error::EnclaveInterrupted:
+      resume(task);
+      return;
+    case Error::EdgeCallHost:
+      dispatch(task);
+      return;
+    default:
+      ERROR("failed to run enclave - ioctl() failed");
+      finish(task, Error::DeviceError);
+      return;
+  }
+}
+
+void
+Executor::dispatch(Task* task) {
+  Enclave* enclave = task->enclave;
+
+  /* this thread serves many enclaves, the edge library must look at the
+   * shared buffer of this one */
+  edge_call_init_thread_internals(
+      (uintptr_t)enclave->getSharedBuffer(), enclave->getSharedBufferSize());
+
+  if (enclave->oFuncDispatchAsync) {
+    /* the first report wins, a handler that throws after calling done
+     * cannot complete the call twice */
+    auto reported = std::make_shared<std::atomic<bool>>(false);
+    OcallCompletion complete = [this, task,
+                                reported](std::exception_ptr error) {
+      if (reported->exchange(true)) {
+        return;
+      }
+      std::lock_guard<std::mutex> guard(lock);
+      completed.push_back({task, error});
+      pending--;
+      idle.notify_all();
+      wake();
+    };
+
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      pending++;
+    }
+    try {
+      enclave->oFuncDispatchAsync(enclave->getSharedBuffer(), complete);
+    } catch (...) {
+      complete(std::current_exception());
+    }
+    return;
+  }
+
+  if (enclave->oFuncDispatch) {
+    try {
+      enclave->oFuncDispatch(enclave->getSharedBuffer());
+    } catch (...) {
+      fail(task, std::current_exception());
+      return;
+    }
+  }
+  resume(task);
+}
+
+void
+Executor::finish(Task* task, Error error) {
+  epoll_ctl(epollFd, EPOLL_CTL_DEL, task->enclave->pDevice->getFd(), nullptr);
+  if (error != Error::Success && !stopping) {
+    /* same as Enclave::run() */
+    task->enclave->destroy();
+  }
+  task->done.set_value(error);
+  task->enclave = nullptr;
+}
+
+/* an ocall failed, the enclave cannot be resumed */
+void
+Executor::fail(Task* task, std::exception_ptr error) {
+  epoll_ctl(epollFd, EPOLL_CTL_DEL, task->enclave->pDevice->getFd(), nullptr);
+  if (!stopping) {
+    task->enclave->destroy();
+  }
+  task->done.set_exception(error);
+  task->enclave = nullptr;
+}
+
+void
+Executor::loop() {
+  struct epoll_event events[64];
+
+  while (!stopping) {
+    tasks.remove_if(
+        [](const std::unique_ptr<Task>& task) { return !task->enclave; });
+
+    int n = epoll_wait(epollFd, events, sizeof(events) / sizeof(events[0]), -1);
+
+    for (int i = 0; i < n; i++) {
+      Task* task = static_cast<Task*>(events[i].data.ptr);
+      if (task) {
+        step(task);
+        continue;
+      }
+
+      uint64_t count;
+      if (read(wakeFd, &count, sizeof(count)) < 0) {
+        continue;
+      }
+
+      std::vector<std::unique_ptr<Task>> fresh;
+      std::vector<Completion> done;
+      {
+        std::lock_guard<std::mutex> guard(lock);
+        fresh.swap(incoming);
+        done.swap(completed);
+      }
+
+      /* asynchronous ocalls that completed */
+      for (Completion& c : done) {
+        if (c.error) {
+          fail(c.task, c.error);
+        } else {
+          resume(c.task);
+        }
+      }
+
+      for (auto& t : fresh) {
+        start(t.get());
+        tasks.push_back(std::move(t));
+      }
+    }
+  }
+
+  /* completions of pending ocalls still refer to their tasks */
+  {
+    std::unique_lock<std::mutex> guard(lock);
+    idle.wait(guard, [this] { return pending == 0; });
+  }
+
+  /* the executor is going away, nothing will resume these; they are left
+   * to their owners to destroy */
+  for (auto& task : tasks) {
+    if (task->enclave) {
+      finish(task.get(), Error::DeviceError);
+    }
+  }
+  std::lock_guard<std::mutex> guard(lock);
+  for (auto& task : incoming) {
+    task->done.set_value(Error::DeviceError);
+  }
+}
+
+}  // namespace Keystone
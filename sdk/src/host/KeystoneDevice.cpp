@@ -26,6 +26,24 @@ KeystoneDevice::create(uint64_t minPages) {
   return Error::Success;
 }
 
+Error
+KeystoneDevice::clone(int srcEid, uint64_t* epmPages) {
+  struct keystone_ioctl_clone_enclave encl;
+  encl.src_eid = srcEid;
+
+  if (ioctl(fd, KEYSTONE_IOC_CLONE_ENCLAVE, &encl)) {
+    perror("ioctl error");
+    eid = -1;
+    return Error::IoctlErrorClone;
+  }
+
+  eid       = encl.eid;
+  physAddr  = encl.epm_paddr;
+  *epmPages = encl.epm_size / PAGE_SIZE;
+
+  return Error::Success;
+}
+
 uintptr_t
 KeystoneDevice::initUTM(size_t size) {
   struct keystone_ioctl_create_enclave encl;
@@ -72,13 +90,14 @@ KeystoneDevice::connectEnclaves(int eid) {
 Error
 KeystoneDevice::finalize(
     uintptr_t runtimePhysAddr, uintptr_t eappPhysAddr, uintptr_t freePhysAddr,
-    uintptr_t freeRequested) {
+    uintptr_t freeRequested, uintptr_t measureFlags) {
   struct keystone_ioctl_create_enclave encl;
   encl.eid            = eid;
   encl.runtime_paddr  = runtimePhysAddr;
   encl.user_paddr     = eappPhysAddr;
   encl.free_paddr     = freePhysAddr;
   encl.free_requested = freeRequested;
+  encl.measure_flags  = measureFlags;
 
   if (ioctl(fd, KEYSTONE_IOC_FINALIZE_ENCLAVE, &encl)) {
     perror("ioctl error");
@@ -105,6 +124,28 @@ KeystoneDevice::destroy() {
   return Error::Success;
 }
 
+static Error
+runResult(
+    const struct keystone_ioctl_run_enclave& encl, Error error,
+    uintptr_t* ret) {
+  switch (encl.error) {
+    case SBI_ERR_SM_ENCLAVE_EDGE_CALL_HOST:
+      return Error::EdgeCallHost;
+    case SBI_ERR_SM_ENCLAVE_INTERRUPTED:
+      return Error::EnclaveInterrupted;
+    case SBI_ERR_SM_ENCLAVE_SUCCESS:
+      if (ret) {
+        *ret = encl.value;
+      }
+      return Error::Success;
+    default:
+      ERROR(
+          "Unknown SBI error (%lu) returned by the enclave\n",
+          (unsigned long)encl.error);
+      return error;
+  }
+}
+
 Error
 KeystoneDevice::__run(bool resume, uintptr_t* ret) {
   struct keystone_ioctl_run_enclave encl;
@@ -125,22 +166,42 @@ KeystoneDevice::__run(bool resume, uintptr_t* ret) {
     return error;
   }
 
-  switch (encl.error) {
-    case SBI_ERR_SM_ENCLAVE_EDGE_CALL_HOST:
-      return Error::EdgeCallHost;
-    case SBI_ERR_SM_ENCLAVE_INTERRUPTED:
-      return Error::EnclaveInterrupted;
-    case SBI_ERR_SM_ENCLAVE_SUCCESS:
-      if (ret) {
-        *ret = encl.value;
-      }
-      return Error::Success;
-    default:
-      ERROR(
-          "Unknown SBI error (%d) returned by %s_enclave\n", encl.error,
-          resume ? "resume" : "run");
-      return error;
+  return runResult(encl, error, ret);
+}
+
+Error
+KeystoneDevice::__runAsync(bool resume) {
+  struct keystone_ioctl_run_enclave encl;
+  encl.eid = eid;
+
+  uint64_t request = resume ? KEYSTONE_IOC_RESUME_ENCLAVE_ASYNC
+                            : KEYSTONE_IOC_RUN_ENCLAVE_ASYNC;
+
+  if (ioctl(fd, request, &encl)) {
+    return resume ? Error::IoctlErrorResume : Error::IoctlErrorRun;
   }
+  return Error::Success;
+}
+
+Error
+KeystoneDevice::runAsync() {
+  return __runAsync(false);
+}
+
+Error
+KeystoneDevice::resumeAsync() {
+  return __runAsync(true);
+}
+
+Error
+KeystoneDevice::asyncResult(uintptr_t* ret) {
+  struct keystone_ioctl_run_enclave encl;
+
+  if (read(fd, &encl, sizeof(encl)) != sizeof(encl)) {
+    return Error::IoctlErrorRun;
+  }
+
+  return runResult(encl, Error::IoctlErrorRun, ret);
 }
 
 Error
@@ -153,6 +214,58 @@ KeystoneDevice::resume(uintptr_t* ret) {
   return __run(true, ret);
 }
 
+Error
+KeystoneDevice::getStats(struct sm_stats* stats) {
+  struct keystone_ioctl_stats encl;
+  encl.eid  = eid;
+  encl.type = SM_STATS_ENCLAVE;
+
+  if (eid < 0) {
+    return Error::InvalidEnclave;
+  }
+
+  if (ioctl(fd, KEYSTONE_IOC_GET_STATS, &encl)) {
+    perror("ioctl error");
+    return Error::IoctlErrorStats;
+  }
+
+  *stats = encl.stats;
+  return Error::Success;
+}
+
+Error
+KeystoneDevice::getHartStats(unsigned int hartid, struct sm_stats* stats) {
+  struct keystone_ioctl_stats encl;
+  encl.hartid = hartid;
+  encl.type   = SM_STATS_HART;
+
+  if (ioctl(fd, KEYSTONE_IOC_GET_STATS, &encl)) {
+    perror("ioctl error");
+    return Error::IoctlErrorStats;
+  }
+
+  *stats = encl.stats;
+  return Error::Success;
+}
+
+Error
+KeystoneDevice::drainTrace(
+    unsigned int hartid, struct sm_trace_event* events, size_t max,
+    size_t* count) {
+  struct keystone_ioctl_trace trace;
+  trace.hartid = hartid;
+  trace.events = (uintptr_t)events;
+  trace.count  = max;
+
+  if (ioctl(fd, KEYSTONE_IOC_DRAIN_TRACE, &trace)) {
+    perror("ioctl error");
+    return Error::IoctlErrorTrace;
+  }
+
+  *count = trace.count;
+  return Error::Success;
+}
+
 void*
 KeystoneDevice::map(uintptr_t addr, size_t size) {
   assert(fd >= 0);
@@ -196,6 +309,13 @@ MockKeystoneDevice::create(uint64_t minPages) {
   return Error::Success;
 }
 
+Error
+MockKeystoneDevice::clone(int srcEid, uint64_t* epmPages) {
+  eid       = -1;
+  *epmPages = 0;
+  return Error::Success;
+}
+
 uintptr_t
 MockKeystoneDevice::initUTM(size_t size) {
   return 0;
@@ -214,7 +334,7 @@ MockKeystoneDevice::connectEnclaves(int eid) {
 Error
 MockKeystoneDevice::finalize(
     uintptr_t runtimePhysAddr, uintptr_t eappPhysAddr, uintptr_t freePhysAddr,
-    uintptr_t freeRequested) {
+    uintptr_t freeRequested, uintptr_t measureFlags) {
   return Error::Success;
 }
 
@@ -233,6 +353,41 @@ MockKeystoneDevice::resume(uintptr_t* ret) {
   return Error::Success;
 }
 
+Error
+MockKeystoneDevice::runAsync() {
+  return Error::Success;
+}
+
+Error
+MockKeystoneDevice::resumeAsync() {
+  return Error::Success;
+}
+
+Error
+MockKeystoneDevice::asyncResult(uintptr_t* ret) {
+  return Error::Success;
+}
+
+Error
+MockKeystoneDevice::getStats(struct sm_stats* stats) {
+  memset(stats, 0, sizeof(struct sm_stats));
+  return Error::Success;
+}
+
+Error
+MockKeystoneDevice::getHartStats(unsigned int hartid, struct sm_stats* stats) {
+  memset(stats, 0, sizeof(struct sm_stats));
+  return Error::Success;
+}
+
+Error
+MockKeystoneDevice::drainTrace(
+    unsigned int hartid, struct sm_trace_event* events, size_t max,
+    size_t* count) {
+  *count = 0;
+  return Error::Success;
+}
+
 bool
 MockKeystoneDevice::initDevice(Params params) {
   return true;
@@ -3,11 +3,15 @@
 // All Rights Reserved. See LICENSE for license details.
 //------------------------------------------------------------------------------
 #include <Report.hpp>
+#include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <iomanip>
 #include <iostream>
+#include <map>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 #include "ed25519/ed25519.h"
 
@@ -59,19 +63,23 @@ Report::fromJson(std::string jsonstr) {
   report.enclave.log_len   = json["enclave"]["loglen"].int_value();
   std::string enclave_data = json["enclave"]["data"].string_value();
   HexToBytes(report.enclave.data, report.enclave.data_len, enclave_data);
-  
-  // Parse log entries (array of enc_info)
+  std::string log_hash = json["enclave"]["loghash"].string_value();
+  HexToBytes(report.enclave.log_hash, MDSIZE, log_hash);
+
+  // Parse log entries (array of enc_info), kept only if they match the hash
   auto log_entries = json["enclave"]["log"].array_items();
+  std::vector<byte> entries(log_entries.size() * sizeof(struct enc_info));
   size_t offset = 0;
   for (const auto& entry : log_entries) {
-    if (offset + sizeof(struct enc_info) > ATTEST_DATA_MAXLEN) break;
-    struct enc_info* info = reinterpret_cast<struct enc_info*>(report.enclave.log + offset);
+    struct enc_info* info = reinterpret_cast<struct enc_info*>(&entries[offset]);
     info->eid = entry["eid"].int_value();
     std::string path = entry["path"].string_value();
     strncpy(info->path, path.c_str(), sizeof(info->path) - 1);
     info->path[sizeof(info->path) - 1] = '\0';
     offset += sizeof(struct enc_info);
   }
+  log.clear();
+  setLog(entries.data(), entries.size());
   
   std::string enclave_signature = json["enclave"]["signature"].string_value();
   HexToBytes(report.enclave.signature, SIGNATURE_SIZE, enclave_signature);
@@ -80,6 +88,200 @@ Report::fromJson(std::string jsonstr) {
 void
 Report::fromBytes(byte* bin) {
   std::memcpy(&report, bin, sizeof(struct report_t));
+  log.clear();
+}
+
+bool
+Report::setLog(const byte* bin, size_t len) {
+  byte digest[MDSIZE];
+  sha3_ctx_t ctx;
+
+  if (len != report.enclave.log_len) return false;
+
+  sha3_init(&ctx, MDSIZE);
+  sha3_update(&ctx, bin, len);
+  sha3_final(digest, &ctx);
+  if (memcmp(digest, report.enclave.log_hash, MDSIZE)) return false;
+
+  log.assign(bin, bin + len);
+  return true;
+}
+
+/* Offsets into the compact format */
+#define WIRE_VERSION 4
+#define WIRE_FLAGS 6
+#define WIRE_DEV_PUBLIC_KEY 8
+#define WIRE_SM_HASH 40
+#define WIRE_SM_PUBLIC_KEY 104
+#define WIRE_SM_SIGNATURE 136
+#define WIRE_ENCLAVE_HASH 200
+#define WIRE_DATA_LEN 264
+#define WIRE_LOG_LEN 272
+#define WIRE_LOG_HASH 280
+#define WIRE_ENCLAVE_SIGNATURE 344
+
+static uint64_t
+wire_get(const byte* p, size_t size) {
+  uint64_t v = 0;
+  for (size_t i = 0; i < size; i++) v |= (uint64_t)p[i] << (8 * i);
+  return v;
+}
+
+static void
+wire_put(byte* p, uint64_t v, size_t size) {
+  for (size_t i = 0; i < size; i++) p[i] = (byte)(v >> (8 * i));
+}
+
+static const byte zero_data[ATTEST_DATA_MAXLEN] = {0};
+
+bool
+ReportView::parse(const byte* bin, size_t len) {
+  buf = nullptr;
+  if (len < REPORT_WIRE_HEADER_SIZE) return false;
+  if (wire_get(bin, 4) != REPORT_WIRE_MAGIC) return false;
+  if (wire_get(bin + WIRE_VERSION, 2) != REPORT_WIRE_VERSION) return false;
+
+  flags    = wire_get(bin + WIRE_FLAGS, 2);
+  data_len = wire_get(bin + WIRE_DATA_LEN, 8);
+  log_len  = wire_get(bin + WIRE_LOG_LEN, 8);
+  if (flags & ~REPORT_WIRE_FULL_DATA) return false;
+  if (data_len > ATTEST_DATA_MAXLEN) return false;
+
+  size_t data_wire =
+      (flags & REPORT_WIRE_FULL_DATA) ? ATTEST_DATA_MAXLEN : data_len;
+  if (len != REPORT_WIRE_HEADER_SIZE + data_wire) return false;
+
+  data = bin + REPORT_WIRE_HEADER_SIZE;
+  buf  = bin;
+  return true;
+}
+
+bool
+ReportView::checkLog(const byte* log, size_t len) const {
+  byte digest[MDSIZE];
+  sha3_ctx_t ctx;
+
+  if (!buf || len != log_len) return false;
+
+  sha3_init(&ctx, MDSIZE);
+  sha3_update(&ctx, log, len);
+  sha3_final(digest, &ctx);
+  return memcmp(digest, buf + WIRE_LOG_HASH, MDSIZE) == 0;
+}
+
+int
+ReportView::checkSignaturesOnly(const byte* dev_public_key) const {
+  if (!buf) return 0;
+
+  /* SM hash and public key are adjacent, just like in struct sm_report_t */
+  int sm_valid = ed25519_verify(
+      buf + WIRE_SM_SIGNATURE, buf + WIRE_SM_HASH, MDSIZE + PUBLIC_KEY_SIZE,
+      dev_public_key);
+
+  /* The enclave signature covers hash and both lengths (already laid out
+   * as the little-endian SM writes them), all of data[] and the log hash.
+   * The zero tail of data[] is fed from a static buffer. */
+  size_t tail =
+      (flags & REPORT_WIRE_FULL_DATA) ? ATTEST_DATA_MAXLEN : data_len;
+  const byte* parts[] = {
+      buf + WIRE_ENCLAVE_HASH, data, zero_data, buf + WIRE_LOG_HASH};
+  size_t part_lens[] = {
+      MDSIZE + 2 * sizeof(uint64_t), tail, ATTEST_DATA_MAXLEN - tail, MDSIZE};
+  int enclave_valid = ed25519_verify_parts(
+      buf + WIRE_ENCLAVE_SIGNATURE, parts, part_lens, 4,
+      buf + WIRE_SM_PUBLIC_KEY);
+
+  return sm_valid && enclave_valid;
+}
+
+int
+ReportView::verify(
+    const byte* expected_enclave_hash, const byte* expected_sm_hash,
+    const byte* dev_public_key) const {
+  if (!buf) return 0;
+
+  int encl_hash_valid =
+      memcmp(expected_enclave_hash, getEnclaveHash(), MDSIZE) == 0;
+  int sm_hash_valid = memcmp(expected_sm_hash, getSmHash(), MDSIZE) == 0;
+
+  return encl_hash_valid && sm_hash_valid &&
+         checkSignaturesOnly(dev_public_key);
+}
+
+const byte*
+ReportView::getDevicePublicKey() const {
+  return buf + WIRE_DEV_PUBLIC_KEY;
+}
+
+const byte*
+ReportView::getEnclaveHash() const {
+  return buf + WIRE_ENCLAVE_HASH;
+}
+
+const byte*
+ReportView::getSmHash() const {
+  return buf + WIRE_SM_HASH;
+}
+
+bool
+Report::fromCompact(const byte* bin, size_t len) {
+  ReportView view;
+  if (!view.parse(bin, len)) return false;
+
+  std::memset(&report, 0, sizeof(report));
+  log.clear();
+  std::memcpy(
+      report.dev_public_key, bin + WIRE_DEV_PUBLIC_KEY, PUBLIC_KEY_SIZE);
+  std::memcpy(report.sm.hash, bin + WIRE_SM_HASH, MDSIZE);
+  std::memcpy(report.sm.public_key, bin + WIRE_SM_PUBLIC_KEY, PUBLIC_KEY_SIZE);
+  std::memcpy(report.sm.signature, bin + WIRE_SM_SIGNATURE, SIGNATURE_SIZE);
+  std::memcpy(report.enclave.hash, bin + WIRE_ENCLAVE_HASH, MDSIZE);
+  std::memcpy(report.enclave.log_hash, bin + WIRE_LOG_HASH, MDSIZE);
+  std::memcpy(
+      report.enclave.signature, bin + WIRE_ENCLAVE_SIGNATURE, SIGNATURE_SIZE);
+  report.enclave.data_len = view.getDataSize();
+  report.enclave.log_len  = view.getLogSize();
+  std::memcpy(
+      report.enclave.data, view.getDataSection(),
+      len - REPORT_WIRE_HEADER_SIZE);
+  return true;
+}
+
+std::vector<byte>
+Report::toCompact() {
+  std::vector<byte> out;
+  uint64_t data_len = report.enclave.data_len;
+  uint64_t log_len  = report.enclave.log_len;
+
+  if (data_len > ATTEST_DATA_MAXLEN) return out;
+
+  /* An SM that leaves junk past data_len still signed it, so ship it */
+  uint16_t flags   = 0;
+  size_t data_wire = data_len;
+  if (memcmp(
+          report.enclave.data + data_len, zero_data,
+          ATTEST_DATA_MAXLEN - data_len)) {
+    flags     = REPORT_WIRE_FULL_DATA;
+    data_wire = ATTEST_DATA_MAXLEN;
+  }
+
+  out.resize(REPORT_WIRE_HEADER_SIZE + data_wire);
+  byte* p = out.data();
+  wire_put(p, REPORT_WIRE_MAGIC, 4);
+  wire_put(p + WIRE_VERSION, REPORT_WIRE_VERSION, 2);
+  wire_put(p + WIRE_FLAGS, flags, 2);
+  std::memcpy(p + WIRE_DEV_PUBLIC_KEY, report.dev_public_key, PUBLIC_KEY_SIZE);
+  std::memcpy(p + WIRE_SM_HASH, report.sm.hash, MDSIZE);
+  std::memcpy(p + WIRE_SM_PUBLIC_KEY, report.sm.public_key, PUBLIC_KEY_SIZE);
+  std::memcpy(p + WIRE_SM_SIGNATURE, report.sm.signature, SIGNATURE_SIZE);
+  std::memcpy(p + WIRE_ENCLAVE_HASH, report.enclave.hash, MDSIZE);
+  wire_put(p + WIRE_DATA_LEN, data_len, 8);
+  wire_put(p + WIRE_LOG_LEN, log_len, 8);
+  std::memcpy(p + WIRE_LOG_HASH, report.enclave.log_hash, MDSIZE);
+  std::memcpy(
+      p + WIRE_ENCLAVE_SIGNATURE, report.enclave.signature, SIGNATURE_SIZE);
+  std::memcpy(p + REPORT_WIRE_HEADER_SIZE, report.enclave.data, data_wire);
+  return out;
 }
 
 std::string
@@ -87,16 +289,13 @@ Report::stringfy() {
   if (report.enclave.data_len > ATTEST_DATA_MAXLEN) {
     return "{ \"error\" : \"invalid data length\" }";
   }
-  if (report.enclave.log_len > ATTEST_DATA_MAXLEN) {
-    return "{ \"error\" : \"invalid log length\" }";
-  }
-  
-  // Build log entries array
+
+  // Build log entries array from the log, if one was attached
   std::vector<Json> log_entries;
-  size_t num_entries = report.enclave.log_len / sizeof(struct enc_info);
+  size_t num_entries = log.size() / sizeof(struct enc_info);
   for (size_t i = 0; i < num_entries; i++) {
     struct enc_info* info = reinterpret_cast<struct enc_info*>(
-        report.enclave.log + i * sizeof(struct enc_info));
+        &log[i * sizeof(struct enc_info)]);
     log_entries.push_back(Json::object{
         {"eid", static_cast<int>(info->eid)},
         {"path", std::string(info->path)},
@@ -120,6 +319,7 @@ Report::stringfy() {
               {"data",
                BytesToHex(report.enclave.data, report.enclave.data_len)},
               {"loglen", static_cast<int>(report.enclave.log_len)},
+              {"loghash", BytesToHex(report.enclave.log_hash, MDSIZE)},
               {"log", log_entries},
               {"signature",
                BytesToHex(report.enclave.signature, SIGNATURE_SIZE)},
@@ -153,12 +353,14 @@ Report::printPretty() {
             << std::endl;
   
   // Print log entries (connection history)
-  size_t num_entries = report.enclave.log_len / sizeof(struct enc_info);
+  std::cout << "Log Hash: " << BytesToHex(report.enclave.log_hash, MDSIZE)
+            << std::endl;
+  size_t num_entries = log.size() / sizeof(struct enc_info);
   if (num_entries > 0) {
     std::cout << std::endl << "\t\t-- Connection Log (" << num_entries << " entries) --" << std::endl;
     for (size_t i = 0; i < num_entries; i++) {
       struct enc_info* info = reinterpret_cast<struct enc_info*>(
-          report.enclave.log + i * sizeof(struct enc_info));
+          &log[i * sizeof(struct enc_info)]);
       std::cout << "  [" << i << "] EID: " << info->eid << ", Path: " << info->path << std::endl;
     }
   }
@@ -204,12 +406,133 @@ Report::checkSignaturesOnly(const byte* dev_public_key) {
   /* verify Enclave report */
   enclave_valid = ed25519_verify(
       report.enclave.signature, reinterpret_cast<byte*>(&report.enclave),
-      MDSIZE + sizeof(uint64_t) + sizeof(uint64_t) + ATTEST_DATA_MAXLEN + report.enclave.log_len,
+      sizeof(struct enclave_report_t) - SIGNATURE_SIZE,
       report.sm.public_key);
 
   return sm_valid && enclave_valid;
 }
 
+/* Signatures per ed25519_verify_batch() call; large enough to amortize
+ * the shared doublings, small enough to keep every thread busy */
+#define REPORT_BATCH_SIZE 64
+
+std::vector<int>
+Report::verifyBatch(
+    std::vector<Report>& reports, const byte* expected_enclave_hash,
+    const byte* expected_sm_hash, const byte* dev_public_key,
+    unsigned int threads) {
+  std::vector<int> valid =
+      checkSignaturesBatch(reports, dev_public_key, threads);
+
+  for (size_t i = 0; i < reports.size(); i++) {
+    struct report_t& r = reports[i].report;
+    valid[i]           = valid[i] &&
+               memcmp(expected_enclave_hash, r.enclave.hash, MDSIZE) == 0 &&
+               memcmp(expected_sm_hash, r.sm.hash, MDSIZE) == 0;
+  }
+  return valid;
+}
+
+std::vector<int>
+Report::checkSignaturesBatch(
+    std::vector<Report>& reports, const byte* dev_public_key,
+    unsigned int threads) {
+  std::vector<const byte*> sigs, msgs, keys;
+  std::vector<size_t> lens;
+  std::vector<size_t> sm_index(reports.size());
+  std::map<std::string, size_t> sm_seen;
+
+  /* SM reports only change across boots, so most of them are duplicates */
+  for (size_t i = 0; i < reports.size(); i++) {
+    struct sm_report_t& sm = reports[i].report.sm;
+    std::string key(reinterpret_cast<char*>(&sm), sizeof(sm));
+    auto it = sm_seen.find(key);
+    if (it != sm_seen.end()) {
+      sm_index[i] = it->second;
+      continue;
+    }
+    sm_index[i] = sigs.size();
+    sm_seen.emplace(key, sigs.size());
+    sigs.push_back(sm.signature);
+    msgs.push_back(reinterpret_cast<byte*>(&sm));
+    lens.push_back(MDSIZE + PUBLIC_KEY_SIZE);
+    keys.push_back(dev_public_key);
+  }
+
+  size_t enclave_base = sigs.size();
+  for (size_t i = 0; i < reports.size(); i++) {
+    struct report_t& r = reports[i].report;
+    sigs.push_back(r.enclave.signature);
+    msgs.push_back(reinterpret_cast<byte*>(&r.enclave));
+    lens.push_back(sizeof(struct enclave_report_t) - SIGNATURE_SIZE);
+    keys.push_back(r.sm.public_key);
+  }
+
+  size_t total   = sigs.size();
+  size_t batches = (total + REPORT_BATCH_SIZE - 1) / REPORT_BATCH_SIZE;
+  std::vector<int> sig_valid(total, 0);
+  std::atomic<size_t> next(0);
+
+  auto worker = [&]() {
+    size_t b;
+    while ((b = next.fetch_add(1)) < batches) {
+      size_t start = b * REPORT_BATCH_SIZE;
+      size_t n     = std::min<size_t>(REPORT_BATCH_SIZE, total - start);
+      ed25519_verify_batch(
+          &sigs[start], &msgs[start], &lens[start], &keys[start], n,
+          &sig_valid[start]);
+    }
+  };
+
+  if (threads == 0) threads = std::thread::hardware_concurrency();
+  if (threads == 0) threads = 1;
+  if (threads > batches) threads = batches;
+
+  std::vector<std::thread> pool;
+  for (unsigned int t = 1; t < threads; t++) pool.emplace_back(worker);
+  worker();
+  for (auto& t : pool) t.join();
+
+  std::vector<int> valid(reports.size());
+  for (size_t i = 0; i < reports.size(); i++)
+    valid[i] = sig_valid[sm_index[i]] && sig_valid[enclave_base + i];
+  return valid;
+}
+
+/* Derives the key the SM uses for this enclave and verifier, once per
+ * report, so each tag then costs a single SHA3 */
+void
+Report::setMacVerifierKey(const byte* verifier_private_key) {
+  byte shared[PUBLIC_KEY_SIZE];
+  sha3_ctx_t ctx;
+
+  ed25519_key_exchange(shared, report.sm.public_key, verifier_private_key);
+
+  sha3_init(&ctx, MDSIZE);
+  sha3_update(&ctx, ATTEST_MAC_KEY_LABEL, sizeof(ATTEST_MAC_KEY_LABEL) - 1);
+  sha3_update(&ctx, shared, sizeof(shared));
+  sha3_update(&ctx, report.enclave.hash, MDSIZE);
+  sha3_final(mac_key, &ctx);
+  mac_key_valid = true;
+}
+
+int
+Report::verifyMac(const byte* tag, const byte* data, size_t len) {
+  byte expected[ATTEST_MAC_SIZE];
+  sha3_ctx_t ctx;
+  byte diff = 0;
+
+  if (!mac_key_valid) return 0;
+
+  sha3_init(&ctx, MDSIZE);
+  sha3_update(&ctx, mac_key, MDSIZE);
+  sha3_update(&ctx, data, len);
+  sha3_final(expected, &ctx);
+
+  for (size_t i = 0; i < ATTEST_MAC_SIZE; i++) diff |= expected[i] ^ tag[i];
+  return diff == 0;
+}
+
 void*
 Report::getDataSection() {
   return report.enclave.data;
@@ -222,10 +545,15 @@ Report::getDataSize() {
 
 void*
 Report::getLogSection() {
-  return report.enclave.log;
+  return log.empty() ? NULL : log.data();
 }
 
 size_t
 Report::getLogSize() {
-  return report.enclave.log_len;
+  return log.size();
+}
+
+byte*
+Report::getLogHash() {
+  return report.enclave.log_hash;
 }
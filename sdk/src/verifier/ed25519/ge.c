@@ -131,6 +131,80 @@ ge_double_scalarmult_vartime(
   }
 }
 
+/* Odd multiples A,3A,...,15A for the sliding windows */
+static void
+ge_precompute_odd(ge_cached* Ai, const ge_p3* A) {
+  ge_p1p1 t;
+  ge_p3 u;
+  ge_p3 A2;
+  int i;
+
+  ge_p3_to_cached(&Ai[0], A);
+  ge_p3_dbl(&t, A);
+  ge_p1p1_to_p3(&A2, &t);
+
+  for (i = 1; i < 8; ++i) {
+    ge_add(&t, &A2, &Ai[i - 1]);
+    ge_p1p1_to_p3(&u, &t);
+    ge_p3_to_cached(&Ai[i], &u);
+  }
+}
+
+/*
+r = b * B + sum(a_i * A_i) for i < n
+where a_i is the 32-byte scalar at scalars + 32 * i.
+All the terms share one chain of doublings (Straus), so this is much
+cheaper than n double scalar multiplications. The caller provides
+n * 256 bytes of aslide and n * 8 entries of Ai as scratch space.
+*/
+
+void
+ge_multi_scalarmult_vartime(
+    ge_p3* r, const unsigned char* b, const unsigned char* scalars,
+    const ge_p3* points, size_t n, signed char* aslide, ge_cached* Ai) {
+  signed char bslide[256];
+  ge_p1p1 t;
+  ge_p2 acc;
+  size_t j;
+  int i;
+
+  slide(bslide, b);
+  for (j = 0; j < n; ++j) {
+    slide(aslide + 256 * j, scalars + 32 * j);
+    ge_precompute_odd(Ai + 8 * j, &points[j]);
+  }
+
+  ge_p2_0(&acc);
+  ge_p3_0(r);
+
+  for (i = 255; i >= 0; --i) {
+    ge_p2_dbl(&t, &acc);
+    ge_p1p1_to_p3(r, &t);
+
+    for (j = 0; j < n; ++j) {
+      signed char digit = aslide[256 * j + i];
+
+      if (digit > 0) {
+        ge_add(&t, r, &Ai[8 * j + digit / 2]);
+        ge_p1p1_to_p3(r, &t);
+      } else if (digit < 0) {
+        ge_sub(&t, r, &Ai[8 * j + (-digit) / 2]);
+        ge_p1p1_to_p3(r, &t);
+      }
+    }
+
+    if (bslide[i] > 0) {
+      ge_madd(&t, r, &Bi[bslide[i] / 2]);
+      ge_p1p1_to_p3(r, &t);
+    } else if (bslide[i] < 0) {
+      ge_msub(&t, r, &Bi[(-bslide[i]) / 2]);
+      ge_p1p1_to_p3(r, &t);
+    }
+
+    ge_p3_to_p2(&acc, r);
+  }
+}
+
 static const fe d = {-10913610, 13857413, -15372611, 6949391,   114729,
                      -8787816,  -6275908, -3247719,  -18696448, -12055116};
 
@@ -49,11 +49,21 @@ int
 ed25519_verify(
     const unsigned char* signature, const unsigned char* message,
     size_t message_len, const unsigned char* public_key) {
+  return ed25519_verify_parts(
+      signature, &message, &message_len, 1, public_key);
+}
+
+int
+ed25519_verify_parts(
+    const unsigned char* signature, const unsigned char* const* parts,
+    const size_t* part_lens, size_t num_parts,
+    const unsigned char* public_key) {
   unsigned char h[64];
   unsigned char checker[32];
   sha3_ctx_t hash;
   ge_p3 A;
   ge_p2 R;
+  size_t i;
 
   if (signature[63] & 224) {
     return 0;
@@ -66,7 +76,9 @@ ed25519_verify(
   sha3_init(&hash, 64);
   sha3_update(&hash, signature, 32);
   sha3_update(&hash, public_key, 32);
-  sha3_update(&hash, message, message_len);
+  for (i = 0; i < num_parts; ++i) {
+    sha3_update(&hash, parts[i], part_lens[i]);
+  }
   sha3_final(h, &hash);
 
   sc_reduce(h);
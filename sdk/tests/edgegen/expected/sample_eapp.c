@@ -0,0 +1,141 @@
+/* Generated by keystone-edgegen.py, do not edit */
+#include "sample_eapp.h"
+#include "string.h"
+#include "syscall.h"
+
+static void
+edgegen_iov(
+    struct edge_iovec* iov, const void* base, size_t len,
+    unsigned long flags) {
+  iov->base  = (void*)base;
+  iov->len   = len;
+  iov->flags = flags;
+}
+
+#ifndef SAMPLE_BATCH_SIZE
+#define SAMPLE_BATCH_SIZE 4096
+#endif
+
+static char sample_batch[SAMPLE_BATCH_SIZE]
+    __attribute__((aligned(EDGE_IOV_ALIGN)));
+static size_t sample_batch_len;
+
+int
+sample_flush(void) {
+  struct edge_iovec iov;
+
+  if (!sample_batch_len) {
+    return 0;
+  }
+  edgegen_iov(&iov, sample_batch, sample_batch_len, EDGE_IOV_IN);
+  sample_batch_len = 0;
+  return ocall_v(EDGECALL_BATCH, &iov, 1);
+}
+
+/* Queues a call, laid out as ocall_v() would lay it out. Fails if a full
+   queue could not be sent first. */
+static int
+sample_batch_add(unsigned long call_id, struct edge_iovec* iov, size_t count) {
+  struct edge_batch_record* record;
+  size_t size = 0, off, i;
+
+  for (i = 0; i < count; i++) {
+    size = EDGE_IOV_ALIGN_UP(size) + iov[i].len;
+  }
+  if (EDGE_IOV_ALIGN_UP(sizeof(*record)) + size > SAMPLE_BATCH_SIZE) {
+    /* too large to ever queue */
+    return sample_flush() || ocall_v(call_id, iov, count);
+  }
+  if (EDGE_IOV_ALIGN_UP(sample_batch_len) +
+              EDGE_IOV_ALIGN_UP(sizeof(*record)) + size >
+          SAMPLE_BATCH_SIZE &&
+      sample_flush()) {
+    return -1;
+  }
+
+  off    = EDGE_IOV_ALIGN_UP(sample_batch_len);
+  record = (struct edge_batch_record*)(sample_batch + off);
+  record->call_id = call_id;
+  record->size    = size;
+  off += EDGE_IOV_ALIGN_UP(sizeof(*record));
+
+  size = 0;
+  for (i = 0; i < count; i++) {
+    size = EDGE_IOV_ALIGN_UP(size);
+    memcpy(sample_batch + off + size, iov[i].base, iov[i].len);
+    size += iov[i].len;
+  }
+  sample_batch_len = off + size;
+  return 0;
+}
+
+int
+ocall_ping(void) {
+  return sample_flush() || ocall_v(SAMPLE_OCALL_PING, NULL, 0);
+}
+
+int
+ocall_put_string(const char* str, unsigned long* ret) {
+  struct sample_put_string_args args;
+  struct edge_iovec iov[3];
+
+  args.edge_len_str = strlen((char*)str) + 1;
+  edgegen_iov(&iov[0], &args, sizeof(args), EDGE_IOV_IN);
+  edgegen_iov(&iov[1], ret, sizeof(*ret), EDGE_IOV_OUT);
+  edgegen_iov(&iov[2], str, args.edge_len_str, EDGE_IOV_IN);
+
+  return sample_flush() || ocall_v(SAMPLE_OCALL_PUT_STRING, iov, 3);
+}
+
+int
+ocall_get_block(unsigned long index, void* buf, size_t len, int* ret) {
+  struct sample_get_block_args args;
+  struct edge_iovec iov[3];
+
+  args.index = index;
+  args.len = len;
+  args.edge_len_buf = (size_t)(len);
+  edgegen_iov(&iov[0], &args, sizeof(args), EDGE_IOV_IN);
+  edgegen_iov(&iov[1], ret, sizeof(*ret), EDGE_IOV_OUT);
+  edgegen_iov(&iov[2], buf, args.edge_len_buf, EDGE_IOV_OUT);
+
+  return sample_flush() || ocall_v(SAMPLE_OCALL_GET_BLOCK, iov, 3);
+}
+
+int
+ocall_scale(int* values, size_t n, int factor) {
+  struct sample_scale_args args;
+  struct edge_iovec iov[2];
+
+  args.n = n;
+  args.factor = factor;
+  args.edge_len_values = (size_t)(n) * sizeof(int);
+  edgegen_iov(&iov[0], &args, sizeof(args), EDGE_IOV_IN);
+  edgegen_iov(&iov[1], values, args.edge_len_values, EDGE_IOV_IN | EDGE_IOV_OUT);
+
+  return sample_flush() || ocall_v(SAMPLE_OCALL_SCALE, iov, 2);
+}
+
+int
+ocall_log_value(unsigned long value) {
+  struct sample_log_value_args args;
+  struct edge_iovec iov[1];
+
+  args.value = value;
+  edgegen_iov(&iov[0], &args, sizeof(args), EDGE_IOV_IN);
+
+  return sample_batch_add(SAMPLE_OCALL_LOG_VALUE, iov, 1);
+}
+
+int
+ocall_log_bytes(const unsigned char* bytes) {
+  struct sample_log_bytes_args args;
+  struct edge_iovec iov[2];
+
+  args.edge_len_bytes = (size_t)(16);
+  edgegen_iov(&iov[0], &args, sizeof(args), EDGE_IOV_IN);
+  edgegen_iov(&iov[1], bytes, args.edge_len_bytes, EDGE_IOV_IN);
+
+  return sample_batch_add(SAMPLE_OCALL_LOG_BYTES, iov, 2);
+}
+
@@ -0,0 +1,29 @@
+/* Generated by keystone-edgegen.py, do not edit */
+#ifndef __SAMPLE_EAPP_H_
+#define __SAMPLE_EAPP_H_
+
+#include "sample_edge.h"
+
+/* Return 0, or non-zero if the call failed; a call that fails leaves *ret
+   (which must be valid) and out buffers untouched. [batch] calls only fail
+   here if they cannot be queued, what the host makes of them is returned
+   by the call that sends them. */
+int
+ocall_ping(void);
+int
+ocall_put_string(const char* str, unsigned long* ret);
+int
+ocall_get_block(unsigned long index, void* buf, size_t len, int* ret);
+int
+ocall_scale(int* values, size_t n, int factor);
+int
+ocall_log_value(unsigned long value);
+int
+ocall_log_bytes(const unsigned char* bytes);
+
+/* Sends the queued [batch] calls. Other calls flush the queue first, so
+   ordering is kept; call this before the enclave exits or waits. */
+int
+sample_flush(void);
+
+#endif /* __SAMPLE_EAPP_H_ */
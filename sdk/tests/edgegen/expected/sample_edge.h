@@ -0,0 +1,40 @@
+/* Generated by keystone-edgegen.py, do not edit */
+#ifndef __SAMPLE_EDGE_H_
+#define __SAMPLE_EDGE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "edge_common.h"
+
+#define SAMPLE_OCALL_PING 1
+#define SAMPLE_OCALL_PUT_STRING 2
+#define SAMPLE_OCALL_GET_BLOCK 3
+#define SAMPLE_OCALL_SCALE 4
+#define SAMPLE_OCALL_LOG_VALUE 5
+#define SAMPLE_OCALL_LOG_BYTES 6
+
+struct sample_put_string_args {
+  size_t edge_len_str;
+};
+
+struct sample_get_block_args {
+  unsigned long index;
+  size_t len;
+  size_t edge_len_buf;
+};
+
+struct sample_scale_args {
+  size_t n;
+  int factor;
+  size_t edge_len_values;
+};
+
+struct sample_log_value_args {
+  unsigned long value;
+};
+
+struct sample_log_bytes_args {
+  size_t edge_len_bytes;
+};
+
+#endif /* __SAMPLE_EDGE_H_ */
@@ -0,0 +1,228 @@
+/* Generated by keystone-edgegen.py, do not edit */
+#include "sample_host.h"
+#include "edge_call.h"
+
+static void
+ping_wrapper(void* buffer) {
+  struct edge_call* edge_call = (struct edge_call*)buffer;
+  uintptr_t data;
+  size_t len;
+
+  if (edge_call_args_ptr(edge_call, &data, &len) != 0) {
+    goto bad_offset;
+  }
+
+  ping();
+  edge_call->return_data.call_status = CALL_STATUS_OK;
+  return;
+
+bad_offset:
+  edge_call->return_data.call_status = CALL_STATUS_BAD_OFFSET;
+  return;
+}
+
+static void
+put_string_wrapper(void* buffer) {
+  struct edge_call* edge_call = (struct edge_call*)buffer;
+  struct sample_put_string_args* args;
+  unsigned long* ret;
+  const char* str;
+  uintptr_t data, ptr;
+  size_t len, off = 0;
+
+  if (edge_call_args_ptr(edge_call, &data, &len) != 0) {
+    goto bad_offset;
+  }
+  if (edge_call_iov_next(data, len, &off, sizeof(*args), &ptr)) {
+    goto bad_offset;
+  }
+  args = (struct sample_put_string_args*)ptr;
+  if (edge_call_iov_next(data, len, &off, sizeof(*ret), &ptr)) {
+    goto bad_offset;
+  }
+  ret = (unsigned long*)ptr;
+  if (edge_call_iov_next(data, len, &off, args->edge_len_str, &ptr)) {
+    goto bad_offset;
+  }
+  str = (const char*)ptr;
+
+  /* the lengths must match the parameters that describe them */
+  if (!args->edge_len_str || str[args->edge_len_str - 1] != '\0') {
+    goto bad_ptr;
+  }
+
+  *ret = put_string(str);
+  edge_call->return_data.call_status = CALL_STATUS_OK;
+  return;
+
+bad_offset:
+  edge_call->return_data.call_status = CALL_STATUS_BAD_OFFSET;
+  return;
+
+bad_ptr:
+  edge_call->return_data.call_status = CALL_STATUS_BAD_PTR;
+}
+
+static void
+get_block_wrapper(void* buffer) {
+  struct edge_call* edge_call = (struct edge_call*)buffer;
+  struct sample_get_block_args* args;
+  int* ret;
+  void* buf;
+  uintptr_t data, ptr;
+  size_t len, off = 0;
+
+  if (edge_call_args_ptr(edge_call, &data, &len) != 0) {
+    goto bad_offset;
+  }
+  if (edge_call_iov_next(data, len, &off, sizeof(*args), &ptr)) {
+    goto bad_offset;
+  }
+  args = (struct sample_get_block_args*)ptr;
+  if (edge_call_iov_next(data, len, &off, sizeof(*ret), &ptr)) {
+    goto bad_offset;
+  }
+  ret = (int*)ptr;
+  if (edge_call_iov_next(data, len, &off, args->edge_len_buf, &ptr)) {
+    goto bad_offset;
+  }
+  buf = (void*)ptr;
+
+  /* the lengths must match the parameters that describe them */
+  if (args->edge_len_buf != (size_t)(args->len)) {
+    goto bad_ptr;
+  }
+
+  *ret = get_block(args->index, buf, args->len);
+  edge_call->return_data.call_status = CALL_STATUS_OK;
+  return;
+
+bad_offset:
+  edge_call->return_data.call_status = CALL_STATUS_BAD_OFFSET;
+  return;
+
+bad_ptr:
+  edge_call->return_data.call_status = CALL_STATUS_BAD_PTR;
+}
+
+static void
+scale_wrapper(void* buffer) {
+  struct edge_call* edge_call = (struct edge_call*)buffer;
+  struct sample_scale_args* args;
+  int* values;
+  uintptr_t data, ptr;
+  size_t len, off = 0;
+
+  if (edge_call_args_ptr(edge_call, &data, &len) != 0) {
+    goto bad_offset;
+  }
+  if (edge_call_iov_next(data, len, &off, sizeof(*args), &ptr)) {
+    goto bad_offset;
+  }
+  args = (struct sample_scale_args*)ptr;
+  if (edge_call_iov_next(data, len, &off, args->edge_len_values, &ptr)) {
+    goto bad_offset;
+  }
+  values = (int*)ptr;
+
+  /* the lengths must match the parameters that describe them */
+  if (args->edge_len_values % sizeof(int) ||
+      args->edge_len_values / sizeof(int) != (size_t)(args->n)) {
+    goto bad_ptr;
+  }
+
+  scale(values, args->n, args->factor);
+  edge_call->return_data.call_status = CALL_STATUS_OK;
+  return;
+
+bad_offset:
+  edge_call->return_data.call_status = CALL_STATUS_BAD_OFFSET;
+  return;
+
+bad_ptr:
+  edge_call->return_data.call_status = CALL_STATUS_BAD_PTR;
+}
+
+static void
+log_value_wrapper(void* buffer) {
+  struct edge_call* edge_call = (struct edge_call*)buffer;
+  struct sample_log_value_args* args;
+  uintptr_t data, ptr;
+  size_t len, off = 0;
+
+  if (edge_call_args_ptr(edge_call, &data, &len) != 0) {
+    goto bad_offset;
+  }
+  if (edge_call_iov_next(data, len, &off, sizeof(*args), &ptr)) {
+    goto bad_offset;
+  }
+  args = (struct sample_log_value_args*)ptr;
+
+  log_value(args->value);
+  edge_call->return_data.call_status = CALL_STATUS_OK;
+  return;
+
+bad_offset:
+  edge_call->return_data.call_status = CALL_STATUS_BAD_OFFSET;
+  return;
+}
+
+static void
+log_bytes_wrapper(void* buffer) {
+  struct edge_call* edge_call = (struct edge_call*)buffer;
+  struct sample_log_bytes_args* args;
+  const unsigned char* bytes;
+  uintptr_t data, ptr;
+  size_t len, off = 0;
+
+  if (edge_call_args_ptr(edge_call, &data, &len) != 0) {
+    goto bad_offset;
+  }
+  if (edge_call_iov_next(data, len, &off, sizeof(*args), &ptr)) {
+    goto bad_offset;
+  }
+  args = (struct sample_log_bytes_args*)ptr;
+  if (edge_call_iov_next(data, len, &off, args->edge_len_bytes, &ptr)) {
+    goto bad_offset;
+  }
+  bytes = (const unsigned char*)ptr;
+
+  /* the lengths must match the parameters that describe them */
+  if (args->edge_len_bytes != (size_t)(16)) {
+    goto bad_ptr;
+  }
+
+  log_bytes(bytes);
+  edge_call->return_data.call_status = CALL_STATUS_OK;
+  return;
+
+bad_offset:
+  edge_call->return_data.call_status = CALL_STATUS_BAD_OFFSET;
+  return;
+
+bad_ptr:
+  edge_call->return_data.call_status = CALL_STATUS_BAD_PTR;
+}
+
+int
+sample_register_ocalls(void) {
+  if (register_call(SAMPLE_OCALL_PING, ping_wrapper)) {
+    return -1;
+  }
+  if (register_call(SAMPLE_OCALL_PUT_STRING, put_string_wrapper)) {
+    return -1;
+  }
+  if (register_call(SAMPLE_OCALL_GET_BLOCK, get_block_wrapper)) {
+    return -1;
+  }
+  if (register_call(SAMPLE_OCALL_SCALE, scale_wrapper)) {
+    return -1;
+  }
+  if (register_call(SAMPLE_OCALL_LOG_VALUE, log_value_wrapper)) {
+    return -1;
+  }
+  if (register_call(SAMPLE_OCALL_LOG_BYTES, log_bytes_wrapper)) {
+    return -1;
+  }
+  return 0;
+}
@@ -0,0 +1,34 @@
+/* Generated by keystone-edgegen.py, do not edit */
+#ifndef __SAMPLE_HOST_H_
+#define __SAMPLE_HOST_H_
+
+#include "sample_edge.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* To be implemented by the host application. Buffers point into the
+   shared buffer and are only valid during the call. */
+void
+ping(void);
+unsigned long
+put_string(const char* str);
+int
+get_block(unsigned long index, void* buf, size_t len);
+void
+scale(int* values, size_t n, int factor);
+void
+log_value(unsigned long value);
+void
+log_bytes(const unsigned char* bytes);
+
+/* Registers the wrappers with register_call(); 0 on success */
+int
+sample_register_ocalls(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SAMPLE_HOST_H_ */
@@ -0,0 +1,304 @@
+//******************************************************************************
+// Copyright (c) 2020, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+
+/* Executor, EnclaveGroup and edge call dispatch against fake devices: each one stands in
+ * for an enclave that makes a number of ocalls through its own shared
+ * buffer, and becomes readable on an eventfd whenever it stops. */
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <stdexcept>
+#include <thread>
+
+#include <keystone.h>
+#include "edge/edge_call.h"
+#include "gtest/gtest.h"
+
+using Keystone::Enclave;
+using Keystone::EnclaveGroup;
+using Keystone::Error;
+using Keystone::Executor;
+
+#define TEST_CALL 7
+#define TEST_UNTRUSTED_SIZE 4096
+
+class FakeDevice : public Keystone::KeystoneDevice {
+ private:
+  int efd;
+  unsigned long tag;
+  int ocallsLeft;
+  int good;
+  void* buffer;
+
+  /* the "enclave" runs until its next ocall, unless it is done */
+  void next() {
+    if (ocallsLeft > 0) {
+      struct edge_call* call = (struct edge_call*)buffer;
+      memset(buffer, 0, TEST_UNTRUSTED_SIZE);
+      call->call_id         = TEST_CALL;
+      call->call_arg_offset = sizeof(struct edge_call);
+      call->call_arg_size   = sizeof(tag);
+      memcpy((char*)buffer + sizeof(struct edge_call), &tag, sizeof(tag));
+    }
+  }
+
+  /* check what the host wrote back for the last ocall */
+  void check() {
+    struct edge_call* call = (struct edge_call*)buffer;
+    unsigned long ret;
+    if (call->return_data.call_status == CALL_STATUS_OK &&
+        call->return_data.call_ret_size == sizeof(ret) &&
+        call->return_data.call_ret_offset == sizeof(struct edge_call)) {
+      memcpy(&ret, (char*)buffer + sizeof(struct edge_call), sizeof(ret));
+      if (ret == tag + 1) good++;
+    }
+    ocallsLeft--;
+  }
+
+  Error result(uintptr_t* ret) {
+    if (ocallsLeft > 0) return Error::EdgeCallHost;
+    if (ret) *ret = good;
+    return Error::Success;
+  }
+
+  Error signal() {
+    uint64_t one = 1;
+    return write(efd, &one, sizeof(one)) == sizeof(one) ? Error::Success
+                                                        : Error::DeviceError;
+  }
+
+ public:
+  FakeDevice(unsigned long tag, int ocalls)
+      : tag(tag), ocallsLeft(ocalls), good(0), buffer(NULL) {
+    efd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  }
+  ~FakeDevice() {
+    close(efd);
+    free(buffer);
+  }
+  int getFd() { return efd; }
+  void* map(uintptr_t addr, size_t size) {
+    buffer = calloc(1, size);
+    return buffer;
+  }
+  Error destroy() { return Error::Success; }
+  Error run(uintptr_t* ret) {
+    next();
+    return result(ret);
+  }
+  Error resume(uintptr_t* ret) {
+    check();
+    next();
+    return result(ret);
+  }
+  Error runAsync() {
+    next();
+    return signal();
+  }
+  Error resumeAsync() {
+    check();
+    next();
+    return signal();
+  }
+  Error asyncResult(uintptr_t* ret) {
+    uint64_t count;
+    if (read(efd, &count, sizeof(count)) != sizeof(count))
+      return Error::DeviceError;
+    return result(ret);
+  }
+};
+
+/* Returns the tag passed in plus one, through whatever shared buffer the
+ * edge library is bound to */
+static void
+test_call(void* buffer) {
+  struct edge_call* call = (struct edge_call*)buffer;
+  uintptr_t args;
+  size_t len;
+  unsigned long tag;
+
+  if (edge_call_args_ptr(call, &args, &len) || len != sizeof(tag)) {
+    call->return_data.call_status = CALL_STATUS_BAD_OFFSET;
+    return;
+  }
+  memcpy(&tag, (void*)args, sizeof(tag));
+  tag++;
+
+  unsigned long* ret = (unsigned long*)edge_call_data_ptr();
+  memcpy(ret, &tag, sizeof(tag));
+  if (edge_call_setup_ret(call, ret, sizeof(tag))) {
+    call->return_data.call_status = CALL_STATUS_BAD_PTR;
+    return;
+  }
+  call->return_data.call_status = CALL_STATUS_OK;
+}
+
+class ExecutorTest : public ::testing::Test {
+ protected:
+  void SetUp() { ASSERT_EQ(register_call(TEST_CALL, test_call), 0); }
+  void TearDown() { register_call(TEST_CALL, NULL); }
+};
+
+TEST_F(ExecutorTest, TwoEnclavesUseTheirOwnBuffers) {
+  FakeDevice dev1(100, 50), dev2(200, 50);
+  Enclave enclave1(&dev1, TEST_UNTRUSTED_SIZE);
+  Enclave enclave2(&dev2, TEST_UNTRUSTED_SIZE);
+  enclave1.registerOcallDispatch(incoming_call_dispatch);
+  enclave2.registerOcallDispatch(incoming_call_dispatch);
+
+  uintptr_t ret1 = 0, ret2 = 0;
+  {
+    Executor executor;
+    std::future<Error> run1 = enclave1.runAsync(&ret1, executor);
+    std::future<Error> run2 = enclave2.runAsync(&ret2, executor);
+    EXPECT_EQ(run1.get(), Error::Success);
+    EXPECT_EQ(run2.get(), Error::Success);
+  }
+
+  /* every ocall saw its own enclave's argument and wrote its result into
+   * that enclave's buffer */
+  EXPECT_EQ(ret1, 50);
+  EXPECT_EQ(ret2, 50);
+}
+
+TEST_F(ExecutorTest, AsyncOcallsResumeWithoutPolling) {
+  FakeDevice dev1(300, 5), dev2(400, 20);
+  Enclave enclave1(&dev1, TEST_UNTRUSTED_SIZE);
+  Enclave enclave2(&dev2, TEST_UNTRUSTED_SIZE);
+
+  /* the call is served at once, but the enclave may only resume later */
+  enclave1.registerAsyncOcallDispatch(
+      [](void* buffer, Keystone::OcallCompletion done) {
+        incoming_call_dispatch(buffer);
+        std::thread([done]() {
+          std::this_thread::sleep_for(std::chrono::milliseconds(5));
+          done(nullptr);
+        }).detach();
+      });
+  enclave2.registerOcallDispatch(incoming_call_dispatch);
+
+  uintptr_t ret1 = 0, ret2 = 0;
+  {
+    Executor executor;
+    std::future<Error> run1 = enclave1.runAsync(&ret1, executor);
+    std::future<Error> run2 = enclave2.runAsync(&ret2, executor);
+    ASSERT_EQ(
+        run1.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    EXPECT_EQ(run1.get(), Error::Success);
+    EXPECT_EQ(run2.get(), Error::Success);
+  }
+
+  EXPECT_EQ(ret1, 5);
+  EXPECT_EQ(ret2, 20);
+}
+
+TEST_F(ExecutorTest, FailedOcallsFailOnlyTheirEnclave) {
+  FakeDevice dev1(700, 5), dev2(800, 5), dev3(900, 20);
+  Enclave enclave1(&dev1, TEST_UNTRUSTED_SIZE);
+  Enclave enclave2(&dev2, TEST_UNTRUSTED_SIZE);
+  Enclave enclave3(&dev3, TEST_UNTRUSTED_SIZE);
+
+  /* throws on the executor thread */
+  enclave1.registerAsyncOcallDispatch(
+      [](void*, Keystone::OcallCompletion) {
+        throw std::runtime_error("handler");
+      });
+  /* completes with an exception from another thread */
+  enclave2.registerAsyncOcallDispatch(
+      [](void*, Keystone::OcallCompletion done) {
+        std::thread([done]() {
+          done(std::make_exception_ptr(std::runtime_error("completion")));
+        }).detach();
+      });
+  enclave3.registerOcallDispatch(incoming_call_dispatch);
+
+  uintptr_t ret3 = 0;
+  {
+    Executor executor;
+    std::future<Error> run1 = enclave1.runAsync(nullptr, executor);
+    std::future<Error> run2 = enclave2.runAsync(nullptr, executor);
+    std::future<Error> run3 = enclave3.runAsync(&ret3, executor);
+    EXPECT_THROW(run1.get(), std::runtime_error);
+    EXPECT_THROW(run2.get(), std::runtime_error);
+    EXPECT_EQ(run3.get(), Error::Success);
+  }
+
+  EXPECT_EQ(ret3, 20);
+}
+
+TEST_F(ExecutorTest, RunWaitsForAsyncOcalls) {
+  FakeDevice dev(1000, 10);
+  Enclave enclave(&dev, TEST_UNTRUSTED_SIZE);
+
+  enclave.registerAsyncOcallDispatch(
+      [](void* buffer, Keystone::OcallCompletion done) {
+        std::thread([buffer, done]() {
+          incoming_call_dispatch(buffer);
+          done(nullptr);
+        }).detach();
+      });
+
+  /* the handler threads bind nothing, use the process-wide buffer */
+  edge_call_init_internals(
+      (uintptr_t)enclave.getSharedBuffer(), enclave.getSharedBufferSize());
+  uintptr_t ret = 0;
+  EXPECT_EQ(enclave.run(&ret), Error::Success);
+  EXPECT_EQ(ret, 10);
+}
+
+TEST_F(ExecutorTest, GroupMembersUseTheirOwnBuffers) {
+  FakeDevice dev1(500, 200), dev2(600, 200);
+  Enclave enclave1(&dev1, TEST_UNTRUSTED_SIZE);
+  Enclave enclave2(&dev2, TEST_UNTRUSTED_SIZE);
+  /* nothing binds the buffers but the group */
+  enclave1.registerOcallDispatch(incoming_call_dispatch);
+  enclave2.registerOcallDispatch(incoming_call_dispatch);
+
+  uintptr_t ret1 = 0, ret2 = 0;
+  {
+    EnclaveGroup group;
+    int member1 = group.add(&enclave1);
+    int member2 = group.add(&enclave2);
+    group.startAll();
+    EXPECT_EQ(group.wait(member1, &ret1), Error::Success);
+    EXPECT_EQ(group.wait(member2, &ret2), Error::Success);
+  }
+
+  EXPECT_EQ(ret1, 200);
+  EXPECT_EQ(ret2, 200);
+}
+
+TEST(EdgeThread, BindingIsPerThread) {
+  static char buffers[2][256];
+  std::atomic<int> bad(0);
+
+  auto serve = [&bad](int i) {
+    edge_call_init_thread_internals((uintptr_t)buffers[i], sizeof(buffers[i]));
+    for (int n = 0; n < 100000; n++) {
+      uintptr_t ptr;
+      if (edge_call_get_ptr_from_offset(16, 8, &ptr) ||
+          ptr != (uintptr_t)buffers[i] + 16 ||
+          edge_call_check_ptr_valid((uintptr_t)buffers[1 - i], 8) == 0) {
+        bad++;
+      }
+    }
+  };
+
+  std::thread thread1(serve, 0), thread2(serve, 1);
+  thread1.join();
+  thread2.join();
+  EXPECT_EQ(bad, 0);
+}
+
+int
+main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
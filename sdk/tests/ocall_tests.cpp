@@ -0,0 +1,275 @@
+//******************************************************************************
+// Copyright (c) 2020, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+
+/* Typed ocall decoding and the edge call table, driven by writing edge calls
+ * into the shared buffer of an enclave on a mock device */
+
+#include <cstring>
+
+#include <keystone.h>
+#include "edge/edge_call.h"
+#include "gtest/gtest.h"
+
+using Keystone::Enclave;
+using Keystone::Error;
+using Keystone::MockKeystoneDevice;
+using Keystone::OcallBuffer;
+
+#define TEST_UNTRUSTED_SIZE 4096
+
+class OcallTest : public ::testing::Test {
+ protected:
+  MockKeystoneDevice device;
+  Enclave* enclave;
+  struct edge_call* call;
+
+  void SetUp() {
+    enclave = new Enclave(&device, TEST_UNTRUSTED_SIZE);
+    call    = (struct edge_call*)enclave->getSharedBuffer();
+    edge_call_init_internals(
+        (uintptr_t)enclave->getSharedBuffer(), enclave->getSharedBufferSize());
+  }
+  void TearDown() { delete enclave; }
+
+  /* what the enclave side would have written before exiting */
+  unsigned long ocall(unsigned long id, const void* args, size_t size) {
+    memset(call, 0, TEST_UNTRUSTED_SIZE);
+    call->call_id         = id;
+    call->call_arg_offset = sizeof(struct edge_call);
+    call->call_arg_size   = size;
+    memcpy((char*)call + sizeof(struct edge_call), args, size);
+    incoming_call_dispatch(call);
+    return call->return_data.call_status;
+  }
+
+  template <typename R>
+  R result() {
+    uintptr_t ptr;
+    size_t size;
+    R ret;
+    EXPECT_EQ(edge_call_ret_ptr(call, &ptr, &size), 0);
+    EXPECT_EQ(size, sizeof(R));
+    memcpy(&ret, (void*)ptr, sizeof(R));
+    return ret;
+  }
+};
+
+static bool called;
+
+TEST_F(OcallTest, DecodesArgumentsAsStruct) {
+  struct {
+    uint8_t a;
+    uint64_t b;
+    uint16_t c;
+  } args = {3, 1UL << 40, 500};
+
+  std::function<uint64_t(uint8_t, uint64_t, const uint16_t&)> sum =
+      [](uint8_t a, uint64_t b, const uint16_t& c) -> uint64_t {
+    return a + b + c;
+  };
+  ASSERT_EQ(enclave->registerOcall<100>(sum), Error::Success);
+
+  EXPECT_EQ(ocall(100, &args, sizeof(args)), CALL_STATUS_OK);
+  EXPECT_EQ(result<uint64_t>(), (1UL << 40) + 503);
+}
+
+struct Big {
+  uint64_t v[4];
+};
+
+TEST_F(OcallTest, ResultDoesNotOverwriteArgumentsInUse) {
+  Big args = {{1, 2, 3, 4}};
+
+  /* reads the argument, which lies where the result goes, while building
+   * the result */
+  enclave->registerOcall<106>(std::function<Big(const Big&)>(
+      [](const Big& in) -> Big {
+        Big out;
+        for (int i = 0; i < 4; i++) out.v[i] = in.v[3 - i];
+        return out;
+      }));
+
+  EXPECT_EQ(ocall(106, &args, sizeof(args)), CALL_STATUS_OK);
+  Big ret = result<Big>();
+  EXPECT_EQ(ret.v[0], 4);
+  EXPECT_EQ(ret.v[1], 3);
+  EXPECT_EQ(ret.v[2], 2);
+  EXPECT_EQ(ret.v[3], 1);
+}
+
+TEST_F(OcallTest, DecodesTrailingStringAndBuffer) {
+  char args[16] = {0};
+  int n         = 7;
+  memcpy(args, &n, sizeof(n));
+  strcpy(args + sizeof(n), "hello");
+
+  enclave->registerOcall<101>(std::function<size_t(int, char*)>(
+      [](int n, char* str) -> size_t { return n + strlen(str); }));
+  EXPECT_EQ(ocall(101, args, sizeof(n) + 6), CALL_STATUS_OK);
+  EXPECT_EQ(result<size_t>(), 12);
+
+  enclave->registerOcall<102>(std::function<size_t(int, OcallBuffer)>(
+      [](int n, OcallBuffer buf) -> size_t {
+        return n + buf.size + ((char*)buf.data)[0];
+      }));
+  EXPECT_EQ(ocall(102, args, sizeof(args)), CALL_STATUS_OK);
+  EXPECT_EQ(result<size_t>(), 7 + 12 + 'h');
+}
+
+TEST_F(OcallTest, RejectsShortArguments) {
+  uint64_t args[2] = {1, 2};
+
+  enclave->registerOcall<103>(std::function<void(uint64_t, uint32_t)>(
+      [](uint64_t, uint32_t) { called = true; }));
+  called = false;
+  EXPECT_EQ(ocall(103, args, 11), CALL_STATUS_BAD_OFFSET);
+  EXPECT_FALSE(called);
+  EXPECT_EQ(ocall(103, args, 12), CALL_STATUS_OK);
+  EXPECT_TRUE(called);
+
+  /* no terminating NUL within the arguments */
+  char str[4] = {'a', 'b', 'c', 'd'};
+  enclave->registerOcall<104>(
+      std::function<void(char*)>([](char*) { called = true; }));
+  called = false;
+  EXPECT_EQ(ocall(104, str, sizeof(str)), CALL_STATUS_BAD_OFFSET);
+  EXPECT_FALSE(called);
+}
+
+TEST_F(OcallTest, HandlersAreProcessWide) {
+  MockKeystoneDevice otherDevice;
+  Enclave other(&otherDevice, TEST_UNTRUSTED_SIZE);
+  int args = 1;
+
+  enclave->registerOcall<105>(
+      std::function<int(int)>([](int v) { return v + 1; }));
+  /* registering the id from another enclave replaces the handler */
+  other.registerOcall<105>(
+      std::function<int(int)>([](int v) { return v + 2; }));
+
+  EXPECT_EQ(ocall(105, &args, sizeof(args)), CALL_STATUS_OK);
+  EXPECT_EQ(result<int>(), 3);
+}
+
+/* returns the id it was called with */
+static void
+echo_call(void* buffer) {
+  struct edge_call* call = (struct edge_call*)buffer;
+  unsigned long* ret     = (unsigned long*)edge_call_data_ptr();
+
+  *ret = call->call_id;
+  call->return_data.call_status =
+      edge_call_setup_ret(call, ret, sizeof(*ret)) ? CALL_STATUS_BAD_PTR
+                                                   : CALL_STATUS_OK;
+}
+
+TEST_F(OcallTest, CallTableGrowsPastOldLimit) {
+  /* sparse ids, and far more of them than the fixed table held */
+  for (unsigned long i = 0; i < 300; i++) {
+    ASSERT_EQ(register_call(1000 + i * 7919, echo_call), 0);
+  }
+  ASSERT_EQ(register_call(1UL << 60, echo_call), 0);
+  EXPECT_NE(register_call(EDGECALL_BATCH, echo_call), 0);
+
+  for (unsigned long i = 0; i < 300; i++) {
+    unsigned long id = 1000 + i * 7919;
+    ASSERT_EQ(ocall(id, NULL, 0), CALL_STATUS_OK);
+    EXPECT_EQ(result<unsigned long>(), id);
+  }
+  EXPECT_EQ(ocall(1UL << 60, NULL, 0), CALL_STATUS_OK);
+  EXPECT_EQ(result<unsigned long>(), 1UL << 60);
+  EXPECT_EQ(ocall(1001, NULL, 0), CALL_STATUS_BAD_CALL_ID);
+
+  for (unsigned long i = 0; i < 300; i++) {
+    register_call(1000 + i * 7919, NULL);
+  }
+  register_call(1UL << 60, NULL);
+}
+
+TEST_F(OcallTest, UnregisterKeepsOtherCalls) {
+  for (unsigned long id = 200; id < 264; id++) {
+    ASSERT_EQ(register_call(id, echo_call), 0);
+  }
+
+  /* every other id goes, the ones probed past them must still be found */
+  for (unsigned long id = 200; id < 264; id += 2) {
+    ASSERT_EQ(register_call(id, NULL), 0);
+  }
+  for (unsigned long id = 200; id < 264; id++) {
+    if (id % 2) {
+      EXPECT_EQ(ocall(id, NULL, 0), CALL_STATUS_OK);
+      EXPECT_EQ(result<unsigned long>(), id);
+    } else {
+      EXPECT_EQ(ocall(id, NULL, 0), CALL_STATUS_BAD_CALL_ID);
+    }
+  }
+
+  /* and an unregistered id can come back */
+  ASSERT_EQ(register_call(200, echo_call), 0);
+  EXPECT_EQ(ocall(200, NULL, 0), CALL_STATUS_OK);
+  EXPECT_EQ(result<unsigned long>(), 200);
+
+  for (unsigned long id = 200; id < 264; id++) {
+    register_call(id, NULL);
+  }
+}
+
+static unsigned long batch_sum;
+
+/* adds up its argument, and writes a result over the data section like any
+ * handler that returns something, here one larger than several records */
+static void
+sum_call(void* buffer) {
+  struct edge_call* call = (struct edge_call*)buffer;
+  void* ret              = (void*)edge_call_data_ptr();
+  uintptr_t args;
+  size_t len;
+  unsigned long value;
+
+  if (edge_call_args_ptr(call, &args, &len) || len != sizeof(value)) {
+    call->return_data.call_status = CALL_STATUS_BAD_OFFSET;
+    return;
+  }
+  memcpy(&value, (void*)args, sizeof(value));
+  batch_sum += value;
+
+  memset(ret, 0xa5, 256);
+  call->return_data.call_status = edge_call_setup_ret(call, ret, 256)
+                                      ? CALL_STATUS_BAD_PTR
+                                      : CALL_STATUS_OK;
+}
+
+TEST_F(OcallTest, BatchedResultsDoNotClobberLaterCalls) {
+  struct {
+    struct edge_batch_record record;
+    unsigned long value;
+  } batch[8];
+
+  ASSERT_EQ(register_call(300, sum_call), 0);
+  for (unsigned long i = 0; i < 8; i++) {
+    batch[i].record.call_id = 300;
+    batch[i].record.size    = sizeof(batch[i].value);
+    batch[i].value          = 1UL << i;
+  }
+
+  batch_sum = 0;
+  EXPECT_EQ(ocall(EDGECALL_BATCH, batch, sizeof(batch)), CALL_STATUS_OK);
+  EXPECT_EQ(batch_sum, 0xffUL);
+
+  /* a failing record stops the batch */
+  batch[3].record.call_id = 301;
+  batch_sum               = 0;
+  EXPECT_EQ(
+      ocall(EDGECALL_BATCH, batch, sizeof(batch)), CALL_STATUS_BAD_CALL_ID);
+  EXPECT_EQ(batch_sum, 0x7UL);
+
+  register_call(300, NULL);
+}
+
+int
+main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
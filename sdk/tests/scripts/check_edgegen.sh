@@ -0,0 +1,18 @@
+#!/bin/bash
+# Compares the output of keystone-edgegen.py for tests/edgegen/sample.edge
+# with the files in tests/edgegen/expected. After changing the generator on
+# purpose, rerun with --update to refresh them.
+
+TESTS_DIR=$(cd "$(dirname "$0")/.." && pwd)
+GENERATOR=$TESTS_DIR/../scripts/keystone-edgegen.py
+OUT=$(mktemp -d)
+trap 'rm -rf "$OUT"' EXIT
+
+python3 "$GENERATOR" "$TESTS_DIR/edgegen/sample.edge" -o "$OUT" || exit 1
+
+if [ "$1" = "--update" ]; then
+  cp "$OUT"/* "$TESTS_DIR/edgegen/expected/"
+  exit 0
+fi
+
+diff -ru "$TESTS_DIR/edgegen/expected" "$OUT"
@@ -0,0 +1,98 @@
+//******************************************************************************
+// Copyright (c) 2020, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+
+/* Known answers for the SM's ed25519, built from sm/src/ed25519 as it is.
+ * The vectors were produced with the ref10 field arithmetic
+ * (ED25519_REF10_FE); TestSMEd25519 checks that the radix-2^51 one gives
+ * the same keys, signatures and shared secrets, and TestSMEd25519Ref10
+ * keeps the vectors themselves honest. */
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "ed25519/ed25519.h"
+#include "gtest/gtest.h"
+
+struct sm_ed25519_vector {
+  const char* public_key;
+  const char* signature;  // of message(), msg_len bytes
+  size_t msg_len;
+  const char* shared;  // with the public key of the next vector
+};
+
+static const struct sm_ed25519_vector vectors[] = {
+    {"3cdfeedce1f693c8dc6a5b63cd1d63fed42525ecbf36352a383566a00ada4f47",
+     "c792a5bdc4b7f735cbcec7d3642ad98c54d13b4920d0beb042d5c04b4c156718"
+     "9088e9f1678cf550756fd2a56ecf7cc4cf30e6d8a59a8af5d731317569a35609",
+     0, "2c45a3a22659293fd866834ccfc53b9e04808db17984596f4a6204eaf75f1d10"},
+    {"5495892f88add074613d3d52fac980741110cc15e19d2ed68930c753c25db8ab",
+     "b4905437d47c66492a015cdfd947f6e7cf0cbf56df253a2b8b5aeb5eb173c530"
+     "12e4db775f1bff376b75424b5c12e487a29b8c9a7fae48cc2e49629ebee11b0a",
+     64, "2399143dba7530d0f67636f218ad936aa4fcd0f111007ffa14ea20e4f6ffa168"},
+    {"2e47ab77f53e44906dd53357efae88e7564d8e6ffe17722d5273345cc3e39427",
+     "71ff65b4c924fe4f90acd32b4775fd8f3f06f2f2644f1858bef646b240da0338"
+     "ebbcb1fb2a6c4e349eafdada81b0271942c1eca4f2a6356391fc74da42c7e101",
+     1000, "06a0851606143f6ddf052f9ccb10981050ef3a2e85f1cbe20bc54e15d37ad261"},
+};
+
+#define NUM_VECTORS (sizeof(vectors) / sizeof(vectors[0]))
+
+static std::string
+to_hex(const unsigned char* bytes, size_t len) {
+  std::string hex;
+  char buf[3];
+  for (size_t i = 0; i < len; i++) {
+    snprintf(buf, sizeof(buf), "%02x", bytes[i]);
+    hex += buf;
+  }
+  return hex;
+}
+
+static void
+make_keypair(int k, unsigned char* pk, unsigned char* sk) {
+  unsigned char seed[32];
+  for (int i = 0; i < 32; i++) seed[i] = (unsigned char)(k * 0x55 + i * 3);
+  ed25519_create_keypair(pk, sk, seed);
+}
+
+static const unsigned char*
+message() {
+  static unsigned char msg[1000];
+  for (size_t i = 0; i < sizeof(msg); i++) msg[i] = (unsigned char)(i * 13 + 1);
+  return msg;
+}
+
+TEST(SmEd25519, Keypair) {
+  unsigned char pk[32], sk[64];
+  for (size_t k = 0; k < NUM_VECTORS; k++) {
+    make_keypair(k, pk, sk);
+    EXPECT_EQ(to_hex(pk, 32), vectors[k].public_key) << "vector " << k;
+  }
+}
+
+TEST(SmEd25519, Sign) {
+  unsigned char pk[32], sk[64], sig[64];
+  for (size_t k = 0; k < NUM_VECTORS; k++) {
+    make_keypair(k, pk, sk);
+    ed25519_sign(sig, message(), vectors[k].msg_len, pk, sk);
+    EXPECT_EQ(to_hex(sig, 64), vectors[k].signature) << "vector " << k;
+  }
+}
+
+TEST(SmEd25519, KeyExchange) {
+  unsigned char pk[NUM_VECTORS][32], sk[NUM_VECTORS][64], shared[32];
+  for (size_t k = 0; k < NUM_VECTORS; k++) make_keypair(k, pk[k], sk[k]);
+  for (size_t k = 0; k < NUM_VECTORS; k++) {
+    ed25519_key_exchange(shared, pk[(k + 1) % NUM_VECTORS], sk[k]);
+    EXPECT_EQ(to_hex(shared, 32), vectors[k].shared) << "vector " << k;
+  }
+}
+
+int
+main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,86 @@
+//******************************************************************************
+// Copyright (c) 2020, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+
+/* Host cycle benchmark of the SM's ed25519 signing path. It builds the
+ * sources from sm/src/ed25519 as they are, so BenchSMSign measures the
+ * radix-2^51 field arithmetic the SM uses on RV64 and BenchSMSignRef10 the
+ * portable ref10 fallback. The message sizes are those of attest_enclave
+ * and of the sealing key derivation. */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "ed25519/ed25519.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static inline uint64_t
+cycles() {
+  return __rdtsc();
+}
+#elif defined(__riscv)
+static inline uint64_t
+cycles() {
+  uint64_t c;
+  asm volatile("rdcycle %0" : "=r"(c));
+  return c;
+}
+#else
+static inline uint64_t
+cycles() {
+  return 0;
+}
+#endif
+
+/* signed part of struct enclave_report, and a sealing key identifier */
+static const size_t sizes[] = {1168, 64};
+
+int
+main(int argc, char** argv) {
+  size_t iters = (argc > 1) ? strtoul(argv[1], NULL, 0) : 2001;
+
+  unsigned char seed[32], pk[32], sk[64], sig[64];
+  for (size_t i = 0; i < sizeof(seed); i++) seed[i] = (unsigned char)(i * 7);
+  ed25519_create_keypair(pk, sk, seed);
+
+#ifdef ED25519_REF10_FE
+  printf("field arithmetic: ref10 (radix 2^25.5)\n");
+#else
+  printf("field arithmetic: radix 2^51 where __int128 is available\n");
+#endif
+
+  for (size_t n : sizes) {
+    std::vector<unsigned char> msg(n);
+    for (size_t i = 0; i < n; i++) msg[i] = (unsigned char)(i * 131);
+
+    /* time every call and report the median so interrupts and frequency
+     * changes on a shared host do not skew the result */
+    std::vector<uint64_t> c(iters);
+    std::vector<double> ns(iters);
+    ed25519_sign(sig, msg.data(), n, pk, sk);
+    for (size_t i = 0; i < iters; i++) {
+      auto start  = std::chrono::steady_clock::now();
+      uint64_t c0 = cycles();
+      ed25519_sign(sig, msg.data(), n, pk, sk);
+      c[i]  = cycles() - c0;
+      ns[i] = std::chrono::duration<double>(
+                  std::chrono::steady_clock::now() - start)
+                  .count() *
+              1e9;
+      msg[0] = sig[0];
+    }
+    std::sort(c.begin(), c.end());
+    std::sort(ns.begin(), ns.end());
+    printf(
+        "ed25519_sign %5zu bytes: %8llu cycles, %8.1f us (median of %zu)\n",
+        n, (unsigned long long)c[iters / 2], ns[iters / 2] / 1000, iters);
+  }
+
+  return 0;
+}
@@ -0,0 +1,285 @@
+//******************************************************************************
+// Copyright (c) 2020, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "verifier/Report.hpp"
+
+#define NUM_REPORTS 200
+
+static byte dev_pk[PUBLIC_KEY_SIZE], dev_sk[64];
+static byte sm_pk[PUBLIC_KEY_SIZE], sm_sk[64];
+static byte enclave_hash[MDSIZE], sm_hash[MDSIZE];
+
+static void
+make_keys() {
+  byte seed[32];
+  for (int i = 0; i < 32; i++) seed[i] = i;
+  ed25519_create_keypair(dev_pk, dev_sk, seed);
+  for (int i = 0; i < 32; i++) seed[i] = 0xa0 + i;
+  ed25519_create_keypair(sm_pk, sm_sk, seed);
+  memset(enclave_hash, 0x22, MDSIZE);
+  memset(sm_hash, 0x11, MDSIZE);
+}
+
+#define SIGNED_LEN (sizeof(struct enclave_report_t) - SIGNATURE_SIZE)
+
+/* Logs are not capped by ATTEST_DATA_MAXLEN, so some go past it */
+static std::vector<byte>
+make_log(int i) {
+  std::vector<byte> log((i % 3) * 1000);
+  for (size_t k = 0; k < log.size(); k++) log[k] = (byte)(i + k);
+  return log;
+}
+
+/* Signs a report the way the SM does, then applies corrupt() to it */
+static std::vector<Report>
+make_reports(void (*corrupt)(int, struct report_t*)) {
+  std::vector<Report> reports(NUM_REPORTS);
+  struct report_t r;
+
+  make_keys();
+  memset(&r, 0, sizeof(r));
+  memcpy(r.sm.hash, sm_hash, MDSIZE);
+  memcpy(r.sm.public_key, sm_pk, PUBLIC_KEY_SIZE);
+  ed25519_sign(
+      r.sm.signature, reinterpret_cast<byte*>(&r.sm),
+      MDSIZE + PUBLIC_KEY_SIZE, dev_pk, dev_sk);
+  memcpy(r.enclave.hash, enclave_hash, MDSIZE);
+  memcpy(r.dev_public_key, dev_pk, PUBLIC_KEY_SIZE);
+
+  for (int i = 0; i < NUM_REPORTS; i++) {
+    struct report_t copy = r;
+    copy.enclave.data_len = sizeof(i);
+    memcpy(copy.enclave.data, &i, sizeof(i));
+    std::vector<byte> log = make_log(i);
+    sha3_ctx_t ctx;
+    sha3_init(&ctx, MDSIZE);
+    sha3_update(&ctx, log.data(), log.size());
+    sha3_final(copy.enclave.log_hash, &ctx);
+    copy.enclave.log_len = log.size();
+    ed25519_sign(
+        copy.enclave.signature, reinterpret_cast<byte*>(&copy.enclave),
+        SIGNED_LEN, sm_pk, sm_sk);
+    if (corrupt) corrupt(i, &copy);
+    reports[i].fromBytes(reinterpret_cast<byte*>(&copy));
+  }
+  return reports;
+}
+
+static void
+expect_same_as_single(std::vector<Report>& reports, unsigned int threads) {
+  std::vector<int> batch = Report::verifyBatch(
+      reports, enclave_hash, sm_hash, dev_pk, threads);
+
+  ASSERT_EQ(batch.size(), reports.size());
+  for (size_t i = 0; i < reports.size(); i++)
+    EXPECT_EQ(
+        batch[i] != 0,
+        reports[i].verify(enclave_hash, sm_hash, dev_pk) != 0)
+        << "report " << i;
+}
+
+TEST(VerifyBatch, AllValid) {
+  std::vector<Report> reports = make_reports(NULL);
+  std::vector<int> valid =
+      Report::checkSignaturesBatch(reports, dev_pk);
+  for (size_t i = 0; i < valid.size(); i++) EXPECT_TRUE(valid[i]);
+  expect_same_as_single(reports, 1);
+  expect_same_as_single(reports, 4);
+}
+
+TEST(VerifyBatch, BadEnclaveSignatures) {
+  std::vector<Report> reports =
+      make_reports([](int i, struct report_t* r) {
+        if (i % 37 == 5) r->enclave.data[0] ^= 1;
+        if (i == 150) r->enclave.signature[40] ^= 1;
+      });
+  expect_same_as_single(reports, 0);
+}
+
+TEST(VerifyBatch, BadSmSignature) {
+  std::vector<Report> reports =
+      make_reports([](int i, struct report_t* r) {
+        if (i == 77) r->sm.signature[3] ^= 1;
+      });
+  std::vector<int> valid =
+      Report::checkSignaturesBatch(reports, dev_pk);
+  for (size_t i = 0; i < valid.size(); i++) EXPECT_EQ(valid[i], i != 77);
+  expect_same_as_single(reports, 2);
+}
+
+TEST(VerifyBatch, WrongHash) {
+  std::vector<Report> reports =
+      make_reports([](int i, struct report_t* r) {
+        if (i == 10) r->enclave.hash[0] ^= 1;
+      });
+  expect_same_as_single(reports, 2);
+}
+
+TEST(CompactReport, RoundTrip) {
+  std::vector<Report> reports = make_reports(NULL);
+
+  for (int i = 0; i < 3; i++) {
+    std::vector<byte> wire = reports[i].toCompact();
+    EXPECT_EQ(
+        wire.size(), REPORT_WIRE_HEADER_SIZE + sizeof(int));
+
+    ReportView view;
+    ASSERT_TRUE(view.parse(wire.data(), wire.size()));
+    EXPECT_TRUE(view.verify(enclave_hash, sm_hash, dev_pk));
+    EXPECT_EQ(view.getDataSize(), sizeof(int));
+    EXPECT_EQ(memcmp(view.getDataSection(), &i, sizeof(i)), 0);
+    std::vector<byte> log = make_log(i);
+    EXPECT_TRUE(view.checkLog(log.data(), log.size()));
+
+    Report copy;
+    ASSERT_TRUE(copy.fromCompact(wire.data(), wire.size()));
+    EXPECT_TRUE(copy.verify(enclave_hash, sm_hash, dev_pk));
+  }
+}
+
+TEST(CompactReport, NonZeroTail) {
+  std::vector<Report> reports =
+      make_reports([](int i, struct report_t* r) {
+        r->enclave.data[ATTEST_DATA_MAXLEN - 1] = 0xff;
+        ed25519_sign(
+            r->enclave.signature, reinterpret_cast<byte*>(&r->enclave),
+            SIGNED_LEN, sm_pk, sm_sk);
+      });
+  std::vector<byte> wire = reports[0].toCompact();
+  EXPECT_EQ(wire.size(), REPORT_WIRE_HEADER_SIZE + ATTEST_DATA_MAXLEN);
+
+  ReportView view;
+  ASSERT_TRUE(view.parse(wire.data(), wire.size()));
+  EXPECT_TRUE(view.verify(enclave_hash, sm_hash, dev_pk));
+}
+
+TEST(CompactReport, Rejects) {
+  std::vector<Report> reports = make_reports(NULL);
+  std::vector<byte> wire      = reports[1].toCompact();
+  ReportView view;
+
+  EXPECT_FALSE(view.parse(wire.data(), wire.size() - 1));
+  EXPECT_FALSE(view.parse(wire.data(), REPORT_WIRE_HEADER_SIZE - 1));
+
+  std::vector<byte> bad = wire;
+  bad[0] ^= 1;
+  EXPECT_FALSE(view.parse(bad.data(), bad.size()));
+
+  bad = wire;
+  bad[264 + 1] = 0x10; /* data_len > ATTEST_DATA_MAXLEN */
+  EXPECT_FALSE(view.parse(bad.data(), bad.size()));
+
+  bad = wire;
+  bad[REPORT_WIRE_HEADER_SIZE] ^= 1; /* signed data */
+  ASSERT_TRUE(view.parse(bad.data(), bad.size()));
+  EXPECT_FALSE(view.checkSignaturesOnly(dev_pk));
+  EXPECT_FALSE(view.verify(enclave_hash, sm_hash, dev_pk));
+}
+
+TEST(ReportLog, MatchesHash) {
+  std::vector<Report> reports = make_reports(NULL);
+  Report& r                   = reports[2];
+  std::vector<byte> log       = make_log(2);
+
+  EXPECT_EQ(r.getLogSize(), 0u);
+  EXPECT_EQ(r.getLogSection(), (void*)NULL);
+
+  std::vector<byte> bad = log;
+  bad[1500] ^= 1;
+  EXPECT_FALSE(r.setLog(bad.data(), bad.size()));
+  EXPECT_FALSE(r.setLog(log.data(), log.size() - 1));
+  EXPECT_EQ(r.getLogSize(), 0u);
+
+  EXPECT_TRUE(r.setLog(log.data(), log.size()));
+  EXPECT_EQ(r.getLogSize(), log.size());
+  EXPECT_EQ(memcmp(r.getLogSection(), log.data(), log.size()), 0);
+  EXPECT_TRUE(r.verify(enclave_hash, sm_hash, dev_pk));
+}
+
+static std::string
+sha3_512_hex(const void* in, size_t len) {
+  unsigned char md[MDSIZE];
+  char hex[2 * MDSIZE + 1];
+  sha3(in, len, md, MDSIZE);
+  for (int i = 0; i < MDSIZE; i++) sprintf(hex + 2 * i, "%02x", md[i]);
+  return std::string(hex);
+}
+
+TEST(SHA3, KnownAnswer) {
+  /* Measurements must not change with the Keccak implementation */
+  unsigned char a3[200];
+  memset(a3, 0xa3, sizeof(a3));
+
+  EXPECT_EQ(
+      sha3_512_hex("", 0),
+      "a69f73cca23a9ac5c8b567dc185a756e97c982164fe25859e0d1dcc1475c80a6"
+      "15b2123af1f5f94c11e3e9402c3ac558f500199d95b6d3e301758586281dcd26");
+  EXPECT_EQ(
+      sha3_512_hex("abc", 3),
+      "b751850b1a57168a5693cd924b6b096e08f621827444f70d884f5d0240d2712e"
+      "10e116e9192af3c91a7ec57647e3934057340b4cf408d5a56592f8274eec53f0");
+  EXPECT_EQ(
+      sha3_512_hex(a3, sizeof(a3)),
+      "e76dfad22084a8b1467fcf2ffa58361bec7628edf5f3fdc0e4805dc48caeeca8"
+      "1b7c13c30adf52a3659584739a2df46be589c51ca1a4a8416df6545a1ce8ba00");
+}
+
+TEST(SHA3, IncrementalMatchesOneShot) {
+  /* odd split points cross the 72-byte rate and misalign the input */
+  unsigned char in[1000], md[MDSIZE], expected[MDSIZE];
+  for (size_t i = 0; i < sizeof(in); i++) in[i] = (unsigned char)(i * 7);
+  sha3(in, sizeof(in), expected, MDSIZE);
+
+  sha3_ctx_t ctx;
+  sha3_init(&ctx, MDSIZE);
+  size_t off = 0, step = 1;
+  while (off < sizeof(in)) {
+    size_t n = std::min(step, sizeof(in) - off);
+    sha3_update(&ctx, in + off, n);
+    off += n;
+    step = step * 3 + 1;
+  }
+  sha3_final(md, &ctx);
+  EXPECT_EQ(0, memcmp(md, expected, MDSIZE));
+}
+
+TEST(AttestMac, MatchesSm) {
+  /* Tag computed by sm/src/enclave.c attest_enclave_mac() with the SM key
+   * of make_keys(), the verifier key below, the enclave hash of make_keys()
+   * and the data "challenge 0001" */
+  static const char* sm_tag =
+      "985f9331b1cfc38ed41165296926e67a60a5ec90019983a73c8c0838837aa801"
+      "235791ba3736718e481e332b9779ea5876fffe5fc7a470aa3e83e2f66e0dc095";
+  const char* data = "challenge 0001";
+  byte verifier_pk[PUBLIC_KEY_SIZE], verifier_sk[64], seed[32];
+  byte tag[ATTEST_MAC_SIZE];
+
+  for (int i = 0; i < 32; i++) seed[i] = 0x40 + i;
+  ed25519_create_keypair(verifier_pk, verifier_sk, seed);
+
+  std::vector<Report> reports = make_reports(NULL);
+  Report& report = reports[0];
+  ASSERT_TRUE(report.verify(enclave_hash, sm_hash, dev_pk));
+
+  report.HexToBytes(tag, sizeof(tag), sm_tag);
+  EXPECT_FALSE(report.verifyMac(tag, (const byte*)data, strlen(data)));
+
+  report.setMacVerifierKey(verifier_sk);
+  EXPECT_TRUE(report.verifyMac(tag, (const byte*)data, strlen(data)));
+  EXPECT_FALSE(report.verifyMac(tag, (const byte*)data, strlen(data) - 1));
+  tag[ATTEST_MAC_SIZE - 1] ^= 1;
+  EXPECT_FALSE(report.verifyMac(tag, (const byte*)data, strlen(data)));
+}
+
+int
+main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -26,8 +26,10 @@ platform-objs-y += $(KEYSTONE_SM_REL)src/ipi.o
 
 platform-objs-y += $(KEYSTONE_SM_REL)src/sha3/sha3.o
 platform-objs-y += $(KEYSTONE_SM_REL)src/ed25519/fe.o
+platform-objs-y += $(KEYSTONE_SM_REL)src/ed25519/fe51.o
 platform-objs-y += $(KEYSTONE_SM_REL)src/ed25519/ge.o
 platform-objs-y += $(KEYSTONE_SM_REL)src/ed25519/keypair.o
+platform-objs-y += $(KEYSTONE_SM_REL)src/ed25519/key_exchange.o
 platform-objs-y += $(KEYSTONE_SM_REL)src/ed25519/sc.o
 platform-objs-y += $(KEYSTONE_SM_REL)src/ed25519/sign.o
 
@@ -5,31 +5,184 @@
 #include "enclave.h"
 #include <crypto.h>
 #include "page.h"
+#include "ipi.h"
 #include <sbi/sbi_console.h>
+#include <sbi/riscv_atomic.h>
+#include <sbi/riscv_barrier.h>
 
-/* This will hash the loader and the runtime + eapp elf files. */
+#define SPARSE_GROUP_PAGES 64
+
+static int is_zero_page(uintptr_t page)
+{
+  const uint64_t* word = (const uint64_t*) page;
+  int i;
+
+  for (i = 0; i < RISCV_PGSIZE / sizeof(uint64_t); i++) {
+    if (word[i])
+      return 0;
+  }
+  return 1;
+}
+
+/* Extends ctx with the pages in [start, end).
+ * With SM_MEASURE_SPARSE the pages go in groups of up to
+ * SPARSE_GROUP_PAGES: a 64-bit map of the non-zero pages of the group
+ * (bit i for page i), then only those pages. Zero pages are covered by
+ * the map alone and never hashed. */
+static void hash_extend_pages(hash_ctx* ctx, uintptr_t start, uintptr_t end,
+                              unsigned long flags)
+{
+  uintptr_t group, group_end, page;
+  uint64_t map;
+  int i;
+
+  if (!(flags & SM_MEASURE_SPARSE)) {
+    for (page = start; page < end; page += RISCV_PGSIZE) {
+      hash_extend_page(ctx, (void*) page);
+    }
+    return;
+  }
+
+  for (group = start; group < end; group = group_end) {
+    group_end = group + SPARSE_GROUP_PAGES * RISCV_PGSIZE;
+    if (group_end > end)
+      group_end = end;
+
+    map = 0;
+    for (page = group, i = 0; page < group_end; page += RISCV_PGSIZE, i++) {
+      if (!is_zero_page(page))
+        map |= 1ULL << i;
+    }
+    hash_extend(ctx, (void*) &map, sizeof(map));
+
+    for (page = group, i = 0; page < group_end; page += RISCV_PGSIZE, i++) {
+      if (map & (1ULL << i))
+        hash_extend_page(ctx, (void*) page);
+    }
+  }
+}
+
+#define TREE_CHUNK_SIZE   (SM_MEASURE_TREE_CHUNK_PAGES * RISCV_PGSIZE)
+#define TREE_BATCH_LEAVES 64
+
+/* Leaf hashing job for SM_MEASURE_TREE, shared with the helper harts.
+ * Leaves are claimed by ticket; tickets only ever grow, so a helper that
+ * shows up late either gets a leaf of the batch in flight or nothing.
+ * Only one batch is in flight at a time, as hashing holds encl_lock. */
+static struct {
+  uintptr_t base;        // first page of the batch
+  uintptr_t image_end;   // end of the measured image
+  unsigned long flags;   // SM_MEASURE_* of the enclave
+  long start;            // ticket of the first leaf of the batch
+  atomic_t end;          // one past the last ticket of the batch
+  atomic_t next;         // next ticket to claim
+  atomic_t done;         // leaves hashed, over all batches
+  byte leaves[TREE_BATCH_LEAVES][MDSIZE];
+} tree_job;
+
+/* Claims and hashes one leaf; returns 0 once the batch is fully claimed */
+static int tree_hash_leaf(void)
+{
+  hash_ctx ctx;
+  uintptr_t page, last;
+  long ticket, i;
+
+  do {
+    ticket = atomic_read(&tree_job.next);
+    mb();
+    if (ticket >= atomic_read(&tree_job.end))
+      return 0;
+  } while (atomic_cmpxchg(&tree_job.next, ticket, ticket + 1) != ticket);
+  mb();
+
+  i = ticket - tree_job.start;
+  page = tree_job.base + i * TREE_CHUNK_SIZE;
+  last = page + TREE_CHUNK_SIZE;
+  if (last > tree_job.image_end)
+    last = tree_job.image_end;
+
+  hash_init(&ctx);
+  hash_extend_pages(&ctx, page, last, tree_job.flags);
+  hash_finalize(tree_job.leaves[i], &ctx);
+
+  mb();
+  atomic_add_return(&tree_job.done, 1);
+  return 1;
+}
+
+static void tree_hash_helper(void)
+{
+  while (tree_hash_leaf())
+    ;
+}
+
+/* Hashes the n leaves starting at base into tree_job.leaves, together with
+ * whichever harts answer the helper IPI */
+static void tree_hash_batch(uintptr_t base, uintptr_t image_end,
+                            unsigned long flags, long n)
+{
+  long end = atomic_read(&tree_job.end);
+
+  tree_job.start = end;
+  tree_job.base = base;
+  tree_job.image_end = image_end;
+  tree_job.flags = flags;
+  mb();
+  atomic_write(&tree_job.end, end + n);
+
+  if (n > 1)
+    sm_helper_ipi_send(tree_hash_helper);
+
+  tree_hash_helper();
+  while (atomic_read(&tree_job.done) != end + n)
+    mb();
+}
+
+/* SM_MEASURE_TREE: extends ctx with the hashes of the chunks of
+ * SM_MEASURE_TREE_CHUNK_PAGES pages in [start, end), in order. The last
+ * chunk may be shorter. Must stay in sync with measureTree() in the SDK. */
+static void hash_extend_tree(hash_ctx* ctx, uintptr_t start, uintptr_t end,
+                             unsigned long flags)
+{
+  uintptr_t chunk;
+  long n;
+
+  for (chunk = start; chunk < end; chunk += n * TREE_CHUNK_SIZE) {
+    n = (end - chunk + TREE_CHUNK_SIZE - 1) / TREE_CHUNK_SIZE;
+    if (n > TREE_BATCH_LEAVES)
+      n = TREE_BATCH_LEAVES;
+
+    tree_hash_batch(chunk, end, flags, n);
+    hash_extend(ctx, (void*) tree_job.leaves, n * MDSIZE);
+  }
+}
+
+/* This will hash the loader and the runtime + eapp elf files, in the
+ * format selected by the SM_MEASURE_* flags of the enclave. */
 static int validate_and_hash_epm(hash_ctx* ctx, struct enclave* encl)
 {
   uintptr_t loader = encl->params.dram_base; // also base
   uintptr_t runtime = encl->params.runtime_base;
   uintptr_t eapp = encl->params.user_base;
   uintptr_t free = encl->params.free_base;
+  unsigned long flags = encl->meas->flags;
+
+  // the default format has no header, see SM_MEASURE_FORMAT_TAG
+  if (flags) {
+    uint64_t header[2] = {SM_MEASURE_FORMAT_TAG | flags,
+                          SM_MEASURE_TREE_CHUNK_PAGES};
+    hash_extend(ctx, (void*) header, sizeof(header));
+  }
 
   // ensure pointers don't point to middle of correct files
   uintptr_t sizes[3] = {runtime - loader, eapp - runtime, free - eapp};
   hash_extend(ctx, (void*) sizes, sizeof(sizes));
 
-  // using pointers to ensure that they themselves are correct
-  // TODO(Evgeny): can extend by entire file instead of page at a time?
-  for (uintptr_t page = loader; page < runtime; page += RISCV_PGSIZE) {
-    hash_extend_page(ctx, (void*) page);
-  }
-  for (uintptr_t page = runtime; page < eapp; page += RISCV_PGSIZE) {
-    hash_extend_page(ctx, (void*) page);
-  }
-  for (uintptr_t page = eapp; page < free; page += RISCV_PGSIZE) {
-    hash_extend_page(ctx, (void*) page);
-  }
+  // the loader, runtime and eapp are contiguous, so hash them as one image
+  if (flags & SM_MEASURE_TREE)
+    hash_extend_tree(ctx, loader, free, flags);
+  else
+    hash_extend_pages(ctx, loader, free, flags);
   return 0;
 }
 
@@ -47,10 +200,10 @@ unsigned long validate_and_hash_enclave(struct enclave* enclave){
     return SBI_ERR_SM_ENCLAVE_ILLEGAL_PTE;
   }
 
-  hash_finalize(enclave->hash, &ctx);
-  // hash_store_ctx(&enclave->hash_ctx, &ctx);
+  hash_finalize(enclave->meas->hash, &ctx);
+  // hash_store_ctx(&enclave->meas->hash_ctx, &ctx);
   // It starts with just the EPM hash, and then extended with all the connections we make
-  hash_finalize(enclave->hash_history, &ctx);
+  hash_finalize(enclave->meas->hash_history, &ctx);
 
   return SBI_ERR_SM_ENCLAVE_SUCCESS;
 }
@@ -63,14 +216,16 @@ void add_to_hash_history(struct enclave* enc_to, struct enclave* enc_from, int c
   hash_ctx ctx;
   hash_init(&ctx);
   // hash the previous history of eid_to
-  hash_extend(&ctx, (void*)enc_to->hash_history, MDSIZE);
+  hash_extend(&ctx, (void*)enc_to->meas->hash_history, MDSIZE);
   // hash of eid_from
-  hash_extend(&ctx, (void*)enc_from->hash, MDSIZE);
+  hash_extend(&ctx, (void*)enc_from->meas->hash, MDSIZE);
   // hash the "CONNECT" string
   if (connection_type == 1)
     hash_extend(&ctx, (void*)"CONNECT", 7);
   else
     hash_extend(&ctx, (void*)"DISCONNECT", 10);
   // finalize into eid_to's hash_history
-  hash_finalize(enc_to->hash_history, &ctx);
+  hash_finalize(enc_to->meas->hash_history, &ctx);
+  // MAC keys are bound to the old history
+  enc_to->meas->mac_key_valid = 0;
 }
\ No newline at end of file
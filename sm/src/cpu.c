@@ -3,6 +3,7 @@
 // All Rights Reserved. See LICENSE for license details.
 //------------------------------------------------------------------------------
 #include "cpu.h"
+#include "mprv.h"
 #include <sbi/riscv_asm.h>
 
 #ifndef TARGET_PLATFORM_HEADER
@@ -34,3 +35,20 @@ void cpu_exit_enclave_context(void)
 {
   cpus[csr_read(mhartid)].is_enclave = 0;
 }
+
+struct sm_stats* cpu_get_stats(void)
+{
+  return &cpus[csr_read(mhartid)].stats;
+}
+
+/* copies the counters of a hart out to the caller (S-mode address) */
+unsigned long cpu_copy_stats(unsigned long hartid, uintptr_t dest)
+{
+  if (hartid >= MAX_HARTS)
+    return SBI_ERR_SM_ENCLAVE_ILLEGAL_ARGUMENT;
+
+  if (copy_from_sm(dest, &cpus[hartid].stats, sizeof(struct sm_stats)))
+    return SBI_ERR_SM_ENCLAVE_ILLEGAL_ARGUMENT;
+
+  return SBI_ERR_SM_ENCLAVE_SUCCESS;
+}
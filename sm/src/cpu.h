@@ -13,6 +13,7 @@ struct cpu_state
 {
   int is_enclave;
   enclave_id eid;
+  struct sm_stats stats;
 };
 
 /* external functions */
@@ -20,5 +21,7 @@ int cpu_is_enclave_context(void);
 int cpu_get_enclave_id(void);
 void cpu_enter_enclave_context(enclave_id eid);
 void cpu_exit_enclave_context(void);
+struct sm_stats* cpu_get_stats(void);
+unsigned long cpu_copy_stats(unsigned long hartid, uintptr_t dest);
 
 #endif
@@ -30,6 +30,11 @@ void sign(void* sign, const void* data, size_t len, const unsigned char* public_
   ed25519_sign(sign, data, len, public_key, private_key);
 }
 
+void key_exchange(byte* shared_secret, const byte* public_key, const byte* private_key)
+{
+  ed25519_key_exchange(shared_secret, public_key, private_key);
+}
+
 int kdf(const unsigned char* salt, size_t salt_len,
         const unsigned char* ikm, size_t ikm_len,
         const unsigned char* info, size_t info_len,
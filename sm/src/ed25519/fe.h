@@ -7,13 +7,24 @@
 /*
     fe means field element.
     Here the field is \Z/(2^255-19).
-    An element t, entries t[0]...t[9], represents the integer
+
+    On targets with a 128-bit integer type (RV64) an element t, entries
+    t[0]...t[4], represents the integer
+    t[0]+2^51 t[1]+2^102 t[2]+2^153 t[3]+2^204 t[4] (see fe51.c).
+    Define ED25519_REF10_FE to force the portable representation below.
+
+    Otherwise an element t, entries t[0]...t[9], represents the integer
     t[0]+2^26 t[1]+2^51 t[2]+2^77 t[3]+2^102 t[4]+...+2^230 t[9].
     Bounds on each t[i] vary depending on context.
 */
 
 
+#if defined(__SIZEOF_INT128__) && !defined(ED25519_REF10_FE)
+#define ED25519_FE51
+typedef uint64_t fe[5];
+#else
 typedef int32_t fe[10];
+#endif
 
 
 void fe_0(fe h);
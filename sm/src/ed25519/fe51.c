@@ -0,0 +1,462 @@
+#include "fixedint.h"
+#include "fe.h"
+
+#ifdef ED25519_FE51
+
+/*
+    Radix-2^51 arithmetic for 64-bit targets. An element is five unsigned
+    limbs; the products of a multiplication are accumulated in 128 bits, so
+    a multiply costs 25 word multiplications instead of 100 with the ref10
+    representation in fe.c.
+
+    Outputs of fe_mul, fe_sq, fe_sub and fe_neg have limbs below 2^51 + 2^15.
+    fe_add does not carry, so its output may be up to twice that; the curve
+    formulas in ge.c never chain more than two additions, which keeps every
+    input below 2^54 and every accumulator below 2^115.
+*/
+
+typedef unsigned __int128 uint128_t;
+
+#define MASK51 ((uint64_t) 0x7ffffffffffffULL)
+
+
+/*
+    helper functions
+*/
+static uint64_t load_8(const unsigned char *in) {
+    uint64_t result;
+
+    result = (uint64_t) in[0];
+    result |= ((uint64_t) in[1]) << 8;
+    result |= ((uint64_t) in[2]) << 16;
+    result |= ((uint64_t) in[3]) << 24;
+    result |= ((uint64_t) in[4]) << 32;
+    result |= ((uint64_t) in[5]) << 40;
+    result |= ((uint64_t) in[6]) << 48;
+    result |= ((uint64_t) in[7]) << 56;
+
+    return result;
+}
+
+static void store_8(unsigned char *out, uint64_t in) {
+    int i;
+
+    for (i = 0; i < 8; ++i) {
+        out[i] = (unsigned char) (in >> (8 * i));
+    }
+}
+
+/* one carry pass: limbs end up below 2^51 + 19 * 2^13 */
+static void fe_carry(fe h) {
+    uint64_t c;
+
+    c = h[0] >> 51; h[0] &= MASK51; h[1] += c;
+    c = h[1] >> 51; h[1] &= MASK51; h[2] += c;
+    c = h[2] >> 51; h[2] &= MASK51; h[3] += c;
+    c = h[3] >> 51; h[3] &= MASK51; h[4] += c;
+    c = h[4] >> 51; h[4] &= MASK51; h[0] += c * 19;
+}
+
+static void fe_reduce128(fe h, uint128_t r0, uint128_t r1, uint128_t r2, uint128_t r3, uint128_t r4) {
+    uint64_t c;
+
+    r1 += (uint64_t) (r0 >> 51);
+    h[0] = (uint64_t) r0 & MASK51;
+    r2 += (uint64_t) (r1 >> 51);
+    h[1] = (uint64_t) r1 & MASK51;
+    r3 += (uint64_t) (r2 >> 51);
+    h[2] = (uint64_t) r2 & MASK51;
+    r4 += (uint64_t) (r3 >> 51);
+    h[3] = (uint64_t) r3 & MASK51;
+    c = (uint64_t) (r4 >> 51);
+    h[4] = (uint64_t) r4 & MASK51;
+    h[0] += c * 19;
+    h[1] += h[0] >> 51;
+    h[0] &= MASK51;
+}
+
+
+
+/*
+    h = 0
+*/
+
+void fe_0(fe h) {
+    h[0] = 0;
+    h[1] = 0;
+    h[2] = 0;
+    h[3] = 0;
+    h[4] = 0;
+}
+
+
+
+/*
+    h = 1
+*/
+
+void fe_1(fe h) {
+    h[0] = 1;
+    h[1] = 0;
+    h[2] = 0;
+    h[3] = 0;
+    h[4] = 0;
+}
+
+
+
+/*
+    h = f + g
+    Can overlap h with f or g.
+*/
+
+void fe_add(fe h, const fe f, const fe g) {
+    h[0] = f[0] + g[0];
+    h[1] = f[1] + g[1];
+    h[2] = f[2] + g[2];
+    h[3] = f[3] + g[3];
+    h[4] = f[4] + g[4];
+}
+
+
+
+/*
+    h = f - g
+    Can overlap h with f or g.
+
+    16p is added first so no limb goes negative for inputs below 2^55.
+*/
+
+void fe_sub(fe h, const fe f, const fe g) {
+    h[0] = (f[0] + 0x7ffffffffffed0ULL) - g[0];
+    h[1] = (f[1] + 0x7ffffffffffff0ULL) - g[1];
+    h[2] = (f[2] + 0x7ffffffffffff0ULL) - g[2];
+    h[3] = (f[3] + 0x7ffffffffffff0ULL) - g[3];
+    h[4] = (f[4] + 0x7ffffffffffff0ULL) - g[4];
+    fe_carry(h);
+}
+
+
+
+/*
+    h = -f
+*/
+
+void fe_neg(fe h, const fe f) {
+    fe zero;
+
+    fe_0(zero);
+    fe_sub(h, zero, f);
+}
+
+
+
+/*
+    Replace (f,g) with (g,g) if b == 1;
+    replace (f,g) with (f,g) if b == 0.
+
+    Preconditions: b in {0,1}.
+*/
+
+void fe_cmov(fe f, const fe g, unsigned int b) {
+    uint64_t mask = (uint64_t) 0 - (uint64_t) b;
+
+    f[0] ^= mask & (f[0] ^ g[0]);
+    f[1] ^= mask & (f[1] ^ g[1]);
+    f[2] ^= mask & (f[2] ^ g[2]);
+    f[3] ^= mask & (f[3] ^ g[3]);
+    f[4] ^= mask & (f[4] ^ g[4]);
+}
+
+
+
+/*
+    Replace (f,g) with (g,f) if b == 1;
+    replace (f,g) with (f,g) if b == 0.
+
+    Preconditions: b in {0,1}.
+*/
+
+void fe_cswap(fe f, fe g, unsigned int b) {
+    uint64_t mask = (uint64_t) 0 - (uint64_t) b;
+    uint64_t x;
+    int i;
+
+    for (i = 0; i < 5; ++i) {
+        x = mask & (f[i] ^ g[i]);
+        f[i] ^= x;
+        g[i] ^= x;
+    }
+}
+
+
+
+/*
+    h = f
+*/
+
+void fe_copy(fe h, const fe f) {
+    h[0] = f[0];
+    h[1] = f[1];
+    h[2] = f[2];
+    h[3] = f[3];
+    h[4] = f[4];
+}
+
+
+
+/*
+    Ignores top bit of s.
+*/
+
+void fe_frombytes(fe h, const unsigned char *s) {
+    h[0] = load_8(s) & MASK51;
+    h[1] = (load_8(s + 6) >> 3) & MASK51;
+    h[2] = (load_8(s + 12) >> 6) & MASK51;
+    h[3] = (load_8(s + 19) >> 1) & MASK51;
+    h[4] = (load_8(s + 24) >> 12) & MASK51;
+}
+
+
+
+/*
+    Fully reduces h mod p before encoding, so the output is canonical.
+*/
+
+void fe_tobytes(unsigned char *s, const fe h) {
+    fe t;
+    uint64_t q;
+
+    fe_copy(t, h);
+    fe_carry(t);
+    fe_carry(t);
+
+    /* t < 2^255 + small, so q is 1 iff t >= p */
+    q = (t[0] + 19) >> 51;
+    q = (t[1] + q) >> 51;
+    q = (t[2] + q) >> 51;
+    q = (t[3] + q) >> 51;
+    q = (t[4] + q) >> 51;
+
+    t[0] += 19 * q;
+    t[1] += t[0] >> 51; t[0] &= MASK51;
+    t[2] += t[1] >> 51; t[1] &= MASK51;
+    t[3] += t[2] >> 51; t[2] &= MASK51;
+    t[4] += t[3] >> 51; t[3] &= MASK51;
+    t[4] &= MASK51;
+
+    store_8(s, t[0] | (t[1] << 51));
+    store_8(s + 8, (t[1] >> 13) | (t[2] << 38));
+    store_8(s + 16, (t[2] >> 26) | (t[3] << 25));
+    store_8(s + 24, (t[3] >> 39) | (t[4] << 12));
+}
+
+
+
+/*
+    return 1 if f is in {1,3,5,...,q-2}
+    return 0 if f is in {0,2,4,...,q-1}
+*/
+
+int fe_isnegative(const fe f) {
+    unsigned char s[32];
+
+    fe_tobytes(s, f);
+
+    return s[0] & 1;
+}
+
+
+
+/*
+    return 1 if f == 0
+    return 0 if f != 0
+*/
+
+int fe_isnonzero(const fe f) {
+    unsigned char s[32];
+    unsigned char r = 0;
+    int i;
+
+    fe_tobytes(s, f);
+
+    for (i = 0; i < 32; ++i) {
+        r |= s[i];
+    }
+
+    return r != 0;
+}
+
+
+
+/*
+    h = f * g
+    Can overlap h with f or g.
+
+    2^255 = 19 mod p, so limb products that land at or above 2^255 are
+    folded back in with a factor of 19.
+*/
+
+void fe_mul(fe h, const fe f, const fe g) {
+    uint64_t f0 = f[0], f1 = f[1], f2 = f[2], f3 = f[3], f4 = f[4];
+    uint64_t g0 = g[0], g1 = g[1], g2 = g[2], g3 = g[3], g4 = g[4];
+    uint64_t g1_19 = 19 * g1;
+    uint64_t g2_19 = 19 * g2;
+    uint64_t g3_19 = 19 * g3;
+    uint64_t g4_19 = 19 * g4;
+    uint128_t r0, r1, r2, r3, r4;
+
+    r0 = (uint128_t) f0 * g0 + (uint128_t) f1 * g4_19 + (uint128_t) f2 * g3_19 + (uint128_t) f3 * g2_19 + (uint128_t) f4 * g1_19;
+    r1 = (uint128_t) f0 * g1 + (uint128_t) f1 * g0    + (uint128_t) f2 * g4_19 + (uint128_t) f3 * g3_19 + (uint128_t) f4 * g2_19;
+    r2 = (uint128_t) f0 * g2 + (uint128_t) f1 * g1    + (uint128_t) f2 * g0    + (uint128_t) f3 * g4_19 + (uint128_t) f4 * g3_19;
+    r3 = (uint128_t) f0 * g3 + (uint128_t) f1 * g2    + (uint128_t) f2 * g1    + (uint128_t) f3 * g0    + (uint128_t) f4 * g4_19;
+    r4 = (uint128_t) f0 * g4 + (uint128_t) f1 * g3    + (uint128_t) f2 * g2    + (uint128_t) f3 * g1    + (uint128_t) f4 * g0;
+
+    fe_reduce128(h, r0, r1, r2, r3, r4);
+}
+
+
+
+/*
+    h = f * 121666
+    Can overlap h with f.
+*/
+
+void fe_mul121666(fe h, fe f) {
+    uint128_t r0 = (uint128_t) f[0] * 121666;
+    uint128_t r1 = (uint128_t) f[1] * 121666;
+    uint128_t r2 = (uint128_t) f[2] * 121666;
+    uint128_t r3 = (uint128_t) f[3] * 121666;
+    uint128_t r4 = (uint128_t) f[4] * 121666;
+
+    fe_reduce128(h, r0, r1, r2, r3, r4);
+}
+
+
+
+/*
+    h = f * f
+    Can overlap h with f.
+*/
+
+void fe_sq(fe h, const fe f) {
+    uint64_t f0 = f[0], f1 = f[1], f2 = f[2], f3 = f[3], f4 = f[4];
+    uint64_t f0_2 = 2 * f0;
+    uint64_t f1_2 = 2 * f1;
+    uint64_t f1_38 = 38 * f1;
+    uint64_t f2_38 = 38 * f2;
+    uint64_t f3_38 = 38 * f3;
+    uint64_t f3_19 = 19 * f3;
+    uint64_t f4_19 = 19 * f4;
+    uint128_t r0, r1, r2, r3, r4;
+
+    r0 = (uint128_t) f0 * f0   + (uint128_t) f1_38 * f4 + (uint128_t) f2_38 * f3;
+    r1 = (uint128_t) f0_2 * f1 + (uint128_t) f2_38 * f4 + (uint128_t) f3_19 * f3;
+    r2 = (uint128_t) f0_2 * f2 + (uint128_t) f1 * f1    + (uint128_t) f3_38 * f4;
+    r3 = (uint128_t) f0_2 * f3 + (uint128_t) f1_2 * f2  + (uint128_t) f4_19 * f4;
+    r4 = (uint128_t) f0_2 * f4 + (uint128_t) f1_2 * f3  + (uint128_t) f2 * f2;
+
+    fe_reduce128(h, r0, r1, r2, r3, r4);
+}
+
+
+
+/*
+    h = 2 * f * f
+    Can overlap h with f.
+*/
+
+void fe_sq2(fe h, const fe f) {
+    fe_sq(h, f);
+    h[0] <<= 1;
+    h[1] <<= 1;
+    h[2] <<= 1;
+    h[3] <<= 1;
+    h[4] <<= 1;
+}
+
+
+
+/* h = f^(2^n) */
+static void fe_sqn(fe h, const fe f, int n) {
+    int i;
+
+    fe_sq(h, f);
+
+    for (i = 1; i < n; ++i) {
+        fe_sq(h, h);
+    }
+}
+
+
+
+/*
+    out = z^(p-2) = 1/z, same addition chain as fe.c
+*/
+
+void fe_invert(fe out, const fe z) {
+    fe t0;
+    fe t1;
+    fe t2;
+    fe t3;
+
+    fe_sq(t0, z);
+    fe_sqn(t1, t0, 2);
+    fe_mul(t1, z, t1);
+    fe_mul(t0, t0, t1);
+    fe_sq(t2, t0);
+    fe_mul(t1, t1, t2);
+    fe_sqn(t2, t1, 5);
+    fe_mul(t1, t2, t1);
+    fe_sqn(t2, t1, 10);
+    fe_mul(t2, t2, t1);
+    fe_sqn(t3, t2, 20);
+    fe_mul(t2, t3, t2);
+    fe_sqn(t2, t2, 10);
+    fe_mul(t1, t2, t1);
+    fe_sqn(t2, t1, 50);
+    fe_mul(t2, t2, t1);
+    fe_sqn(t3, t2, 100);
+    fe_mul(t2, t3, t2);
+    fe_sqn(t2, t2, 50);
+    fe_mul(t1, t2, t1);
+    fe_sqn(t1, t1, 5);
+    fe_mul(out, t1, t0);
+}
+
+
+
+/*
+    out = z^((p-5)/8) = z^(2^252-3), same addition chain as fe.c
+*/
+
+void fe_pow22523(fe out, const fe z) {
+    fe t0;
+    fe t1;
+    fe t2;
+
+    fe_sq(t0, z);
+    fe_sqn(t1, t0, 2);
+    fe_mul(t1, z, t1);
+    fe_mul(t0, t0, t1);
+    fe_sq(t0, t0);
+    fe_mul(t0, t1, t0);
+    fe_sqn(t1, t0, 5);
+    fe_mul(t0, t1, t0);
+    fe_sqn(t1, t0, 10);
+    fe_mul(t1, t1, t0);
+    fe_sqn(t2, t1, 20);
+    fe_mul(t1, t2, t1);
+    fe_sqn(t1, t1, 10);
+    fe_mul(t0, t1, t0);
+    fe_sqn(t1, t0, 50);
+    fe_mul(t1, t1, t0);
+    fe_sqn(t2, t1, 100);
+    fe_mul(t1, t2, t1);
+    fe_sqn(t1, t1, 50);
+    fe_mul(t0, t1, t0);
+    fe_sqn(t0, t0, 2);
+    fe_mul(out, t0, z);
+}
+
+#endif
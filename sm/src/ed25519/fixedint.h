@@ -7,10 +7,10 @@
 typedef int                     int32_t;
 typedef unsigned int            uint32_t;
 
-#if __riscv_xlen == 64
+#if __riscv_xlen == 64 || (!defined(__riscv_xlen) && __SIZEOF_LONG__ == 8)
 typedef long                    int64_t;
 typedef unsigned long           uint64_t;
-#elif __riscv_xlen == 32
+#elif __riscv_xlen == 32 || (!defined(__riscv_xlen) && __SIZEOF_LONG__ == 4)
 typedef long long               int64_t;
 typedef unsigned long long      uint64_t;
 #else
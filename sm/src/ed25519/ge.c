@@ -1,5 +1,9 @@
 #include "ge.h"
+#ifdef ED25519_FE51
+#include "precomp_data51.h"
+#else
 #include "precomp_data.h"
+#endif
 
 
 /*
@@ -130,6 +134,15 @@ void ge_double_scalarmult_vartime(ge_p2 *r, const unsigned char *a, const ge_p3
 }
 
 
+#ifdef ED25519_FE51
+static const fe d = {
+    0x34dca135978a3ULL, 0x1a8283b156ebdULL, 0x5e7a26001c029ULL, 0x739c663a03cbbULL, 0x52036cee2b6ffULL
+};
+
+static const fe sqrtm1 = {
+    0x61b274a0ea0b0ULL, 0x0d5a5fc8f189dULL, 0x7ef5e9cbd0c60ULL, 0x78595a6804c9eULL, 0x2b8324804fc1dULL
+};
+#else
 static const fe d = {
     -10913610, 13857413, -15372611, 6949391, 114729, -8787816, -6275908, -3247719, -18696448, -12055116
 };
@@ -137,6 +150,7 @@ static const fe d = {
 static const fe sqrtm1 = {
     -32595792, -7943725, 9377950, 3500415, 12389472, -272473, -25146209, -2005654, 326686, 11406482
 };
+#endif
 
 int ge_frombytes_negate_vartime(ge_p3 *h, const unsigned char *s) {
     fe u;
@@ -295,9 +309,15 @@ void ge_p3_dbl(ge_p1p1 *r, const ge_p3 *p) {
 r = p
 */
 
+#ifdef ED25519_FE51
+static const fe d2 = {
+    0x69b9426b2f159ULL, 0x35050762add7aULL, 0x3cf44c0038052ULL, 0x6738cc7407977ULL, 0x2406d9dc56dffULL
+};
+#else
 static const fe d2 = {
     -21827239, -5839606, -30745221, 13898782, 229458, 15978800, -12551817, -6495438, 29715968, 9444199
 };
+#endif
 
 void ge_p3_to_cached(ge_cached *r, const ge_p3 *p) {
     fe_add(r->YplusX, p->Y, p->X);
@@ -346,11 +366,26 @@ static unsigned char negative(signed char b) {
     return (unsigned char) x;
 }
 
+#ifdef ED25519_FE51
+/* one masked pass over all 15 limbs; the select below runs it 9 times per
+   addition, which costs more than the addition itself as 27 fe_cmov calls */
+static void cmov(ge_precomp *t, const ge_precomp *u, unsigned char b) {
+    uint64_t mask = (uint64_t) 0 - b;
+    int i;
+
+    for (i = 0; i < 5; ++i) {
+        t->yplusx[i] ^= mask & (t->yplusx[i] ^ u->yplusx[i]);
+        t->yminusx[i] ^= mask & (t->yminusx[i] ^ u->yminusx[i]);
+        t->xy2d[i] ^= mask & (t->xy2d[i] ^ u->xy2d[i]);
+    }
+}
+#else
 static void cmov(ge_precomp *t, const ge_precomp *u, unsigned char b) {
     fe_cmov(t->yplusx, u->yplusx, b);
     fe_cmov(t->yminusx, u->yminusx, b);
     fe_cmov(t->xy2d, u->xy2d, b);
 }
+#endif
 
 
 static void select(ge_precomp *t, int pos, signed char b) {
@@ -5,15 +5,18 @@
 #include "enclave.h"
 #include "mprv.h"
 #include "pmp.h"
+#include "ipi.h"
 #include "page.h"
 #include "cpu.h"
 #include "platform-hook.h"
+#include "trace.h"
 #include <sbi/sbi_string.h>
 #include <sbi/riscv_asm.h>
 #include <sbi/riscv_locks.h>
 #include <sbi/sbi_console.h>
 
 struct enclave enclaves[ENCL_MAX];
+static struct enclave_measurement enclave_measurements[ENCL_MAX];
 
 // Enclave IDs are unsigned ints, so we do not need to check if eid is
 // greater than or equal to 0
@@ -21,6 +24,37 @@ struct enclave enclaves[ENCL_MAX];
 
 static spinlock_t encl_lock = SPIN_LOCK_INITIALIZER;
 
+/* Free eid bitmap: bit n is set iff enclaves[n] is INVALID.
+ * Protected by encl_lock. */
+#define ENCL_BITMAP_BITS   (8 * sizeof(unsigned long))
+#define ENCL_BITMAP_WORDS  ((ENCL_MAX + ENCL_BITMAP_BITS - 1) / ENCL_BITMAP_BITS)
+static unsigned long encl_free_bitmap[ENCL_BITMAP_WORDS];
+
+static inline void encl_bitmap_set(enclave_id eid)
+{
+  encl_free_bitmap[eid / ENCL_BITMAP_BITS] |= 1UL << (eid % ENCL_BITMAP_BITS);
+}
+
+static inline void encl_bitmap_clear(enclave_id eid)
+{
+  encl_free_bitmap[eid / ENCL_BITMAP_BITS] &= ~(1UL << (eid % ENCL_BITMAP_BITS));
+}
+
+/* Performance counters are accounted to both the enclave and the hart
+ * doing the work. They are plain counters: an enclave runs on one hart
+ * at a time, and the values are only used for profiling. */
+#define STATS_ADD(eid, field, val) \
+  do { \
+    enclaves[eid].stats.field += (val); \
+    cpu_get_stats()->field += (val); \
+  } while (0)
+#define STATS_INC(eid, field) STATS_ADD(eid, field, 1)
+
+static inline uint64_t stats_cycles(void)
+{
+  return csr_read(CSR_MCYCLE);
+}
+
 extern void save_host_regs(void);
 extern void restore_host_regs(void);
 extern byte dev_public_key[PUBLIC_KEY_SIZE];
@@ -42,6 +76,8 @@ extern byte dev_public_key[PUBLIC_KEY_SIZE];
 static inline void context_switch_to_enclave(struct sbi_trap_regs* regs,
                                                 enclave_id eid,
                                                 int load_parameters){
+  uint64_t start = stats_cycles();
+
   /* save host context */
   swap_prev_state(&enclaves[eid].threads[0], regs, 1);
   swap_prev_mepc(&enclaves[eid].threads[0], regs, regs->mepc);
@@ -102,11 +138,14 @@ static inline void context_switch_to_enclave(struct sbi_trap_regs* regs,
   // Setup any platform specific defenses
   platform_switch_to_enclave(&(enclaves[eid]));
   cpu_enter_enclave_context(eid);
+
+  STATS_ADD(eid, switch_to_enclave_cycles, stats_cycles() - start);
 }
 
 static inline void context_switch_to_host(struct sbi_trap_regs *regs,
     enclave_id eid,
     int return_on_resume){
+  uint64_t start = stats_cycles();
 
   // set PMP
   int memid;
@@ -147,6 +186,7 @@ static inline void context_switch_to_host(struct sbi_trap_regs *regs,
 
   cpu_exit_enclave_context();
 
+  STATS_ADD(eid, switch_to_host_cycles, stats_cycles() - start);
   return;
 }
 
@@ -161,9 +201,13 @@ void enclave_init_metadata(void){
   enclave_id eid;
   int i=0;
 
+  sbi_memset(encl_free_bitmap, 0, sizeof(encl_free_bitmap));
+
   /* Assumes eids are incrementing values, which they are for now */
   for(eid=0; eid < ENCL_MAX; eid++){
     enclaves[eid].state = INVALID;
+    enclaves[eid].meas = &enclave_measurements[eid];
+    encl_bitmap_set(eid);
 
     // Clear out regions
     for(i=0; i < ENCLAVE_REGIONS_MAX; i++){
@@ -187,20 +231,26 @@ static unsigned long clean_enclave_memory(uintptr_t utbase, uintptr_t utsize)
   return SBI_ERR_SM_ENCLAVE_SUCCESS;
 }
 
+/* Allocates the lowest free eid with find-first-set on the free bitmap,
+ * so the cost does not grow with ENCL_MAX. */
 static unsigned long encl_alloc_eid(enclave_id* _eid)
 {
-  enclave_id eid;
+  enclave_id eid = ENCL_MAX;
+  size_t i;
 
   spin_lock(&encl_lock);
 
-  for(eid=0; eid<ENCL_MAX; eid++)
+  for(i = 0; i < ENCL_BITMAP_WORDS; i++)
   {
-    if(enclaves[eid].state == INVALID){
+    if(encl_free_bitmap[i]){
+      eid = i * ENCL_BITMAP_BITS + __builtin_ctzl(encl_free_bitmap[i]);
       break;
     }
   }
-  if(eid != ENCL_MAX)
+  if(eid != ENCL_MAX) {
+    encl_bitmap_clear(eid);
     enclaves[eid].state = ALLOCATED;
+  }
 
   spin_unlock(&encl_lock);
 
@@ -217,6 +267,7 @@ static unsigned long encl_free_eid(enclave_id eid)
 {
   spin_lock(&encl_lock);
   enclaves[eid].state = INVALID;
+  encl_bitmap_set(eid);
   spin_unlock(&encl_lock);
   return SBI_ERR_SM_ENCLAVE_SUCCESS;
 }
@@ -337,10 +388,52 @@ static int is_create_args_valid(struct keystone_sbi_create_t* args)
     return 0;
   if (args->user_paddr > args->free_paddr)
     return 0;
+
+  if (args->measure_flags & ~SM_MEASURE_FLAGS_ALL)
+    return 0;
   
   return 1;
 }
 
+/* Fills in the metadata of a newly allocated enclave whose PMP regions
+ * have been set up */
+static void init_enclave_metadata(enclave_id eid, int region, int shared_region,
+                                  int sem_region, struct runtime_params_t* params)
+{
+  uintptr_t base = params->dram_base;
+  size_t semsize = params->sem_size;
+
+  enclaves[eid].eid = eid;
+
+  enclaves[eid].regions[0].pmp_rid = region;
+  enclaves[eid].regions[0].type = REGION_EPM;
+  enclaves[eid].regions[1].pmp_rid = shared_region;
+  enclaves[eid].regions[1].type = REGION_UTM;
+  if (semsize) {
+    enclaves[eid].regions[2].pmp_rid = sem_region;
+    enclaves[eid].regions[2].type = REGION_SEM;
+  }
+
+  // mark regions as not shared(for now. they're shared after initialized/connected)
+  enclaves[eid].regions_shared[0] = 0;
+  enclaves[eid].regions_shared[1] = 0;
+  if (semsize) enclaves[eid].regions_shared[2] = 0;
+
+  enclaves[eid].connector[0].valid = FALSE;
+#if __riscv_xlen == 32
+  enclaves[eid].encl_satp = ((base >> RISCV_PGSHIFT) | (SATP_MODE_SV32 << HGATP_MODE_SHIFT));
+#else
+  enclaves[eid].encl_satp = ((base >> RISCV_PGSHIFT) | (SATP_MODE_SV39 << HGATP_MODE_SHIFT));
+#endif
+  enclaves[eid].n_thread = 0;
+  enclaves[eid].params = *params;
+  enclaves[eid].meas->mac_key_valid = 0;
+  sbi_memset(&enclaves[eid].stats, 0, sizeof(struct sm_stats));
+
+  /* Init enclave state (regs etc) */
+  clean_state(&enclaves[eid].threads[0]);
+}
+
 /*********************************
  *
  * Enclave SBI functions
@@ -417,34 +510,8 @@ unsigned long create_enclave(unsigned long *eidptr, struct keystone_sbi_create_t
 
 
   // initialize enclave metadata
-  enclaves[eid].eid = eid;
-
-  enclaves[eid].regions[0].pmp_rid = region;
-  enclaves[eid].regions[0].type = REGION_EPM;
-  enclaves[eid].regions[1].pmp_rid = shared_region;
-  enclaves[eid].regions[1].type = REGION_UTM;
-  if (semsize) {
-    enclaves[eid].regions[2].pmp_rid = sem_region;
-    enclaves[eid].regions[2].type = REGION_SEM;
-  }
-  
-
-  // mark regions as not shared(for now. they're shared after initialized/connected)
-  enclaves[eid].regions_shared[0] = 0;
-  enclaves[eid].regions_shared[1] = 0;
-  if (semsize) enclaves[eid].regions_shared[2] = 0;
-
-  enclaves[eid].connector[0].valid = FALSE;
-#if __riscv_xlen == 32
-  enclaves[eid].encl_satp = ((base >> RISCV_PGSHIFT) | (SATP_MODE_SV32 << HGATP_MODE_SHIFT));
-#else
-  enclaves[eid].encl_satp = ((base >> RISCV_PGSHIFT) | (SATP_MODE_SV39 << HGATP_MODE_SHIFT));
-#endif
-  enclaves[eid].n_thread = 0;
-  enclaves[eid].params = params;
-
-  /* Init enclave state (regs etc) */
-  clean_state(&enclaves[eid].threads[0]);
+  init_enclave_metadata(eid, region, shared_region, sem_region, &params);
+  enclaves[eid].meas->flags = create_args.measure_flags;
 
   /* Platform create happens as the last thing before hashing/etc since
      it may modify the enclave struct */
@@ -455,7 +522,9 @@ unsigned long create_enclave(unsigned long *eidptr, struct keystone_sbi_create_t
   /* Validate memory, prepare hash and signature for attestation */
   spin_lock(&encl_lock); // FIXME This should error for second enter.
  
+  uint64_t hash_start = stats_cycles();
   ret = validate_and_hash_enclave(&enclaves[eid]);
+  STATS_ADD(eid, hash_cycles, stats_cycles() - hash_start);
   /* The enclave is fresh if it has been validated and hashed but not run yet. */
   if (ret)
     goto unlock;
@@ -465,6 +534,8 @@ unsigned long create_enclave(unsigned long *eidptr, struct keystone_sbi_create_t
   *eidptr = eid;
 
   spin_unlock(&encl_lock);
+
+  sm_trace(SM_TRACE_CREATE, eid, size);
   return SBI_ERR_SM_ENCLAVE_SUCCESS;
 
 unlock:
@@ -483,6 +554,131 @@ error:
   return ret;
 }
 
+/* A clone must start from the state right after create_enclave: never run
+ * and never connected, as connections are folded into hash_history.
+ * Must be called with encl_lock held. */
+static int is_enclave_cloneable(enclave_id eid)
+{
+  return ENCLAVE_EXISTS(eid) && enclaves[eid].state == FRESH &&
+         !enclaves[eid].connector[0].valid && !enclaves[eid].regions_shared[2];
+}
+
+/* This creates a new enclave as a copy of a FRESH enclave.
+ *
+ * Only the memory regions of create_args are used; the layout of the source
+ * EPM is kept and rebased onto the new EPM. The measured part of the EPM is
+ * copied in M-mode and the measurement of the source is inherited instead of
+ * being recomputed, since the hashed contents are position independent.
+ */
+unsigned long clone_enclave(unsigned long *eidptr, enclave_id src_eid,
+                            struct keystone_sbi_create_t create_args)
+{
+  uintptr_t base = create_args.epm_region.paddr;
+  size_t size = create_args.epm_region.size;
+  uintptr_t utbase = create_args.utm_region.paddr;
+  size_t utsize = create_args.utm_region.size;
+  uintptr_t sembase = create_args.sem_region.paddr;
+  size_t semsize = create_args.sem_region.size;
+
+  struct runtime_params_t params;
+  uintptr_t src_base;
+  enclave_id eid;
+  unsigned long ret;
+  int region, shared_region, sem_region = -1;
+
+  spin_lock(&encl_lock);
+  if (!is_enclave_cloneable(src_eid)) {
+    spin_unlock(&encl_lock);
+    return SBI_ERR_SM_ENCLAVE_NOT_FRESH;
+  }
+  params = enclaves[src_eid].params;
+  spin_unlock(&encl_lock);
+
+  /* rebase the source layout onto the new EPM */
+  src_base = params.dram_base;
+  create_args.runtime_paddr = base + (params.runtime_base - src_base);
+  create_args.user_paddr = base + (params.user_base - src_base);
+  create_args.free_paddr = base + (params.free_base - src_base);
+  create_args.free_requested = params.free_requested;
+
+  if (size < params.dram_size || !is_create_args_valid(&create_args))
+    return SBI_ERR_SM_ENCLAVE_ILLEGAL_ARGUMENT;
+
+  params.dram_base = base;
+  params.dram_size = size;
+  params.runtime_base = create_args.runtime_paddr;
+  params.user_base = create_args.user_paddr;
+  params.free_base = create_args.free_paddr;
+  params.untrusted_base = utbase;
+  params.untrusted_size = utsize;
+  params.sem_base = sembase;
+  params.sem_size = semsize;
+
+  ret = SBI_ERR_SM_ENCLAVE_NO_FREE_RESOURCE;
+  if (encl_alloc_eid(&eid) != SBI_ERR_SM_ENCLAVE_SUCCESS)
+    goto error;
+
+  ret = SBI_ERR_SM_ENCLAVE_PMP_FAILURE;
+  if(pmp_region_init_atomic(base, size, PMP_PRI_ANY, &region, 0))
+    goto free_encl_idx;
+
+  if(pmp_region_init_atomic(utbase, utsize, PMP_PRI_BOTTOM, &shared_region, 0))
+    goto free_region;
+
+  if(semsize && pmp_region_init_atomic(sembase, semsize, PMP_PRI_ANY, &sem_region, 0))
+    goto free_shared_region;
+
+  if(pmp_set_global(region, PMP_NO_PERM))
+    goto free_sem_region;
+
+  clean_enclave_memory(utbase, utsize);
+  if (semsize) clean_enclave_memory(sembase, semsize);
+
+  init_enclave_metadata(eid, region, shared_region, sem_region, &params);
+
+  ret = platform_create_enclave(&enclaves[eid]);
+  if (ret)
+    goto unset_region;
+
+  spin_lock(&encl_lock);
+
+  /* the source may have been run or destroyed in the meantime */
+  ret = SBI_ERR_SM_ENCLAVE_NOT_FRESH;
+  if (!is_enclave_cloneable(src_eid) ||
+      enclaves[src_eid].params.dram_base != src_base)
+    goto unlock;
+
+  sbi_memcpy((void*) base, (void*) src_base, params.free_base - base);
+  sbi_memcpy(enclaves[eid].meas->hash, enclaves[src_eid].meas->hash, MDSIZE);
+  sbi_memcpy(enclaves[eid].meas->hash_history, enclaves[src_eid].meas->hash_history, MDSIZE);
+  enclaves[eid].meas->flags = enclaves[src_eid].meas->flags;
+
+  enclaves[eid].state = FRESH;
+  *eidptr = eid;
+
+  spin_unlock(&encl_lock);
+
+  sm_trace(SM_TRACE_CLONE, eid, src_eid);
+  return SBI_ERR_SM_ENCLAVE_SUCCESS;
+
+unlock:
+  spin_unlock(&encl_lock);
+  platform_destroy_enclave(&enclaves[eid]);
+unset_region:
+  pmp_unset_global(region);
+free_sem_region:
+  if (semsize)
+    pmp_region_free_atomic(sem_region);
+free_shared_region:
+  pmp_region_free_atomic(shared_region);
+free_region:
+  pmp_region_free_atomic(region);
+free_encl_idx:
+  encl_free_eid(eid);
+error:
+  return ret;
+}
+
 /*
  * Fully destroys an enclave
  * Deallocates EID, clears epm, etc
@@ -504,6 +700,9 @@ unsigned long destroy_enclave(enclave_id eid)
   if(!destroyable)
     return SBI_ERR_SM_ENCLAVE_NOT_DESTROYABLE;
 
+  sm_trace(SM_TRACE_DESTROY, eid, 0);
+
+  uint64_t start = stats_cycles();
 
   // 0. Let the platform specifics do cleanup/modifications
   platform_destroy_enclave(&enclaves[eid]);
@@ -518,6 +717,7 @@ unsigned long destroy_enclave(enclave_id eid)
   void* base;
   size_t size;
   region_id rid;
+  pmp_ipi_batch_begin();
   for(i = 0; i < ENCLAVE_REGIONS_MAX; i++){
     if(enclaves[eid].regions[i].type == REGION_INVALID ||
        enclaves[eid].regions[i].type == REGION_UTM ||
@@ -529,9 +729,19 @@ unsigned long destroy_enclave(enclave_id eid)
     size = (size_t) pmp_region_get_size(rid);
     sbi_memset((void*) base, 0, size);
 
-    //1.b free pmp region
+    //1.b unset pmp region on every hart (queued)
     pmp_unset_global(rid);
-    pmp_region_free_atomic(rid);
+  }
+  pmp_ipi_batch_flush();
+
+  //1.c free pmp regions only after all harts dropped them, as a freed
+  //    index may be handed out to another enclave right away
+  for(i = 0; i < ENCLAVE_REGIONS_MAX; i++){
+    if(enclaves[eid].regions[i].type == REGION_INVALID ||
+       enclaves[eid].regions[i].type == REGION_UTM ||
+       enclaves[eid].regions[i].type == REGION_CON)
+      continue;
+    pmp_region_free_atomic(enclaves[eid].regions[i].pmp_rid);
   }
 
   // 2. free pmp region for UTM
@@ -548,6 +758,9 @@ unsigned long destroy_enclave(enclave_id eid)
 
   // NOTE: Connected pages are not freed here. They should live until all connected enclaves are destroyed.
 
+  // the enclave's own counters go away with it, so only the hart keeps this
+  cpu_get_stats()->destroy_cycles += stats_cycles() - start;
+
   // 3. release eid
   encl_free_eid(eid);
 
@@ -571,6 +784,9 @@ unsigned long run_enclave(struct sbi_trap_regs *regs, enclave_id eid)
     return SBI_ERR_SM_ENCLAVE_NOT_FRESH;
   }
 
+  STATS_INC(eid, run);
+  sm_trace(SM_TRACE_RUN, eid, 0);
+
   // Enclave is OK to run, context switch to it
   context_switch_to_enclave(regs, eid, 1);
 
@@ -593,6 +809,9 @@ unsigned long exit_enclave(struct sbi_trap_regs *regs, enclave_id eid)
   if(!exitable)
     return SBI_ERR_SM_ENCLAVE_NOT_RUNNING;
 
+  STATS_INC(eid, exit);
+  // a0 still holds the return value passed by the enclave
+  sm_trace(SM_TRACE_EXIT, eid, regs->a0);
   context_switch_to_host(regs, eid, 0);
 
   return SBI_ERR_SM_ENCLAVE_SUCCESS;
@@ -614,12 +833,15 @@ unsigned long stop_enclave(struct sbi_trap_regs *regs, uint64_t request, enclave
   if(!stoppable)
     return SBI_ERR_SM_ENCLAVE_NOT_RUNNING;
 
+  sm_trace(SM_TRACE_STOP, eid, request);
   context_switch_to_host(regs, eid, request == STOP_EDGE_CALL_HOST);
 
   switch(request) {
     case(STOP_TIMER_INTERRUPT):
+      STATS_INC(eid, stop_interrupt);
       return SBI_ERR_SM_ENCLAVE_INTERRUPTED;
     case(STOP_EDGE_CALL_HOST):
+      STATS_INC(eid, stop_edge_call);
       return SBI_ERR_SM_ENCLAVE_EDGE_CALL_HOST;
     default:
       return SBI_ERR_SM_ENCLAVE_UNKNOWN_ERROR;
@@ -644,12 +866,38 @@ unsigned long resume_enclave(struct sbi_trap_regs *regs, enclave_id eid)
   }
   spin_unlock(&encl_lock);
 
+  STATS_INC(eid, resume);
+  sm_trace(SM_TRACE_RESUME, eid, 0);
+
   // Enclave is OK to resume, context switch to it
   context_switch_to_enclave(regs, eid, 0);
 
   return SBI_ERR_SM_ENCLAVE_SUCCESS;
 }
 
+/* Streams the enclave's log through a small buffer, so the log can be
+ * any size and only its digest ends up in the report */
+static unsigned long hash_enclave_log(byte* digest, uintptr_t log_ptr, uintptr_t log_size)
+{
+  uintptr_t chunk[ATTEST_LOG_CHUNK / sizeof(uintptr_t)];
+  hash_ctx ctx;
+
+  hash_init(&ctx);
+  while (log_size > 0) {
+    size_t len = log_size < sizeof(chunk) ? log_size : sizeof(chunk);
+
+    if (copy_to_sm(chunk, log_ptr, len))
+      return SBI_ERR_SM_ENCLAVE_NOT_ACCESSIBLE;
+
+    hash_extend(&ctx, chunk, len);
+    log_ptr += len;
+    log_size -= len;
+  }
+  hash_finalize(digest, &ctx);
+
+  return SBI_ERR_SM_ENCLAVE_SUCCESS;
+}
+
 unsigned long attest_enclave(uintptr_t report_ptr, uintptr_t data, uintptr_t size, uintptr_t log_ptr, uintptr_t log_size, enclave_id eid)
 {
   int attestable;
@@ -659,9 +907,13 @@ unsigned long attest_enclave(uintptr_t report_ptr, uintptr_t data, uintptr_t siz
   if (size > ATTEST_DATA_MAXLEN)
     return SBI_ERR_SM_ENCLAVE_ILLEGAL_ARGUMENT;
 
-  if (log_size > ATTEST_DATA_MAXLEN)
+  if (log_ptr + log_size < log_ptr)
     return SBI_ERR_SM_ENCLAVE_ILLEGAL_ARGUMENT;
 
+  /* The signature covers all of data[], so keep the unused tail zeroed:
+   * compact reports drop it, and stack contents must not leak out */
+  sbi_memset(&report, 0, sizeof(report));
+
   spin_lock(&encl_lock);
   attestable = (ENCLAVE_EXISTS(eid)
                 && (enclaves[eid].state >= FRESH));
@@ -681,32 +933,29 @@ unsigned long attest_enclave(uintptr_t report_ptr, uintptr_t data, uintptr_t siz
     goto err_unlock;
   }
 
-  if (log_size > 0) {
-    ret = copy_enclave_data(&enclaves[eid], report.enclave.log, // FIXME: add this field
-        log_ptr, log_size);
-    report.enclave.log_len = log_size;
+  spin_unlock(&encl_lock); // Don't need to wait while hashing the log or signing, which might take some time
 
-    if (ret) {
-      ret = SBI_ERR_SM_ENCLAVE_NOT_ACCESSIBLE;
-      goto err_unlock;
-    }
-  } else {
-    report.enclave.log_len = 0;
-  }
+  /* the caller is this enclave, running on this hart, so it stays alive */
+  ret = hash_enclave_log(report.enclave.log_hash, log_ptr, log_size);
+  report.enclave.log_len = log_size;
+
+  if (ret)
+    return ret;
 
-  spin_unlock(&encl_lock); // Don't need to wait while signing, which might take some time
+  sm_trace(SM_TRACE_ATTEST, eid, 0);
 
   sbi_memcpy(report.dev_public_key, dev_public_key, PUBLIC_KEY_SIZE);
   sbi_memcpy(report.sm.hash, sm_hash, MDSIZE);
   sbi_memcpy(report.sm.public_key, sm_public_key, PUBLIC_KEY_SIZE);
   sbi_memcpy(report.sm.signature, sm_signature, SIGNATURE_SIZE);
-  // sbi_memcpy(report.enclave.hash, enclaves[eid].hash, MDSIZE);
-  sbi_memcpy(report.enclave.hash, enclaves[eid].hash_history, MDSIZE);
+  // sbi_memcpy(report.enclave.hash, enclaves[eid].meas->hash, MDSIZE);
+  sbi_memcpy(report.enclave.hash, enclaves[eid].meas->hash_history, MDSIZE);
+  uint64_t sign_start = stats_cycles();
   sm_sign(report.enclave.signature,
       &report.enclave,
       sizeof(struct enclave_report)
-      - SIGNATURE_SIZE
-      - ATTEST_DATA_MAXLEN + log_size);
+      - SIGNATURE_SIZE);
+  STATS_ADD(eid, sign_cycles, stats_cycles() - sign_start);
 
   spin_lock(&encl_lock);
 
@@ -727,6 +976,76 @@ err_unlock:
   return ret;
 }
 
+/* Binds data to the enclave with a MAC instead of a signature.
+ * The key is shared with a single verifier, the owner of peer_public_key,
+ * through the SM key that the verifier trusts from any one signed report;
+ * see sm_derive_attestation_key(). Deriving it costs a key exchange, so
+ * the last one is kept until the enclave hash changes, and answering a
+ * challenge after that is a single SHA3. */
+unsigned long attest_enclave_mac(uintptr_t tag_ptr, uintptr_t data, uintptr_t size,
+                                 uintptr_t peer_ptr, enclave_id eid)
+{
+  byte peer[PUBLIC_KEY_SIZE];
+  byte hash[MDSIZE];
+  byte key[MDSIZE];
+  byte tag[ATTEST_MAC_SIZE];
+  byte buf[ATTEST_DATA_MAXLEN];
+  hash_ctx ctx;
+  int ret;
+
+  if (size > ATTEST_DATA_MAXLEN)
+    return SBI_ERR_SM_ENCLAVE_ILLEGAL_ARGUMENT;
+
+  spin_lock(&encl_lock);
+  if (!ENCLAVE_EXISTS(eid) || enclaves[eid].state < FRESH) {
+    ret = SBI_ERR_SM_ENCLAVE_NOT_INITIALIZED;
+    goto err_unlock;
+  }
+
+  if (copy_enclave_data(&enclaves[eid], buf, data, size) ||
+      copy_enclave_data(&enclaves[eid], peer, peer_ptr, PUBLIC_KEY_SIZE)) {
+    ret = SBI_ERR_SM_ENCLAVE_NOT_ACCESSIBLE;
+    goto err_unlock;
+  }
+
+  if (!enclaves[eid].meas->mac_key_valid ||
+      sbi_memcmp(enclaves[eid].meas->mac_peer, peer, PUBLIC_KEY_SIZE)) {
+    sbi_memcpy(hash, enclaves[eid].meas->hash_history, MDSIZE);
+    spin_unlock(&encl_lock); // the key exchange takes a while, like signing
+
+    sm_derive_attestation_key(key, peer, hash);
+
+    spin_lock(&encl_lock);
+    /* only cache it if the enclave did not change in the meantime */
+    if (ENCLAVE_EXISTS(eid) &&
+        !sbi_memcmp(enclaves[eid].meas->hash_history, hash, MDSIZE)) {
+      sbi_memcpy(enclaves[eid].meas->mac_peer, peer, PUBLIC_KEY_SIZE);
+      sbi_memcpy(enclaves[eid].meas->mac_key, key, MDSIZE);
+      enclaves[eid].meas->mac_key_valid = 1;
+    }
+  } else {
+    sbi_memcpy(key, enclaves[eid].meas->mac_key, MDSIZE);
+  }
+  spin_unlock(&encl_lock);
+
+  sm_trace(SM_TRACE_ATTEST, eid, 1);
+
+  hash_init(&ctx);
+  hash_extend(&ctx, key, MDSIZE);
+  hash_extend(&ctx, buf, size);
+  hash_finalize(tag, &ctx);
+  sbi_memset(key, 0, MDSIZE);
+
+  if (copy_from_sm(tag_ptr, tag, ATTEST_MAC_SIZE))
+    return SBI_ERR_SM_ENCLAVE_ILLEGAL_ARGUMENT;
+
+  return SBI_ERR_SM_ENCLAVE_SUCCESS;
+
+err_unlock:
+  spin_unlock(&encl_lock);
+  return ret;
+}
+
 unsigned long get_sealing_key(uintptr_t sealing_key, uintptr_t key_ident,
                                  size_t key_ident_size, enclave_id eid)
 {
@@ -736,13 +1055,34 @@ unsigned long get_sealing_key(uintptr_t sealing_key, uintptr_t key_ident,
   /* derive key */
   ret = sm_derive_sealing_key((unsigned char *)key_struct->key,
                               (const unsigned char *)key_ident, key_ident_size,
-                              (const unsigned char *)enclaves[eid].hash);
+                              (const unsigned char *)enclaves[eid].meas->hash);
   if (ret)
     return SBI_ERR_SM_ENCLAVE_UNKNOWN_ERROR;
 
   /* sign derived key */
+  uint64_t sign_start = stats_cycles();
   sm_sign((void *)key_struct->signature, (void *)key_struct->key,
           SEALING_KEY_SIZE);
+  STATS_ADD(eid, sign_cycles, stats_cycles() - sign_start);
+
+  return SBI_ERR_SM_ENCLAVE_SUCCESS;
+}
+
+/* Copies the performance counters of an enclave out to the caller */
+unsigned long get_enclave_stats(enclave_id eid, uintptr_t dest)
+{
+  struct sm_stats stats;
+
+  spin_lock(&encl_lock);
+  if(!ENCLAVE_EXISTS(eid)) {
+    spin_unlock(&encl_lock);
+    return SBI_ERR_SM_ENCLAVE_INVALID_ID;
+  }
+  stats = enclaves[eid].stats;
+  spin_unlock(&encl_lock);
+
+  if(copy_from_sm(dest, &stats, sizeof(struct sm_stats)))
+    return SBI_ERR_SM_ENCLAVE_ILLEGAL_ARGUMENT;
 
   return SBI_ERR_SM_ENCLAVE_SUCCESS;
 }
@@ -799,6 +1139,8 @@ unsigned long connect_enclaves(enclave_id eid1, enclave_id eid2)
   // TODO: disable interrupts
   spin_unlock(&encl_lock);
 
+  sm_trace(SM_TRACE_CONNECT, eid1, eid2);
+
   // printm("successfully connected enclaves\r\n");
   return SBI_ERR_SM_ENCLAVE_SUCCESS;
 }
@@ -18,6 +18,7 @@
 #include TARGET_PLATFORM_HEADER
 
 #define ATTEST_DATA_MAXLEN  1024
+#define ATTEST_LOG_CHUNK    256
 #define ENCLAVE_SHARED_MAX 1
 /* TODO: does not support multithreaded enclave yet */
 #define MAX_ENCL_THREADS 1
@@ -69,6 +70,23 @@ struct shared_mem_connector
   bool valid;
 };
 
+/* measurement and attestation metadata
+ * Only touched on create/attest/connect, so it is kept out of
+ * struct enclave to keep the context switch path cache-friendly.
+ */
+struct enclave_measurement
+{
+  byte hash[MDSIZE];
+  byte hash_history[MDSIZE];  // This is the record of all connection histories, chained into a single hash
+  byte sign[SIGNATURE_SIZE];  // Comment out to not do the signing/verification
+  unsigned long flags;        // SM_MEASURE_* format of hash
+  /* last key derived by attest_enclave_mac(), for mac_peer */
+  int mac_key_valid;
+  byte mac_peer[PUBLIC_KEY_SIZE];
+  byte mac_key[MDSIZE];
+  // sha3_ctx_t hash_ctx;  // incremental hash context
+};
+
 /* enclave metadata */
 struct enclave
 {
@@ -84,15 +102,15 @@ struct enclave
   /* Shared enclave memory connectors */
   struct shared_mem_connector connector[ENCLAVE_SHARED_MAX];
 
-  /* measurement */
-  byte hash[MDSIZE];
-  byte hash_history[MDSIZE];  // This is the record of all connection histories, chained into a single hash
-  byte sign[SIGNATURE_SIZE];  // Comment out to not do the signing/verification
-  // sha3_ctx_t hash_ctx;  // incremental hash context
+  /* measurement (cold, see struct enclave_measurement) */
+  struct enclave_measurement* meas;
 
   /* parameters */
   struct runtime_params_t params;
 
+  /* performance counters */
+  struct sm_stats stats;
+
   /* enclave execution context */
   unsigned int n_thread;
   struct thread_state threads[MAX_ENCL_THREADS];
@@ -107,7 +125,7 @@ struct enclave_report
   uint64_t data_len;
   uint64_t log_len;
   byte data[ATTEST_DATA_MAXLEN];
-  byte log[ATTEST_DATA_MAXLEN];
+  byte log_hash[MDSIZE];  // SHA3-512 of the log_len bytes of log
   byte signature[SIGNATURE_SIZE];
 };
 struct sm_report
@@ -122,6 +140,8 @@ struct report
   struct sm_report sm;
   byte dev_public_key[PUBLIC_KEY_SIZE];
 };
+_Static_assert(sizeof(struct report) == ATTEST_REPORT_SIZE,
+               "struct report does not match ATTEST_REPORT_SIZE");
 
 /* sealing key structure */
 #define SEALING_KEY_SIZE 128
@@ -134,6 +154,7 @@ struct sealing_key
 /*** SBI functions & external functions ***/
 // callables from the host
 unsigned long create_enclave(unsigned long *eid, struct keystone_sbi_create_t create_args);
+unsigned long clone_enclave(unsigned long *eid, enclave_id src_eid, struct keystone_sbi_create_t create_args);
 unsigned long destroy_enclave(enclave_id eid);
 unsigned long run_enclave(struct sbi_trap_regs *regs, enclave_id eid);
 unsigned long resume_enclave(struct sbi_trap_regs *regs, enclave_id eid);
@@ -145,6 +166,7 @@ unsigned long async_disconnect_enclaves(enclave_id eid1, enclave_id eid2);
 unsigned long exit_enclave(struct sbi_trap_regs *regs, enclave_id eid);
 unsigned long stop_enclave(struct sbi_trap_regs *regs, uint64_t request, enclave_id eid);
 unsigned long attest_enclave(uintptr_t report, uintptr_t data, uintptr_t size, uintptr_t log_ptr, uintptr_t log_size, enclave_id eid);
+unsigned long attest_enclave_mac(uintptr_t tag, uintptr_t data, uintptr_t size, uintptr_t peer_public_key, enclave_id eid);
 // attestation
 unsigned long validate_and_hash_enclave(struct enclave* enclave);
 void add_to_hash_history(struct enclave* enc_to, struct enclave* enc_from, int connection_type);
@@ -155,6 +177,7 @@ int get_enclave_region_index(enclave_id eid, enum enclave_region_type type);
 uintptr_t get_enclave_region_base(enclave_id eid, int memid);
 uintptr_t get_enclave_region_size(enclave_id eid, int memid);
 unsigned long get_sealing_key(uintptr_t seal_key, uintptr_t key_ident, size_t key_ident_size, enclave_id eid);
+unsigned long get_enclave_stats(enclave_id eid, uintptr_t dest);
 // interrupt handlers
 void sbi_trap_handler_keystone_enclave(struct sbi_trap_regs *regs);
 #endif
@@ -5,28 +5,147 @@
 #include <sbi/sbi_console.h>
 #include <sbi/sbi_hsm.h>
 #include <sbi/sbi_domain.h>
+#include <sbi/riscv_barrier.h>
 #include "ipi.h"
 #include "pmp.h"
+#include "trace.h"
+
+#ifndef TARGET_PLATFORM_HEADER
+#error "SM requires a defined platform to build"
+#endif
+
+// Special target platform header, set by configure script
+#include TARGET_PLATFORM_HEADER
+
+/* Pending updates of each hart; only touched by the owning hart, and by the
+ * others while it waits for the IPI round to complete */
+static struct pmp_ipi_batch batches[MAX_HARTS];
+static int batching[MAX_HARTS];
+
+static void pmp_ipi_apply(int type, int rid, uint8_t perm)
+{
+  if (type == SBI_PMP_IPI_TYPE_SET) {
+    pmp_set_keystone(rid, perm);
+  } else {
+    pmp_unset(rid);
+  }
+}
 
 void sbi_pmp_ipi_local_update(struct sbi_tlb_info *__info)
 {
   struct sbi_pmp_ipi_info* info = (struct sbi_pmp_ipi_info *) __info;
-  if (info->type == SBI_PMP_IPI_TYPE_SET) {
-    pmp_set_keystone(info->rid, (uint8_t) info->perm);
+  struct pmp_ipi_batch* batch;
+  unsigned int i;
+
+  if (info->type == SBI_PMP_IPI_TYPE_BATCH) {
+    batch = (struct pmp_ipi_batch *) info->rid;
+    for (i = 0; i < batch->count; i++)
+      pmp_ipi_apply(batch->updates[i].type, batch->updates[i].rid,
+                    batch->updates[i].perm);
   } else {
-    pmp_unset(info->rid);
+    pmp_ipi_apply(info->type, info->rid, (uint8_t) info->perm);
   }
 }
 
-void send_and_sync_pmp_ipi(int region_idx, int type, uint8_t perm)
+static void pmp_ipi_request(unsigned long type, unsigned long rid, uint8_t perm)
 {
   ulong mask = 0;
   ulong source_hart = current_hartid();
   struct sbi_tlb_info tlb_info;
   sbi_hsm_hart_interruptible_mask(sbi_domain_thishart_ptr(), 0, &mask);
+  sm_trace(SM_TRACE_IPI, SM_TRACE_NO_EID, mask);
 
-  SBI_TLB_INFO_INIT(&tlb_info, type, 0, region_idx, perm,
+  SBI_TLB_INFO_INIT(&tlb_info, type, 0, rid, perm,
       sbi_pmp_ipi_local_update, source_hart);
   sbi_tlb_request(mask, 0, &tlb_info);
 }
 
+static void pmp_ipi_send_batch(struct pmp_ipi_batch* batch)
+{
+  if (batch->count == 0)
+    return;
+
+  /* sbi_tlb_request waits for every target, so the batch may live here */
+  pmp_ipi_request(SBI_PMP_IPI_TYPE_BATCH, (unsigned long) batch, 0);
+  batch->count = 0;
+}
+
+void send_and_sync_pmp_ipi(int region_idx, int type, uint8_t perm)
+{
+  ulong hartid = current_hartid();
+  struct pmp_ipi_batch* batch = &batches[hartid];
+
+  if (!batching[hartid]) {
+    pmp_ipi_request(type, region_idx, perm);
+    return;
+  }
+
+  if (batch->count == PMP_IPI_BATCH_MAX)
+    pmp_ipi_send_batch(batch);
+
+  batch->updates[batch->count].rid = region_idx;
+  batch->updates[batch->count].type = type;
+  batch->updates[batch->count].perm = perm;
+  batch->count++;
+}
+
+void pmp_ipi_batch_begin(void)
+{
+  ulong hartid = current_hartid();
+
+  batches[hartid].count = 0;
+  batching[hartid] = 1;
+}
+
+void pmp_ipi_batch_flush(void)
+{
+  ulong hartid = current_hartid();
+
+  pmp_ipi_send_batch(&batches[hartid]);
+  batching[hartid] = 0;
+}
+
+static u32 helper_event = SBI_IPI_EVENT_MAX;
+static sm_helper_fn helper_fn;
+
+static void sm_helper_ipi_process(struct sbi_scratch *scratch)
+{
+  sm_helper_fn fn = helper_fn;
+
+  if (fn)
+    fn();
+}
+
+static struct sbi_ipi_event_ops sm_helper_ipi_ops = {
+  .name = "IPI_SM_HELPER",
+  .process = sm_helper_ipi_process,
+};
+
+int sm_helper_ipi_init(void)
+{
+  int ret = sbi_ipi_event_create(&sm_helper_ipi_ops);
+
+  if (ret < 0)
+    return ret;
+
+  helper_event = ret;
+  return 0;
+}
+
+void sm_helper_ipi_send(sm_helper_fn fn)
+{
+  ulong mask = 0;
+
+  if (helper_event == SBI_IPI_EVENT_MAX)
+    return;
+
+  sbi_hsm_hart_interruptible_mask(sbi_domain_thishart_ptr(), 0, &mask);
+  mask &= ~(1UL << current_hartid());
+  if (!mask)
+    return;
+
+  helper_fn = fn;
+  mb();
+  sm_trace(SM_TRACE_IPI, SM_TRACE_NO_EID, mask);
+  sbi_ipi_send_many(mask, 0, helper_event, NULL);
+}
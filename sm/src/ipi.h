@@ -7,6 +7,10 @@
 
 #define SBI_PMP_IPI_TYPE_SET    0
 #define SBI_PMP_IPI_TYPE_UNSET  1
+#define SBI_PMP_IPI_TYPE_BATCH  2
+
+/* Maximum number of PMP updates carried by one batched IPI */
+#define PMP_IPI_BATCH_MAX       8
 
 struct sbi_pmp_ipi_info {
   unsigned long type;
@@ -15,6 +19,18 @@ struct sbi_pmp_ipi_info {
   unsigned long perm;
 };
 
+/* For SBI_PMP_IPI_TYPE_BATCH, rid holds the address of a pmp_ipi_batch */
+struct pmp_ipi_update {
+  int rid;
+  int type;
+  uint8_t perm;
+};
+
+struct pmp_ipi_batch {
+  unsigned int count;
+  struct pmp_ipi_update updates[PMP_IPI_BATCH_MAX];
+};
+
 void sbi_pmp_ipi_local_update(struct sbi_tlb_info *info);
 
 #define SBI_PMP_IPI_INFO_SIZE sizeof(struct sbi_pmp_ipi_info)
@@ -24,4 +40,16 @@ int sbi_pmp_ipi_init(struct sbi_scratch* scratch, bool cold_boot);
 int sbi_pmp_ipi_request(ulong hmask, ulong hbase, struct sbi_pmp_ipi_info* info);
 
 void send_and_sync_pmp_ipi(int region_idx, int type, uint8_t perm);
+
+/* Queue the global PMP updates of this hart until the matching flush, which
+ * applies all of them on every hart with a single IPI round */
+void pmp_ipi_batch_begin(void);
+void pmp_ipi_batch_flush(void);
+
+/* Helper IPIs borrow the other harts for SM work, e.g. hashing. The sender
+ * does not wait for them, so fn must cope with running late or not at all */
+typedef void (*sm_helper_fn)(void);
+
+int sm_helper_ipi_init(void);
+void sm_helper_ipi_send(sm_helper_fn fn);
 #endif
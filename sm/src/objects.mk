@@ -4,12 +4,12 @@
 
 # General headers
 keystone-sm-headers += sm_assert.h cpu.h enclave.h ipi.h mprv.h page.h platform-hook.h \
-                        pmp.h safe_math_util.h sm.h sm-sbi.h sm-sbi-opensbi.h thread.h
+                        pmp.h safe_math_util.h sm.h sm-sbi.h sm-sbi-opensbi.h thread.h trace.h
 
 # Crypto headers
 ifneq ($(KEYSTONE_SM_NO_CRYPTO),y)
 keystone-sm-headers += crypto.h ed25519/ed25519.h ed25519/fe.h ed25519/fixedint.h \
-                        ed25519/ge.h ed25519/precomp_data.h ed25519/sc.h \
+                        ed25519/ge.h ed25519/precomp_data.h ed25519/precomp_data51.h ed25519/sc.h \
                         hkdf_sha3_512/hkdf_sha3_512.h hmac_sha3/hmac_sha3.h \
                         sha3/sha3.h
 endif
@@ -35,11 +35,12 @@ keystone-sm-headers += plugins/multimem.h plugins/plugins.h
 
 # Core files
 keystone-sm-sources += attest.c cpu.c enclave.c pmp.c sm.c sm-sbi.c sm-sbi-opensbi.c \
-                        thread.c mprv.c sbi_trap_hack.c trap.c ipi.c
+                        thread.c mprv.c sbi_trap_hack.c trap.c ipi.c trace.c
 
 # Crypto
 ifneq ($(KEYSTONE_SM_NO_CRYPTO),y)
-keystone-sm-sources += crypto.c sha3/sha3.c ed25519/fe.c ed25519/ge.c ed25519/keypair.c \
+keystone-sm-sources += crypto.c sha3/sha3.c ed25519/fe.c ed25519/fe51.c ed25519/ge.c ed25519/keypair.c \
+                        ed25519/key_exchange.c \
                         ed25519/sc.c ed25519/sign.c hkdf_sha3_512/hkdf_sha3_512.c \
                         hmac_sha3/hmac_sha3.c
 endif
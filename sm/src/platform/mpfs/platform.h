@@ -8,7 +8,7 @@ struct platform_enclave_data{
 };
 
 // Enclave configuration
-#define ENCL_MAX                16
+#define ENCL_MAX                64
 #define ENCLAVE_REGIONS_MAX     8
 
 // SM configuration
@@ -9,6 +9,7 @@
 #include "sm-sbi-opensbi.h"
 #include "page.h"
 #include "ipi.h"
+#include "trace.h"
 #include <sbi/sbi_hart.h>
 #include <sbi/riscv_asm.h>
 #include <sbi/riscv_locks.h>
@@ -205,6 +206,7 @@ int pmp_unset_global(int region_idx)
   if(!is_pmp_region_valid(region_idx))
     PMP_ERROR(SBI_ERR_SM_PMP_REGION_INVALID, "Invalid PMP region index");
 
+  sm_trace(SM_TRACE_PMP_UNSET, SM_TRACE_NO_EID, region_idx);
   send_and_sync_pmp_ipi(region_idx, SBI_PMP_IPI_TYPE_UNSET, PMP_NO_PERM);
 
   return SBI_ERR_SM_PMP_SUCCESS;
@@ -216,6 +218,7 @@ int pmp_set_global(int region_idx, uint8_t perm)
   if(!is_pmp_region_valid(region_idx))
     PMP_ERROR(SBI_ERR_SM_PMP_REGION_INVALID, "Invalid PMP region index");
 
+  sm_trace(SM_TRACE_PMP_SET, SM_TRACE_NO_EID, ((uint64_t) region_idx << 8) | perm);
   send_and_sync_pmp_ipi(region_idx, SBI_PMP_IPI_TYPE_SET, perm);
 
   return SBI_ERR_SM_PMP_SUCCESS;
@@ -48,6 +48,15 @@ static int sbi_ecall_keystone_enclave_handler(unsigned long extid, unsigned long
       retval = sbi_sm_resume_enclave((struct sbi_trap_regs*) regs, regs->a0);
       __builtin_unreachable();
       break;
+    case SBI_SM_GET_STATS:
+      retval = sbi_sm_get_stats(regs->a0, regs->a1, regs->a2);
+      break;
+    case SBI_SM_DRAIN_TRACE:
+      retval = sbi_sm_drain_trace(regs->a0, regs->a1, regs->a2, out_val);
+      break;
+    case SBI_SM_CLONE_ENCLAVE:
+      retval = sbi_sm_clone_enclave(out_val, regs->a0, regs->a1);
+      break;
     case SBI_SM_RANDOM:
       *out_val = sbi_sm_random();
       retval = 0;
@@ -55,6 +64,9 @@ static int sbi_ecall_keystone_enclave_handler(unsigned long extid, unsigned long
     case SBI_SM_ATTEST_ENCLAVE:
       retval = sbi_sm_attest_enclave(regs->a0, regs->a1, regs->a2, regs->a3, regs->a4);
       break;
+    case SBI_SM_ATTEST_MAC:
+      retval = sbi_sm_attest_enclave_mac(regs->a0, regs->a1, regs->a2, regs->a3);
+      break;
     case SBI_SM_GET_SEALING_KEY:
       retval = sbi_sm_get_sealing_key(regs->a0, regs->a1, regs->a2);
       break;
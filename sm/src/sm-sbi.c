@@ -8,6 +8,7 @@
 #include "page.h"
 #include "cpu.h"
 #include "platform-hook.h"
+#include "trace.h"
 #include "plugins/plugins.h"
 #include <sbi/riscv_asm.h>
 #include <sbi/sbi_console.h>
@@ -27,6 +28,20 @@ unsigned long sbi_sm_create_enclave(unsigned long* eid, uintptr_t create_args)
   return ret;
 }
 
+unsigned long sbi_sm_clone_enclave(unsigned long* eid, unsigned long src_eid, uintptr_t create_args)
+{
+  struct keystone_sbi_create_t create_args_local;
+  unsigned long ret;
+
+  ret = copy_enclave_create_args(create_args, &create_args_local);
+
+  if (ret)
+    return ret;
+
+  ret = clone_enclave(eid, (unsigned int) src_eid, create_args_local);
+  return ret;
+}
+
 unsigned long sbi_sm_destroy_enclave(unsigned long eid)
 {
   unsigned long ret;
@@ -54,6 +69,23 @@ unsigned long sbi_sm_resume_enclave(struct sbi_trap_regs *regs, unsigned long ei
   return 0;
 }
 
+unsigned long sbi_sm_get_stats(unsigned long type, unsigned long id, uintptr_t stats)
+{
+  switch (type) {
+    case SM_STATS_ENCLAVE:
+      return get_enclave_stats((unsigned int) id, stats);
+    case SM_STATS_HART:
+      return cpu_copy_stats(id, stats);
+    default:
+      return SBI_ERR_SM_ENCLAVE_ILLEGAL_ARGUMENT;
+  }
+}
+
+unsigned long sbi_sm_drain_trace(unsigned long hartid, uintptr_t events, unsigned long max, unsigned long* count)
+{
+  return sm_trace_drain(hartid, events, max, count);
+}
+
 unsigned long sbi_sm_exit_enclave(struct sbi_trap_regs *regs, unsigned long retval)
 {
   regs->a0 = exit_enclave(regs, cpu_get_enclave_id());
@@ -78,6 +110,13 @@ unsigned long sbi_sm_attest_enclave(uintptr_t report, uintptr_t data, uintptr_t
   return ret;
 }
 
+unsigned long sbi_sm_attest_enclave_mac(uintptr_t tag, uintptr_t data, uintptr_t size, uintptr_t peer_public_key)
+{
+  unsigned long ret;
+  ret = attest_enclave_mac(tag, data, size, peer_public_key, cpu_get_enclave_id());
+  return ret;
+}
+
 unsigned long sbi_sm_get_sealing_key(uintptr_t sealing_key, uintptr_t key_ident,
                        size_t key_ident_size)
 {
@@ -11,6 +11,9 @@
 unsigned long
 sbi_sm_create_enclave(unsigned long *out_val, uintptr_t create_args);
 
+unsigned long
+sbi_sm_clone_enclave(unsigned long *out_val, unsigned long src_eid, uintptr_t create_args);
+
 unsigned long
 sbi_sm_destroy_enclave(unsigned long eid);
 
@@ -26,9 +29,18 @@ sbi_sm_stop_enclave(struct sbi_trap_regs *regs, unsigned long request);
 unsigned long
 sbi_sm_resume_enclave(struct sbi_trap_regs *regs, unsigned long eid);
 
+unsigned long
+sbi_sm_get_stats(unsigned long type, unsigned long id, uintptr_t stats);
+
+unsigned long
+sbi_sm_drain_trace(unsigned long hartid, uintptr_t events, unsigned long max, unsigned long* count);
+
 unsigned long
 sbi_sm_attest_enclave(uintptr_t report, uintptr_t data, uintptr_t size, uintptr_t log_ptr, uintptr_t log_size);
 
+unsigned long
+sbi_sm_attest_enclave_mac(uintptr_t tag, uintptr_t data, uintptr_t size, uintptr_t peer_public_key);
+
 unsigned long
 sbi_sm_get_sealing_key(uintptr_t seal_key, uintptr_t key_ident, size_t key_ident_size);
 
@@ -80,6 +80,26 @@ int sm_derive_sealing_key(unsigned char *key, const unsigned char *key_ident,
              info, MDSIZE + key_ident_size, key, SEALING_KEY_SIZE);
 }
 
+/* The key only this SM and the owner of peer_public_key can compute for an
+ * enclave; see attest_enclave_mac() */
+void sm_derive_attestation_key(unsigned char *key,
+                               const unsigned char *peer_public_key,
+                               const unsigned char *enclave_hash)
+{
+  unsigned char shared[PUBLIC_KEY_SIZE];
+  hash_ctx ctx;
+
+  key_exchange(shared, peer_public_key, sm_private_key);
+
+  hash_init(&ctx);
+  hash_extend(&ctx, ATTEST_MAC_KEY_LABEL, sizeof(ATTEST_MAC_KEY_LABEL) - 1);
+  hash_extend(&ctx, shared, sizeof(shared));
+  hash_extend(&ctx, enclave_hash, MDSIZE);
+  hash_finalize(key, &ctx);
+
+  sbi_memset(shared, 0, sizeof(shared));
+}
+
 static void sm_print_hash(void)
 {
   for (int i=0; i<MDSIZE; i++)
@@ -146,6 +166,10 @@ void sm_init(bool cold_boot)
     // Init the enclave metadata
     enclave_init_metadata();
 
+    // Other harts may help hashing large enclaves, see attest.c
+    if (sm_helper_ipi_init())
+      sbi_printf("[SM] no helper IPI, measuring on a single hart\n");
+
     sm_init_done = 1;
     mb();
   }
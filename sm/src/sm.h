@@ -23,6 +23,9 @@ int sm_derive_sealing_key(unsigned char *key,
                           const unsigned char *key_ident,
                           size_t key_ident_size,
                           const unsigned char *enclave_hash);
+void sm_derive_attestation_key(unsigned char *key,
+                               const unsigned char *peer_public_key,
+                               const unsigned char *enclave_hash);
 
 int osm_pmp_set(uint8_t perm);
 #endif
@@ -0,0 +1,79 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#include "trace.h"
+#include "mprv.h"
+#include <sbi/riscv_asm.h>
+#include <sbi/riscv_locks.h>
+#include <sbi/sbi_timer.h>
+
+#ifndef TARGET_PLATFORM_HEADER
+#error "SM requires a defined platform to build"
+#endif
+
+// Special target platform header, set by configure script
+#include TARGET_PLATFORM_HEADER
+
+#if (SM_TRACE_ENTRIES & (SM_TRACE_ENTRIES - 1))
+#error "SM_TRACE_ENTRIES must be a power of two"
+#endif
+
+struct trace_ring
+{
+  /* only contended when the host drains this hart's ring */
+  spinlock_t lock;
+  /* free-running indices, masked on access */
+  unsigned long head;
+  unsigned long tail;
+  struct sm_trace_event events[SM_TRACE_ENTRIES];
+};
+
+static struct trace_ring rings[MAX_HARTS];
+
+void sm_trace(uint32_t type, uint32_t eid, uint64_t arg)
+{
+  struct trace_ring* ring = &rings[csr_read(mhartid)];
+  struct sm_trace_event* ev;
+
+  spin_lock(&ring->lock);
+  ev = &ring->events[ring->head & (SM_TRACE_ENTRIES - 1)];
+  ev->time = sbi_timer_value();
+  ev->type = type;
+  ev->eid = eid;
+  ev->arg = arg;
+  ring->head++;
+  if (ring->head - ring->tail > SM_TRACE_ENTRIES)
+    ring->tail = ring->head - SM_TRACE_ENTRIES;
+  spin_unlock(&ring->lock);
+}
+
+/* Moves up to max events of a hart out to the caller (S-mode address).
+ * The number of events copied is returned through count. */
+unsigned long sm_trace_drain(unsigned long hartid, uintptr_t dest,
+                             unsigned long max, unsigned long* count)
+{
+  struct trace_ring* ring;
+  struct sm_trace_event ev;
+  unsigned long n = 0;
+
+  if (hartid >= MAX_HARTS)
+    return SBI_ERR_SM_ENCLAVE_ILLEGAL_ARGUMENT;
+
+  ring = &rings[hartid];
+
+  spin_lock(&ring->lock);
+  while (n < max && ring->tail != ring->head) {
+    ev = ring->events[ring->tail & (SM_TRACE_ENTRIES - 1)];
+    if (copy_from_sm(dest + n * sizeof(ev), &ev, sizeof(ev))) {
+      spin_unlock(&ring->lock);
+      return SBI_ERR_SM_ENCLAVE_ILLEGAL_ARGUMENT;
+    }
+    ring->tail++;
+    n++;
+  }
+  spin_unlock(&ring->lock);
+
+  *count = n;
+  return SBI_ERR_SM_ENCLAVE_SUCCESS;
+}
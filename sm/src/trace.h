@@ -0,0 +1,21 @@
+//******************************************************************************
+// Copyright (c) 2018, The Regents of the University of California (Regents).
+// All Rights Reserved. See LICENSE for license details.
+//------------------------------------------------------------------------------
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include "sm.h"
+
+/* Per-hart binary trace ring. Events are recorded into SM memory without
+ * touching the console, and drained by the host via SBI_SM_DRAIN_TRACE.
+ * When a ring is full the oldest events are overwritten. */
+#ifndef SM_TRACE_ENTRIES
+#define SM_TRACE_ENTRIES 256
+#endif
+
+void sm_trace(uint32_t type, uint32_t eid, uint64_t arg);
+unsigned long sm_trace_drain(unsigned long hartid, uintptr_t dest,
+                             unsigned long max, unsigned long* count);
+
+#endif
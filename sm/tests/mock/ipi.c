@@ -4,3 +4,23 @@ void __wrap_send_and_sync_pmp_ipi(int region_idx, int type, uint8_t perm)
 {
   return;
 }
+
+void __wrap_pmp_ipi_batch_begin(void)
+{
+  return;
+}
+
+void __wrap_pmp_ipi_batch_flush(void)
+{
+  return;
+}
+
+int __wrap_sm_helper_ipi_init(void)
+{
+  return 0;
+}
+
+void __wrap_sm_helper_ipi_send(void (*fn)(void))
+{
+  return;
+}
@@ -22,6 +22,11 @@ void __wrap_sbi_hart_hang(uint16_t code)
   mock_assert(0, "poweroff", __FILE__, __LINE__);
 }
 
+uint64_t __wrap_sbi_timer_value(void)
+{
+  return 0;
+}
+
 void __wrap_spin_lock(spinlock_t* lock)
 {
   return;
@@ -62,6 +67,18 @@ void* __wrap_sbi_memset(void *s, int c, size_t count)
   return s;
 }
 
+int __wrap_sbi_memcmp(const void *s1, const void *s2, size_t count)
+{
+  const unsigned char *temp1 = s1, *temp2 = s2;
+
+  for (; count > 0; count--, temp1++, temp2++) {
+    if (*temp1 != *temp2)
+      return *temp1 - *temp2;
+  }
+
+  return 0;
+}
+
 void __wrap_trap_vector_enclave(){
   return;
 }
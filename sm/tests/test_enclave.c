@@ -22,6 +22,7 @@ static void test_is_create_args_valid()
   args.runtime_paddr = 0x4000;
   args.user_paddr = 0x5000;
   args.free_paddr = 0x6000;
+  args.measure_flags = 0;
   assert_int_equal(is_create_args_valid(&args), 1);
 
   // true even if epm and utm overlap
@@ -65,6 +66,15 @@ static void test_is_create_args_valid()
   assert_int_equal(is_create_args_valid(&args), 0);
   args.free_paddr = 0x6000;
 
+  // measurement format is checked
+  args.measure_flags = SM_MEASURE_TREE;
+  assert_int_equal(is_create_args_valid(&args), 1);
+  args.measure_flags = SM_MEASURE_TREE | SM_MEASURE_SPARSE;
+  assert_int_equal(is_create_args_valid(&args), 1);
+  args.measure_flags = 0x80;
+  assert_int_equal(is_create_args_valid(&args), 0);
+  args.measure_flags = 0;
+
   // false if epm overflows
   args.epm_region.size = -1UL;
   assert_int_equal(is_create_args_valid(&args), 0);
@@ -121,6 +131,91 @@ static void test_get_enclave_region_index()
   assert_int_equal( get_enclave_region_index(0, REGION_OTHER), 2 );
 }
 
+static void test_encl_alloc_eid()
+{
+  enclave_id eid;
+
+  enclave_init_metadata();
+
+  // allocates in increasing order
+  assert_int_equal( encl_alloc_eid(&eid), SBI_ERR_SM_ENCLAVE_SUCCESS );
+  assert_int_equal( eid, 0 );
+  assert_int_equal( enclaves[0].state, ALLOCATED );
+  assert_int_equal( encl_alloc_eid(&eid), SBI_ERR_SM_ENCLAVE_SUCCESS );
+  assert_int_equal( eid, 1 );
+
+  // a freed eid is reused first
+  encl_free_eid(0);
+  assert_int_equal( enclaves[0].state, INVALID );
+  assert_int_equal( encl_alloc_eid(&eid), SBI_ERR_SM_ENCLAVE_SUCCESS );
+  assert_int_equal( eid, 0 );
+
+  // exhaust the table
+  while (encl_alloc_eid(&eid) == SBI_ERR_SM_ENCLAVE_SUCCESS);
+  assert_int_equal( eid, ENCL_MAX - 1 );
+  assert_int_equal( encl_alloc_eid(&eid), SBI_ERR_SM_ENCLAVE_NO_FREE_RESOURCE );
+
+  encl_free_eid(ENCL_MAX - 1);
+  assert_int_equal( encl_alloc_eid(&eid), SBI_ERR_SM_ENCLAVE_SUCCESS );
+  assert_int_equal( eid, ENCL_MAX - 1 );
+}
+
+static void test_is_enclave_cloneable()
+{
+  enclave_id eid;
+
+  enclave_init_metadata();
+
+  assert_int_equal( encl_alloc_eid(&eid), SBI_ERR_SM_ENCLAVE_SUCCESS );
+  assert_false( is_enclave_cloneable(eid) );
+
+  enclaves[eid].state = FRESH;
+  assert_true( is_enclave_cloneable(eid) );
+
+  // connections are part of the measurement history
+  enclaves[eid].connector[0].valid = TRUE;
+  assert_false( is_enclave_cloneable(eid) );
+  enclaves[eid].connector[0].valid = FALSE;
+  enclaves[eid].regions_shared[2] = 1;
+  assert_false( is_enclave_cloneable(eid) );
+  enclaves[eid].regions_shared[2] = 0;
+
+  enclaves[eid].state = RUNNING;
+  assert_false( is_enclave_cloneable(eid) );
+
+  assert_false( is_enclave_cloneable(ENCL_MAX) );
+}
+
+static void test_get_enclave_stats()
+{
+  enclave_id eid;
+  struct sm_stats stats;
+
+  enclave_init_metadata();
+
+  assert_int_equal( encl_alloc_eid(&eid), SBI_ERR_SM_ENCLAVE_SUCCESS );
+  sbi_memset(&enclaves[eid].stats, 0, sizeof(struct sm_stats));
+  enclaves[eid].stats.run = 1;
+  enclaves[eid].stats.stop_edge_call = 3;
+  enclaves[eid].stats.sign_cycles = 1000;
+
+  // the counters of the enclave are copied out as they are
+  sbi_memset(&stats, 0xff, sizeof(stats));
+  assert_int_equal( get_enclave_stats(eid, (uintptr_t)&stats),
+                    SBI_ERR_SM_ENCLAVE_SUCCESS );
+  assert_int_equal( stats.run, 1 );
+  assert_int_equal( stats.resume, 0 );
+  assert_int_equal( stats.stop_edge_call, 3 );
+  assert_int_equal( stats.sign_cycles, 1000 );
+
+  // unallocated and out of range eids are rejected
+  encl_free_eid(eid);
+  assert_int_equal( get_enclave_stats(eid, (uintptr_t)&stats),
+                    SBI_ERR_SM_ENCLAVE_INVALID_ID );
+  assert_int_equal( get_enclave_stats(ENCL_MAX, (uintptr_t)&stats),
+                    SBI_ERR_SM_ENCLAVE_INVALID_ID );
+}
+
 int main()
 {
   const struct CMUnitTest tests[] = {
@@ -128,6 +223,9 @@ int main()
     cmocka_unit_test(test_context_switch_to_enclave),
     cmocka_unit_test(test_get_enclave_region_after_init),
     cmocka_unit_test(test_get_enclave_region_index),
+    cmocka_unit_test(test_encl_alloc_eid),
+    cmocka_unit_test(test_is_enclave_cloneable),
+    cmocka_unit_test(test_get_enclave_stats),
   };
 
   return cmocka_run_group_tests(tests, NULL, NULL);
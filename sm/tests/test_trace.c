@@ -0,0 +1,96 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+/* the tests run in user mode, record everything to the ring of hart 0 */
+#include <sbi/riscv_asm.h>
+#undef csr_read
+#define csr_read(csr) 0UL
+
+#include "../src/trace.c"
+
+static struct sm_trace_event events[SM_TRACE_ENTRIES + 8];
+
+static void reset_rings()
+{
+  memset(rings, 0, sizeof(rings));
+}
+
+static void test_trace_drain_in_order()
+{
+  unsigned long count;
+
+  reset_rings();
+
+  // nothing recorded yet
+  assert_int_equal( sm_trace_drain(0, (uintptr_t)events, 8, &count),
+                    SBI_ERR_SM_ENCLAVE_SUCCESS );
+  assert_int_equal( count, 0 );
+
+  sm_trace(SM_TRACE_CREATE, 1, 0x1000);
+  sm_trace(SM_TRACE_RUN, 1, 0);
+  sm_trace(SM_TRACE_EXIT, 1, 42);
+
+  // a short drain leaves the rest in the ring
+  assert_int_equal( sm_trace_drain(0, (uintptr_t)events, 2, &count),
+                    SBI_ERR_SM_ENCLAVE_SUCCESS );
+  assert_int_equal( count, 2 );
+  assert_int_equal( events[0].type, SM_TRACE_CREATE );
+  assert_int_equal( events[0].eid, 1 );
+  assert_int_equal( events[0].arg, 0x1000 );
+  assert_int_equal( events[1].type, SM_TRACE_RUN );
+
+  assert_int_equal( sm_trace_drain(0, (uintptr_t)events, 8, &count),
+                    SBI_ERR_SM_ENCLAVE_SUCCESS );
+  assert_int_equal( count, 1 );
+  assert_int_equal( events[0].type, SM_TRACE_EXIT );
+  assert_int_equal( events[0].arg, 42 );
+
+  // drained events are gone
+  assert_int_equal( sm_trace_drain(0, (uintptr_t)events, 8, &count),
+                    SBI_ERR_SM_ENCLAVE_SUCCESS );
+  assert_int_equal( count, 0 );
+}
+
+static void test_trace_overwrites_oldest()
+{
+  unsigned long count, i;
+
+  reset_rings();
+
+  for (i = 0; i < SM_TRACE_ENTRIES + 5; i++)
+    sm_trace(SM_TRACE_RUN, 0, i);
+
+  assert_int_equal( sm_trace_drain(0, (uintptr_t)events,
+                                   SM_TRACE_ENTRIES + 8, &count),
+                    SBI_ERR_SM_ENCLAVE_SUCCESS );
+  assert_int_equal( count, SM_TRACE_ENTRIES );
+  assert_int_equal( events[0].arg, 5 );
+  assert_int_equal( events[SM_TRACE_ENTRIES - 1].arg, SM_TRACE_ENTRIES + 4 );
+}
+
+static void test_trace_drain_invalid_hart()
+{
+  unsigned long count = 7;
+
+  assert_int_equal( sm_trace_drain(MAX_HARTS, (uintptr_t)events, 8, &count),
+                    SBI_ERR_SM_ENCLAVE_ILLEGAL_ARGUMENT );
+  assert_int_equal( count, 7 );
+}
+
+int main()
+{
+  const struct CMUnitTest tests[] = {
+    cmocka_unit_test(test_trace_drain_in_order),
+    cmocka_unit_test(test_trace_overwrites_oldest),
+    cmocka_unit_test(test_trace_drain_invalid_hart),
+  };
+
+  return cmocka_run_group_tests(tests, NULL, NULL);
+}